@@ -6,11 +6,25 @@
 //  Copyright © 2020 Mert Arıcan. All rights reserved.
 //
 
+#define _GNU_SOURCE // 'fopencookie'
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define VECTOR_KERNELS // SSE2 and AVX2 kernels, see 'DECODING FUNCTIONS' and 'COLUMNAR REGISTRATIONS'.
+#endif
 
 // MARK: - DATA TYPES
 
@@ -38,6 +52,7 @@ typedef struct {
     int credit;
     Quota quota;
     int instructorID;
+    int ID; // Only binary files have IDs of courses, see 'COURSE CODE DICTIONARY'.
 } Course;
 
 // Struct for student
@@ -149,7 +164,7 @@ Item wrapRegistrationWithStudentNumberAndCourseCode(int studentNumber, char *cou
 // Freeing memory allocated for an Item instance
 
 /* Sometimes, item instance created in function but not deallocated in same function.
- This function is used to clear memory used by those instances. */
+ This function is used to clear memory used by those instances. Items decoded in an arena are not freed with it, see 'ARENAS'. */
 
 void freeItem(Item item) {
     switch (item.type) {
@@ -169,6 +184,34 @@ void freeItem(Item item) {
     }
 }
 
+char *copyString(const char *string) {
+    if (string == NULL) { return NULL; }
+    char *copy = malloc(sizeof(char)*(strlen(string)+1));
+    if (copy == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'copyString' function.\n"); exit(1); }
+    strcpy(copy, string);
+    return copy;
+}
+
+Item copyItem(Item item) {
+    // Returns a copy of 'item' which owns its strings, it should be deallocated with 'freeItem'.
+    switch (item.type) {
+        case InstructorType:
+            item.value.instructor.name = copyString(item.value.instructor.name);
+            item.value.instructor.surname = copyString(item.value.instructor.surname);
+            item.value.instructor.title = copyString(item.value.instructor.title); break;
+        case CourseType:
+            item.value.course.code = copyString(item.value.course.code);
+            item.value.course.name = copyString(item.value.course.name); break;
+        case StudentType:
+            item.value.student.name = copyString(item.value.student.name);
+            item.value.student.surname = copyString(item.value.student.surname); break;
+        case RegistrationType:
+            item.value.registration.courseCode = copyString(item.value.registration.courseCode);
+            item.value.registration.date = copyString(item.value.registration.date); break;
+    }
+    return item;
+}
+
 // Convenience function for printing an Item
 
 void printItem(Item item) {
@@ -190,634 +233,5072 @@ void printItem(Item item) {
 
 // MARK: - CONVENIENCE FUNCTIONS
 
+// Storage format of the database files
+
+/* Records can be stored in two formats. 'TextFormat' is the original "Key: value" per line format, it is easy to
+ read by a human but every record has to be parsed line by line. 'BinaryFormat' stores every record as a fixed-width
+ block after a header which describes the version and the schema of the file, so record N is at offset
+ 'BINARY_HEADER_SIZE + N * recordSize' and decoding a record is just copying bytes. Text format stays as the default
+ one and as the export format of binary files. */
+
+typedef enum { TextFormat, BinaryFormat } StorageFormat;
+
+StorageFormat databaseFormat = TextFormat;
+
 // File names for records
 
-void getFileNameForType(ItemType type, char *fileName) {
+#define TRANSACTION_COPY_EXTENSION ".transaction"
+
+bool tableIsCopiedForTransaction[2][4]; // While a transaction is committed, its changes are made on copies of the files, see 'TRANSACTIONS'.
+
+void getFileNameForTypeInFormat(ItemType type, StorageFormat format, char *fileName) {
+    const char *extension = (format == BinaryFormat) ? "dat" : "txt";
     switch (type) {
-        case InstructorType: strcpy(fileName, "Instructors.txt"); return;
-        case CourseType: strcpy(fileName, "Courses.txt"); return;
-        case StudentType: strcpy(fileName, "Students.txt"); return;
-        case RegistrationType: strcpy(fileName, "Registrations.txt"); return;
+        case InstructorType: sprintf(fileName, "Instructors.%s", extension); break;
+        case CourseType: sprintf(fileName, "Courses.%s", extension); break;
+        case StudentType: sprintf(fileName, "Students.%s", extension); break;
+        case RegistrationType: sprintf(fileName, "Registrations.%s", extension); break;
     }
+    if (tableIsCopiedForTransaction[format][type]) { strcat(fileName, TRANSACTION_COPY_EXTENSION); }
+}
+
+void getFileNameForType(ItemType type, char *fileName) {
+    getFileNameForTypeInFormat(type, databaseFormat, fileName);
 }
 
-// Get record count of a file
+void getTableHeaderFileName(ItemType type, StorageFormat format, char *fileName) {
+    // Text files keep their header in a separate file, see 'TABLE HEADERS'.
+    // File names are kept in 255 byte buffers, the table's name is given the room left by the suffix.
+    char tableFileName[255 - sizeof(".header") + 1];
+    getFileNameForTypeInFormat(type, format, tableFileName);
+    snprintf(fileName, 255, "%s.header", tableFileName);
+}
 
-int getRecordCountOfAFile(ItemType type) {
+long getBinaryRecordCountOfAFile(ItemType type);
+int countLinesOfMappedFile(ItemType type);
+long countNewlinesOfStream(FILE *file);
+FILE *openTableStream(ItemType type);
+extern bool memoryMappedReads;
+extern bool indexedLookups;
+extern bool columnarRegistrations;
+const char *codeOfCourseID(int32_t ID);
+int32_t courseIDOfCode(const char *code);
+
+// Counts of the records of a file
+
+/* Every file keeps the number of its records, the number of its removed records and the next ID to be given to a
+ record, i.e. to a registration, in its header, see 'TABLE HEADERS'. So record counts are not calculated by reading
+ the whole file, they are calculated only once if header of the file is missing or stale. */
+
+typedef struct {
+    uint32_t isCounted; // Zero in a binary header written before the counts were kept.
+    uint32_t reserved;
+    int64_t liveCount;
+    int64_t tombstoneCount;
+    int64_t nextID;
+} TableCounts;
+
+TableCounts getTableCounts(ItemType type);
+
+int countRecordSlotsOfAFile(ItemType type) {
     /* Each item type has its own properties, like name and course code, and these properties are stored in
      a line in database files. So, if record type is InstructorType then number of properties it has is 4
      --ID, Name, Surname, Title--and each record occupies 5 line (1 extra because of empty line). So, if we
      divide Instructor records file's number of lines by 5 we get the number of records that are in database.
-     This also serves as unique ID creator for registrations. */
-    char *fileName = malloc(sizeof(char)*255);
-    if (fileName == NULL) { printf("Couldn't allocate memory in 'getRecordCountOfAFile'.\n"); exit(1); }
+     In binary format records have fixed width, so record count is calculated from the size of the file. Removed
+     records that are not compacted yet are also counted. Used when the header of the file is recounted. */
+    if (databaseFormat == BinaryFormat) { return (int)getBinaryRecordCountOfAFile(type); }
     int recordLength = (type == InstructorType) ? 5 : 6;
-    getFileNameForType(type, fileName);
-    if (fileName == NULL) {
-        printf("EXCEPTION: Couldn't allocate memory in 'getRecordCountOfAFile' function.\n"); exit(1);
-    }
-    FILE *file = fopen(fileName, "r");
-    int lineCount = 0; int c;
+    if (memoryMappedReads) { return countLinesOfMappedFile(type)/recordLength; }
+    FILE *file = openTableStream(type);
     if (file == NULL) { return 0; }
-    while ((c = getc(file)) != EOF) { if (c == '\n') { lineCount++; } }
-    fclose(file); free(fileName);
-    return lineCount/recordLength;
+    long lineCount = countNewlinesOfStream(file);
+    fclose(file);
+    return (int)(lineCount/recordLength);
 }
 
-// MARK: - DECODING FUNCTIONS
+int getRecordSlotCountOfAFile(ItemType type) {
+    // Number of the records in the file of 'type', removed records that are not compacted yet are also counted.
+    TableCounts counts = getTableCounts(type);
+    return (int)(counts.liveCount + counts.tombstoneCount);
+}
 
-// Those functions are used as a subroutine for creating instances from files.
+int getRecordCountOfAFile(ItemType type) {
+    // Number of the records in the file of 'type', removed records are not counted.
+    return (int)getTableCounts(type).liveCount;
+}
 
-Item readInstructorFromFile(FILE *instructorsFile) {
-    Instructor instructor;
-    instructor.name = malloc(sizeof(char)*255);
-    instructor.surname = malloc(sizeof(char)*255);
-    instructor.title = malloc(sizeof(char)*255);
-    char *buffer = malloc(sizeof(char)*255);
-    if (buffer == NULL || instructor.name == NULL || instructor.surname == NULL || instructor.title == NULL) {
-        printf("EXCEPTION: Couldn't allocate memory in 'readInstructorFromFile' function.\n"); exit(1);
-    }
-    fgets(buffer, 255, instructorsFile);
-    sscanf(buffer, "ID: %d\n", &instructor.ID);
-    fgets(buffer, 255, instructorsFile);
-    sscanf(buffer, "Name: %s\n", instructor.name);
-    fgets(buffer, 255, instructorsFile);
-    sscanf(buffer, "Surname: %s\n", instructor.surname);
-    fgets(buffer, 255, instructorsFile);
-    sscanf(buffer, "Title: %s\n", instructor.title);
-    fgets(buffer, 255, instructorsFile);
-    free(buffer);
-    return wrapInstructor(instructor);
+// MARK: - ARENAS
+
+/* Decoding a record used to allocate every string of it with 'malloc', and they were freed one by one with 'freeItem'.
+ But a scan decodes every record of a file only to look at it once, so records decoded by a scan are allocated from
+ an 'Arena' instead. An arena is a list of big blocks, memory is given from a block by moving its cursor forward, and
+ nothing is freed one by one. Whole arena is reset in one step after a record is visited, and its blocks are reused
+ for the next record, so a scan calls 'malloc' only for the first block of its arena, however many records it decodes.
+
+ Decoding functions allocate from 'decodingArena' if it is set, and with 'malloc' if it is not. Items allocated from
+ an arena are valid only until the arena is reset, so they are not freed with 'freeItem', and an item that is kept
+ longer is copied with 'copyItem'. Operations also take their scratch memory, i.e. error messages, from an arena,
+ and release all of it in one step. */
+
+#define ARENA_BLOCK_SIZE 8192
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t capacity;
+    size_t used;
+    unsigned char bytes[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *first;
+    ArenaBlock *current; // Blocks after 'current' are not used since the last reset.
+} Arena;
+
+#define EMPTY_ARENA { NULL, NULL }
+
+__thread Arena *decodingArena = NULL; // Every thread of 'ParallelRecordScanner' decodes into an arena of its own.
+
+void *allocateFromArena(Arena *arena, size_t size) {
+    // Returns 'size' bytes from the blocks of 'arena', a new block is added only if the unused blocks are too small.
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    ArenaBlock *block = arena->current;
+    while (block != NULL && block->used + size > block->capacity) {
+        block = block->next;
+        if (block != NULL) { block->used = 0; }
+    }
+    if (block == NULL) {
+        size_t capacity = (size > ARENA_BLOCK_SIZE) ? size : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + capacity);
+        if (block == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'allocateFromArena' function.\n"); exit(1); }
+        block->capacity = capacity; block->used = 0; block->next = NULL;
+        if (arena->current == NULL) { arena->first = block; }
+        else { block->next = arena->current->next; arena->current->next = block; }
+    }
+    arena->current = block;
+    void *memory = block->bytes + block->used;
+    block->used += size;
+    return memory;
 }
 
-Item readCourseFromFile(FILE *coursesFile) {
-    Course course;
-    char *buffer = malloc(sizeof(char)*255);
-    course.code = malloc(sizeof(char)*255);
-    course.name = malloc(sizeof(char)*255);
-    if (buffer == NULL || course.code == NULL || course.name == NULL) {
-        printf("EXCEPTION: Couldn't allocate memory in 'readCourseFromFile' function.\n"); exit(1);
-    }
-    fgets(buffer, 255, coursesFile);
-    sscanf(buffer, "Course code: %s\n", course.code);
-    fgets(buffer, 255, coursesFile);
-    sscanf(buffer, "Course name: %[^\n]\n", course.name);
-    fgets(buffer, 255, coursesFile);
-    sscanf(buffer, "Credit: %d\n", &course.credit);
-    fgets(buffer, 255, coursesFile);
-    sscanf(buffer, "Quota: %d/%d\n", &course.quota.registered, &course.quota.total);
-    fgets(buffer, 255, coursesFile);
-    sscanf(buffer, "Instructor ID: %d\n", &course.instructorID);
-    fgets(buffer, 255, coursesFile);
-    free(buffer);
-    return wrapCourse(course);
+void resetArena(Arena *arena) {
+    // Everything allocated from 'arena' becomes invalid, its blocks are kept for the next allocations.
+    arena->current = arena->first;
+    if (arena->first != NULL) { arena->first->used = 0; }
 }
 
-Item readStudentFromFile(FILE *studentsFile) {
-    Student student;
-    student.name = malloc(sizeof(char)*255);
-    student.surname = malloc(sizeof(char)*255);
-    char *buffer = malloc(sizeof(char)*255);
-    if (buffer == NULL || student.name == NULL || student.surname == NULL) {
-        printf("EXCEPTION: Couldn't allocate memory in 'readStudentFromFile' function.\n"); exit(1);
-    }
-    fgets(buffer, 255, studentsFile);
-    sscanf(buffer, "Student number: %d\n", &student.studentNumber);
-    fgets(buffer, 255, studentsFile);
-    sscanf(buffer, "Name: %[^\n]\n", student.name);
-    fgets(buffer, 255, studentsFile);
-    sscanf(buffer, "Surname: %[^\n]\n", student.surname);
-    fgets(buffer, 255, studentsFile);
-    sscanf(buffer, "Number of courses registered: %d\n", &student.numberOfCoursesRegistered);
-    fgets(buffer, 255, studentsFile);
-    sscanf(buffer, "Number of credits taken: %d\n", &student.numberOfCreditsTaken);
-    fgets(buffer, 255, studentsFile);
-    return wrapStudent(student);
+void releaseArena(Arena *arena) {
+    ArenaBlock *block = arena->first;
+    while (block != NULL) { ArenaBlock *next = block->next; free(block); block = next; }
+    arena->first = NULL; arena->current = NULL;
 }
 
-Item readRegistrationFromFile(FILE *registrationsFile) {
-    Registration registration;
-    registration.courseCode = malloc(sizeof(char)*255);
-    registration.date = malloc(sizeof(char)*20);
-    char *registrationStatus = malloc(sizeof(char) * 6);
-    char *buffer = malloc(sizeof(char)*255);
-    if (buffer == NULL || registration.courseCode == NULL || registration.date == NULL || registrationStatus == NULL) {
-        printf("EXCEPTION: Couldn't allocate memory in 'readRegistrationFromFile' function.\n"); exit(1);
-    }
-    fgets(buffer, 255, registrationsFile);
-    sscanf(buffer, "ID: %d\n", &registration.ID);
-    fgets(buffer, 255, registrationsFile);
-    sscanf(buffer, "Course code: %s\n", registration.courseCode);
-    fgets(buffer, 255, registrationsFile);
-    sscanf(buffer, "Student number: %d\n", &registration.studentNumber);
-    fgets(buffer, 255, registrationsFile);
-    sscanf(buffer, "Still registered: %s\n", registrationStatus);
-    fgets(buffer, 255, registrationsFile);
-    sscanf(buffer, "Registration date: %[^\n]\n", registration.date);
-    fgets(buffer, 255, registrationsFile);
-    registration.stillRegistered = (strcmp(registrationStatus, "False") == 0) ? false : true;
-    free(buffer); free(registrationStatus);
-    return wrapRegistration(registration);
+Arena *setDecodingArena(Arena *arena) {
+    // Decoding functions allocate from 'arena' until it is changed again, returns the arena that was used before.
+    Arena *previous = decodingArena;
+    decodingArena = arena;
+    return previous;
 }
 
-// MARK: - FUNCTION PROTOTYPES
+char *allocateDecodedString(size_t size, const char *functionName) {
+    if (decodingArena != NULL) { return allocateFromArena(decodingArena, size); }
+    char *string = malloc(size);
+    if (string == NULL) { printf("EXCEPTION: Couldn't allocate memory in '%s' function.\n", functionName); exit(1); }
+    return string;
+}
 
-void prepareForIteration(ItemType type, char *fileName, Item(**decodingFunction)(FILE*));
-bool conditionForQuery(Item decodedItem, Item queriedItem);
-OptionalItem ItemIterator(ItemType type, OptionalItem(*aimFunction)(Item, Item), Item aimItem);
-OptionalItem query(Item decodedItem, Item queriedItem);
-bool itemIsInDatabase(Item item);
-Item getItem(Item item);
-void removeCoursesGivenByInstructor(Item instructorItem);
-void invalidateRegistrationsAfterCourseOrStudentRemoval(Item student, int credit);
-void updateStudentsCreditStatus(int studentNumber, bool afterRegisteration, int credit, bool changeCourseCount);
-OptionalItem registrationCourseOrStudentRemoval(Item registration, Item courseOrStudent);
-OptionalItem courseInstructorRemoval(Item courseItem, Item instructor);
-void updateRegistrationsAfterCourseOrStudentsUniqueKeyHasChanged(Item courseOrStudentToRemove, Item updatedVersion);
-void updateStudentsCreditIfCoursesCreditHasChanged(int creditDifference, Item course);
-void updateCoursesAfterInstructorIDChange(Item instructorItem, Item updatedVersion);
-void updateItemBase(Item itemToBeUpdated, Item updatedVersion, bool printMessage);
-void updateItemSilently(Item itemToBeUpdated, Item updatedVersion);
-void updateItem(Item itemToBeUpdated, Item updatedVersion);
+// MARK: - KEY TABLES
 
-// MARK: - ADDING 'Item' TO THE DATABASE
+/* Operations that work on many records at once, i.e. bulk loading, keep the records they work on in memory and find
+ them by their integer keys, i.e. a student by its student number. 'KeyTable' maps a 64 bit key to the position of a
+ record in an array, it is an open addressing hash table with linear probing, which is doubled when it becomes half
+ full. Course codes are found with a 'CodeDictionary' instead, see 'COURSE CODE DICTIONARY'. */
 
-// MARK: Encoding functions
+typedef struct {
+    int64_t *keys;
+    int32_t *values; // -1 is an empty slot.
+    int slotCount;
+    int count;
+} KeyTable;
+
+uint32_t slotOfKey(const KeyTable *table, int64_t key) {
+    // Returns the slot of 'key', or the empty slot it would be put in.
+    uint32_t mask = (uint32_t)table->slotCount - 1;
+    uint32_t slot = (uint32_t)(((uint64_t)key * 0x9E3779B97F4A7C15ULL) >> 32) & mask; // Fibonacci hashing.
+    while (table->values[slot] >= 0 && table->keys[slot] != key) { slot = (slot + 1) & mask; }
+    return slot;
+}
 
-/* These functions are used as a subroutine for writing instances to a file in database.
- Adding Registration record to database is handled separately.
- If function's are called as a subroutine of UPDATE operation, then no message are printed
- if they get called as a subroutine of ADD operation, then message is printed. */
+int32_t findKey(const KeyTable *table, int64_t key) {
+    // Returns the value of 'key', or -1 if it is not in 'table'.
+    if (table->slotCount == 0) { return -1; }
+    return table->values[slotOfKey(table, key)];
+}
 
-void writeInstructorToAFile(Item instructorItem, FILE *instructorsFile, bool forUpdate) {
-    Instructor instructor = instructorItem.value.instructor;
-    fprintf(instructorsFile, "ID: %d\n", instructor.ID);
-    fprintf(instructorsFile, "Name: %s\n", instructor.name);
-    fprintf(instructorsFile, "Surname: %s\n", instructor.surname);
-    fprintf(instructorsFile, "Title: %s\n\n", instructor.title);
-    if (!forUpdate) {
-        printf("Added the instructor '%s %s %s' with ID: %d.\n", instructor.title, instructor.name, instructor.surname, instructor.ID);
+void insertKey(KeyTable *table, int64_t key, int32_t value) {
+    // Sets the value of 'key', 'value' should not be negative.
+    if (2*(table->count + 1) > table->slotCount) {
+        KeyTable grown; grown.count = 0;
+        grown.slotCount = (table->slotCount == 0) ? 64 : 2*table->slotCount;
+        grown.keys = malloc(grown.slotCount*sizeof(int64_t)); grown.values = malloc(grown.slotCount*sizeof(int32_t));
+        if (grown.keys == NULL || grown.values == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'insertKey' function.\n"); exit(1); }
+        for (int i = 0; i < grown.slotCount; i++) { grown.values[i] = -1; }
+        for (int i = 0; i < table->slotCount; i++) {
+            if (table->values[i] >= 0) { uint32_t slot = slotOfKey(&grown, table->keys[i]); grown.keys[slot] = table->keys[i]; grown.values[slot] = table->values[i]; grown.count++; }
+        }
+        free(table->keys); free(table->values);
+        *table = grown;
     }
-    fclose(instructorsFile);
+    uint32_t slot = slotOfKey(table, key);
+    if (table->values[slot] < 0) { table->count++; }
+    table->keys[slot] = key; table->values[slot] = value;
 }
 
-void writeCourseToAFile(Item courseItem, FILE *coursesFile, bool forUpdate) {
-    Course course = courseItem.value.course;
-    fprintf(coursesFile, "Course code: %s\n", course.code);
-    fprintf(coursesFile, "Course name: %s\n", course.name);
-    fprintf(coursesFile, "Credit: %d\n", course.credit);
-    fprintf(coursesFile, "Quota: %d/%d\n", course.quota.registered, course.quota.total);
-    fprintf(coursesFile, "Instructor ID: %d\n\n", course.instructorID);
-    if (!forUpdate) {
-        printf("Added the course '%s %s'.\n", course.code, course.name);
+void freeKeyTable(KeyTable *table) {
+    free(table->keys); free(table->values);
+    memset(table, 0, sizeof(KeyTable));
+}
+
+// MARK: - DECODING FUNCTIONS
+
+/* Those functions are used as a subroutine for creating instances from files.
+ 
+ Text records are parsed by hand instead of with 'sscanf'. A record is split into its lines, the key of every line
+ is matched with 'memcmp' against the fixed prefix of its field, i.e. "Credit:", and integers are converted with
+ 'parseTextInteger'. New lines are found with 'findNewline', which compares 32 or 16 bytes at once with AVX2 or SSE2
+ instructions when the processor has them, and one byte at a time otherwise. When files are mapped, records are
+ parsed straight from the mapping, otherwise their lines are read from a stream with 'fgets' and parsed in the same
+ way. '--benchmark' compares the parser with 'sscanf'.
+ 
+ When a record is decoded in an arena, strings of a binary record are not copied, they are views into the bytes of
+ the record. So a scan that only compares the fields, i.e. with 'conditionForQuery', copies no strings, and a record
+ is copied with 'copyItem' only if it is kept. Bytes of a record decoded in an arena should stay valid until the
+ arena is reset, scanners hold the mapping or the buffer of the record while it is visited, and 'readItemAtOffset'
+ copies the record to the arena first. Decoded strings are never written to. Text is not terminated with zero bytes,
+ so strings of a text record are copied to the arena, once. Without an arena, every string field is copied to a
+ string allocated with 'malloc'. */
+
+// MARK: Finding new lines
+
+#define TEXT_CHUNK_SIZE 65536
+
+typedef enum { ScalarKernel, SSE2Kernel, AVX2Kernel } VectorKernel;
+
+VectorKernel vectorKernel = ScalarKernel;
+bool vectorKernelIsSelected = false;
+
+const char *findNewlineScalar(const char *cursor, const char *end) {
+    while (cursor < end && *cursor != '\n') { cursor++; }
+    return cursor;
+}
+
+size_t countNewlinesScalar(const char *cursor, const char *end) {
+    size_t count = 0;
+    for (; cursor < end; cursor++) { count += (*cursor == '\n'); }
+    return count;
+}
+
+#ifdef VECTOR_KERNELS
+
+const char *findNewlineSSE2(const char *cursor, const char *end) {
+    const __m128i newlines = _mm_set1_epi8('\n');
+    for (; end - cursor >= 16; cursor += 16) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)cursor), newlines));
+        if (mask != 0) { return cursor + __builtin_ctz(mask); }
     }
-    fclose(coursesFile);
+    return findNewlineScalar(cursor, end);
 }
 
-void writeStudentToAFile(Item studentItem, FILE *studentsFile, bool forUpdate) {
-    Student student = studentItem.value.student;
-    fprintf(studentsFile, "Student number: %d\n", student.studentNumber);
-    fprintf(studentsFile, "Name: %s\n", student.name);
-    fprintf(studentsFile, "Surname: %s\n", student.surname);
-    fprintf(studentsFile, "Number of courses registered: %d\n", student.numberOfCoursesRegistered);
-    fprintf(studentsFile, "Number of credits taken: %d\n\n", student.numberOfCreditsTaken);
-    if (!forUpdate) {
-        printf("Added the student '%s %s'.\n", student.name, student.surname);
+size_t countNewlinesSSE2(const char *cursor, const char *end) {
+    const __m128i newlines = _mm_set1_epi8('\n'); size_t count = 0;
+    for (; end - cursor >= 16; cursor += 16) {
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)cursor), newlines)));
     }
-    fclose(studentsFile);
+    return count + countNewlinesScalar(cursor, end);
 }
 
-// MARK: Add Item
+__attribute__((target("avx2"))) const char *findNewlineAVX2(const char *cursor, const char *end) {
+    const __m256i newlines = _mm256_set1_epi8('\n');
+    for (; end - cursor >= 32; cursor += 32) {
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)cursor), newlines));
+        if (mask != 0) { return cursor + __builtin_ctz(mask); }
+    }
+    return findNewlineSSE2(cursor, end);
+}
 
-void updateStudentsCreditStatus(int studentNumber, bool registerationAdded, int credit, bool changeCourseCount) {
-    // Helper function for updating students credit status. Assumes student is in database.
-    int count = (registerationAdded) ? 1 : -1; credit = (registerationAdded) ? credit : -credit;
-    Item studentToUpdate = getItem(wrapStudentWithStudentNumber(studentNumber));
-    Item updatedVersion = studentToUpdate;
-    if (changeCourseCount) {
-        updatedVersion.value.student.numberOfCoursesRegistered += count;
+__attribute__((target("avx2"))) size_t countNewlinesAVX2(const char *cursor, const char *end) {
+    const __m256i newlines = _mm256_set1_epi8('\n'); size_t count = 0;
+    for (; end - cursor >= 32; cursor += 32) {
+        count += __builtin_popcount((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)cursor), newlines)));
     }
-    updatedVersion.value.student.numberOfCreditsTaken += credit;
-    updateItemSilently(studentToUpdate, updatedVersion); freeItem(studentToUpdate);
+    return count + countNewlinesSSE2(cursor, end);
 }
 
-void updateCourseQuota(char *courseCode, bool studentAdded) {
-    // Updates the quota of the course. Assumes course is in database.
-    Item course = getItem(wrapCourseWithCode(courseCode));
-    course.value.course.quota.registered += (studentAdded) ? 1 : -1;
-    updateItemSilently(course, course); freeItem(course);
+#endif
+
+bool vectorKernelIsAvailable(VectorKernel kernel) {
+#ifdef VECTOR_KERNELS
+    __builtin_cpu_init();
+    return kernel != AVX2Kernel || __builtin_cpu_supports("avx2");
+#else
+    return kernel == ScalarKernel;
+#endif
 }
 
-void prepareForAppend(Item item, char *error, char *error2, char *fileName, void(**writeToAFileFunc)(Item, FILE*, bool)) {
-    /* Convenience function for adding an Item to the database. This function assigns error messages, file name and
-     appropriate encoding function, to pointers passed as parameters, according to the type of the 'item'.
-     Adding 'Registration' record is handled separately. */
-    getFileNameForType(item.type, fileName);
-    switch (item.type) {
-        case InstructorType:
-            sprintf(error, "ERROR: Couldn't add the instructor. There is already an instructor with the same ID: %d.\n", item.value.instructor.ID);
-            *writeToAFileFunc = &writeInstructorToAFile; return;
-        case CourseType:
-            sprintf(error, "ERROR: Couldn't add the course. There is already a course with the same course code: %s.\n", item.value.course.code);
-            sprintf(error2, "ERROR: Couldn't add the course. There is no instructor with the ID: %d.\n", item.value.course.instructorID);
-            *writeToAFileFunc = &writeCourseToAFile; return;
-        case StudentType:
-            sprintf(error, "ERROR: Couldn't add the student. There is already a student with the number: %d.\n", item.value.student.studentNumber);
-            *writeToAFileFunc = &writeStudentToAFile; return;
-        case RegistrationType: return; // Registrations handled separately.
+VectorKernel selectVectorKernel(void) {
+    // Widest kernel the processor supports is selected once, SSE2 is always there on x86-64.
+    if (!vectorKernelIsSelected) {
+        vectorKernel = vectorKernelIsAvailable(AVX2Kernel) ? AVX2Kernel : (vectorKernelIsAvailable(SSE2Kernel) ? SSE2Kernel : ScalarKernel);
+        vectorKernelIsSelected = true;
     }
+    return vectorKernel;
 }
 
-void addItemBase(Item item, bool forUpdate) {
-    /* This function adds 'item' to the database.
-     This function, first checks whether 'item' is already in database or not.
-     Also, if Item's type is 'CourseType', then function checks whether course's instructor
-     is in database or not. If all conditions are met, 'item' is added in database. */
-    char *error = malloc(sizeof(char)*511);
-    char *error2 = malloc(sizeof(char)*511);
-    char *fileName = malloc(sizeof(char)*255);
-    void (*writeToAFileFunc)(Item, FILE*, bool) = writeInstructorToAFile;
-    if (error == NULL || error2 == NULL || fileName == NULL) {
-        printf("EXCEPTION: Couldn't allocate memory in 'addItemBase' function.\n"); exit(1);
-    }
-    prepareForAppend(item, error, error2, fileName, &writeToAFileFunc);
-    if (itemIsInDatabase(item)) {
-        printf("%s", error); free(error); free(error2); free(fileName); return;
+const char *findNewlineWithKernel(VectorKernel kernel, const char *cursor, const char *end) {
+    // Returns the first new line character between 'cursor' and 'end', or 'end' if there is none.
+    switch (kernel) {
+#ifdef VECTOR_KERNELS
+        case AVX2Kernel: return findNewlineAVX2(cursor, end);
+        case SSE2Kernel: return findNewlineSSE2(cursor, end);
+#endif
+        default: return findNewlineScalar(cursor, end);
     }
-    else if (item.type == CourseType) {
-        if (!itemIsInDatabase(wrapInstructorWithID(item.value.course.instructorID))) { printf("%s", error2); return; }
+}
+
+size_t countNewlinesWithKernel(VectorKernel kernel, const char *cursor, const char *end) {
+    switch (kernel) {
+#ifdef VECTOR_KERNELS
+        case AVX2Kernel: return countNewlinesAVX2(cursor, end);
+        case SSE2Kernel: return countNewlinesSSE2(cursor, end);
+#endif
+        default: return countNewlinesScalar(cursor, end);
     }
-    FILE *file = fopen(fileName, "a");
-    if (file == NULL) {
-        printf("Couldn't open the file '%s' and %s.\n", fileName, error);
-        free(error); free(error2); free(fileName); return;
+}
+
+const char *findNewline(const char *cursor, const char *end) {
+    return findNewlineWithKernel(selectVectorKernel(), cursor, end);
+}
+
+size_t countNewlines(const char *cursor, const char *end) {
+    return countNewlinesWithKernel(selectVectorKernel(), cursor, end);
+}
+
+long countNewlinesOfStream(FILE *file) {
+    // Reads 'file' in big chunks and counts the new line characters in them, used when files are not mapped.
+    char chunk[TEXT_CHUNK_SIZE]; size_t length; long count = 0;
+    while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) { count += (long)countNewlines(chunk, chunk + length); }
+    return count;
+}
+
+// MARK: Parsing text records
+
+typedef struct {
+    const char *bytes;
+    size_t length; // New line character is not included.
+} TextLine;
+
+#define MAX_TEXT_RECORD_LINES 6
+#define TEXT_KEY(key) key, sizeof(key) - 1
+
+const char *splitTextLines(const char *cursor, const char *end, TextLine *lines, int lineCount) {
+    // Splits 'lineCount' lines that start at 'cursor' into 'lines', returns where the line after them starts.
+    for (int i = 0; i < lineCount; i++) {
+        const char *newline = findNewline(cursor, end);
+        lines[i].bytes = cursor; lines[i].length = newline - cursor;
+        cursor = (newline < end) ? newline + 1 : end;
     }
-    (*writeToAFileFunc)(item, file, forUpdate);
-    free(error); free(error2); free(fileName);
+    return cursor;
 }
 
-/* If 'addItemBase' function should print success message, then its 'forUpdate' parameter
- should be false, otherwise it should be true. Functions below are just convenience functions for calling
- 'addItemBase' function. */
+const char *parseTextInteger(const char *cursor, const char *end, int *value) {
+    // Converts the number at 'cursor' like "%d" of 'sscanf' does, returns where its digits end.
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t')) { cursor++; }
+    bool isNegative = cursor < end && *cursor == '-';
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) { cursor++; }
+    unsigned int number = 0;
+    for (; cursor < end && (unsigned int)(*cursor - '0') < 10; cursor++) { number = number*10 + (unsigned int)(*cursor - '0'); }
+    *value = isNegative ? (int)(0u - number) : (int)number;
+    return cursor;
+}
 
-void addItem(Item item) { addItemBase(item, false); }
-void addItemAsAPartOfUpdateProcess(Item item) { addItemBase(item, true); }
+const char *boundsOfTextValue(TextLine line, const char *key, size_t keyLength, bool isWord, const char **valueEnd) {
+    /* Returns where the value of the field in 'line' starts, and sets 'valueEnd' to where it ends. Value is empty if
+     'line' doesn't start with 'key'. If 'isWord' is true, value ends at the first whitespace like "%s" of 'sscanf',
+     otherwise it is the rest of the line like "%[^\n]". */
+    const char *end = line.bytes + line.length;
+    const char *value = (line.length >= keyLength && memcmp(line.bytes, key, keyLength) == 0) ? line.bytes + keyLength : end;
+    while (value < end && (*value == ' ' || *value == '\t')) { value++; }
+    const char *cursor = value;
+    if (isWord) { while (cursor < end && !isspace((unsigned char)*cursor)) { cursor++; } } else { cursor = end; }
+    *valueEnd = cursor;
+    return value;
+}
 
-// MARK: Registering student for a course
+int parseIntegerField(TextLine line, const char *key, size_t keyLength) {
+    const char *end; int value = 0;
+    const char *cursor = boundsOfTextValue(line, key, keyLength, false, &end);
+    parseTextInteger(cursor, end, &value);
+    return value;
+}
 
-void getDateForRegistration(char *date) {
-    // Helper function for adding date to 'Registration' record.
-    time_t t = time(NULL);
-    struct tm time = *localtime(&t);
-    sprintf(date, "%d-%02d-%02d %02d:%02d:%02d", time.tm_year + 1900, time.tm_mon + 1, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
+char *parseStringField(TextLine line, const char *key, size_t keyLength, bool isWord) {
+    // Copies the value of the field to a string allocated from the decoding arena, or with 'malloc'.
+    const char *end; const char *value = boundsOfTextValue(line, key, keyLength, isWord, &end);
+    char *string = allocateDecodedString(end - value + 1, "parseStringField");
+    memcpy(string, value, end - value); string[end - value] = '\0';
+    return string;
 }
 
-void registerStudentForCourseBase(char *courseCode, int studentNumber, int MAX_COUNT, int MAX_CREDIT, bool forUpdate) {
-    /* Registers student with given 'studentNumber', for the course with given 'courseCode'.
-     If course is not in database, or student is not in database, or student is already registered for more courses
-     than he/she should have registered, or student is already taken more credits than he/she should have taken, or student is
-     already registered for the same course then error is thrown and process failed. Otherwise, registration record is added to
-     the database, and student's status is updated. */
-    Course course = getItem(wrapCourseWithCode(courseCode)).value.course; bool shouldClearCourse = true;
-    Student student = getItem(wrapStudentWithStudentNumber(studentNumber)).value.student; bool shouldClearStudent = true;
-    Item registration = getItem(wrapRegistrationWithStudentNumberAndCourseCode(studentNumber, courseCode));
-    if (!itemIsInDatabase(wrapCourse(course))) {
-        shouldClearCourse = false;
-        printf("ERROR: Couldn't register for course. There is no course with code: %s.\n", course.code);
-    } else if (!itemIsInDatabase(wrapStudent(student))) {
-        shouldClearStudent = false;
-        printf("ERROR: Couldn't register for course. There is no student with student number: %d.\n", student.studentNumber);
-    } else if (student.numberOfCoursesRegistered >= MAX_COUNT) {
-        printf("ERROR: Couldn't register for course. '%s %s' is already registered in %d courses "
-               "which is the maximum number of courses a student can register on a quarter.\n", student.name, student.surname, student.numberOfCoursesRegistered);
-    } else if (student.numberOfCreditsTaken + course.credit > MAX_CREDIT) {
-        printf("ERROR: Couldn't register for course. Maximum number of credits exceeded. A student can \n"
-               "take maximum of %d credits in a quarter and '%s %s' takes %d credits already, and course \n"
-               "he/she wants to register for is %d credits worth.\n",
-               MAX_CREDIT, student.name, student.surname, student.numberOfCreditsTaken, course.credit);
-    } else if (course.quota.total - course.quota.registered == 0) {
-        printf("ERROR: Couldn't register for course, quota of course is exceeded.\n");
-    } else if (itemIsInDatabase(registration)) {
-        printf("ERROR: Couldn't register for course. %s %s already registered for %s %s.\n", student.name, student.surname, course.code, course.name); freeItem(registration);
-    } else {
-        FILE *registrationsFile = fopen("Registrations.txt", "a");
-        char *date = malloc(sizeof(char)*20);
-        if (date == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'registerStudentForCourseBase' function.\n"); exit(1); }
-        getDateForRegistration(date);
-        if (registrationsFile == NULL) { printf("ERROR. Couldn't register for course.\n"); return; }
-        fprintf(registrationsFile, "ID: %d\n", getRecordCountOfAFile(RegistrationType));
-        fprintf(registrationsFile, "Course code: %s\n", course.code);
-        fprintf(registrationsFile, "Student number: %d\n", student.studentNumber);
-        fprintf(registrationsFile, "Still registered: True \n");
-        fprintf(registrationsFile, "Registration date: %s\n\n", date);
-        fclose(registrationsFile); free(date);
-        if (!forUpdate) {
-            /* If we use this function as a part of UPDATE operation, then quota and credit shouldn't get updated
-             also no success message should get printed. */
-            updateStudentsCreditStatus(studentNumber, true, course.credit, true);
-            updateCourseQuota(courseCode, true);
-            printf("Successfully registered %s %s for the course %s %s\n", student.name, student.surname, course.code, course.name);
-        }
-    }
-    if (shouldClearCourse) { freeItem(wrapCourse(course)); }
-    if (shouldClearStudent) { freeItem(wrapStudent(student)); }
+Item parseInstructorLines(const TextLine *lines) {
+    Instructor instructor;
+    instructor.ID = parseIntegerField(lines[0], TEXT_KEY("ID:"));
+    instructor.name = parseStringField(lines[1], TEXT_KEY("Name:"), true);
+    instructor.surname = parseStringField(lines[2], TEXT_KEY("Surname:"), true);
+    instructor.title = parseStringField(lines[3], TEXT_KEY("Title:"), true);
+    return wrapInstructor(instructor);
 }
 
-/* If 'registerStudentForCourseBase' function should print success message, then its 'forUpdate' parameter
- should be false, otherwise it should be true. Functions below are just convenience functions for calling
- 'registerStudentForCourseBase' function. */
+Item parseCourseLines(const TextLine *lines) {
+    Course course; const char *end;
+    course.code = parseStringField(lines[0], TEXT_KEY("Course code:"), true);
+    course.name = parseStringField(lines[1], TEXT_KEY("Course name:"), false);
+    course.credit = parseIntegerField(lines[2], TEXT_KEY("Credit:"));
+    const char *cursor = boundsOfTextValue(lines[3], TEXT_KEY("Quota:"), false, &end);
+    cursor = parseTextInteger(cursor, end, &course.quota.registered);
+    course.quota.total = 0;
+    if (cursor < end && *cursor == '/') { parseTextInteger(cursor + 1, end, &course.quota.total); }
+    course.instructorID = parseIntegerField(lines[4], TEXT_KEY("Instructor ID:"));
+    course.ID = -1; // Text files don't have IDs of courses.
+    return wrapCourse(course);
+}
 
-void registerStudentForCourse(char *courseCode, int studentNumber, int MAX_COUNT, int MAX_CREDIT) {
-    registerStudentForCourseBase(courseCode, studentNumber, MAX_COUNT, MAX_CREDIT, false);
+Item parseStudentLines(const TextLine *lines) {
+    Student student;
+    student.studentNumber = parseIntegerField(lines[0], TEXT_KEY("Student number:"));
+    student.name = parseStringField(lines[1], TEXT_KEY("Name:"), false);
+    student.surname = parseStringField(lines[2], TEXT_KEY("Surname:"), false);
+    student.numberOfCoursesRegistered = parseIntegerField(lines[3], TEXT_KEY("Number of courses registered:"));
+    student.numberOfCreditsTaken = parseIntegerField(lines[4], TEXT_KEY("Number of credits taken:"));
+    return wrapStudent(student);
 }
 
-void registerStudentForCourseAsAPartOfUpdateProcess(char *courseCode, int studentNumber, int MAX_COUNT, int MAX_CREDIT) {
-    registerStudentForCourseBase(courseCode, studentNumber, MAX_COUNT, MAX_CREDIT, true);
+Item parseRegistrationLines(const TextLine *lines) {
+    Registration registration; const char *end;
+    registration.ID = parseIntegerField(lines[0], TEXT_KEY("ID:"));
+    registration.courseCode = parseStringField(lines[1], TEXT_KEY("Course code:"), true);
+    registration.studentNumber = parseIntegerField(lines[2], TEXT_KEY("Student number:"));
+    const char *status = boundsOfTextValue(lines[3], TEXT_KEY("Still registered:"), true, &end);
+    registration.stillRegistered = !(end - status == 5 && memcmp(status, "False", 5) == 0);
+    registration.date = parseStringField(lines[4], TEXT_KEY("Registration date:"), false);
+    return wrapRegistration(registration);
 }
 
-// MARK: - REMOVING 'Item' FROM DATABASE
+int getTextRecordLineCount(ItemType type) {
+    // Every property is on its own line and an empty line follows the record, see 'countRecordSlotsOfAFile'.
+    return (type == InstructorType) ? 5 : 6;
+}
 
-void prepareForRemoval(Item item, char *fileName, char *checkString, char *error, char *success, int *count) {
-    /* Convenience function for removing an Item from database. This function assigns error message, success message,
-     file name, and 'count' variable, to pointers passed as parameters, according to the type of the 'item'. */
-    getFileNameForType(item.type, fileName);
-    switch (item.type) {
-        case InstructorType:
-            sprintf(error, "ERROR: Couldn't remove the instructor. There is no instructor with the ID: %d.\n", item.value.instructor.ID) ;
-            sprintf(success, "Removed the instructor '%s %s %s' with ID: %d.\n",item.value.instructor.title,
-                    item.value.instructor.name, item.value.instructor.surname, item.value.instructor.ID);
-            sprintf(checkString, "ID: %d\n", item.value.instructor.ID); *count = 3; return;
-        case CourseType:
-            sprintf(error, "ERROR: Couldn't remove the course. There is no course with the course code: %s.\n", item.value.course.code) ;
-            sprintf(success, "Removed the course '%s %s'.\n", item.value.course.code, item.value.course.name);
-            sprintf(checkString, "Course code: %s\n", item.value.course.code); *count = 4; return;
-        case StudentType:
-            sprintf(error, "ERROR: Couldn't remove the student. There is no student with the student number: %d.\n", item.value.student.studentNumber) ;
-            sprintf(success, "Removed the student '%s %s'.\n", item.value.student.name, item.value.student.surname);
-            sprintf(checkString, "Student number: %d\n", item.value.student.studentNumber); *count = 4; return;
-        case RegistrationType:
-            sprintf(error, "ERROR: Couldn't remove the registration.\n") ;
-            sprintf(success, "Removed the registration.\n");
-            sprintf(checkString, "ID: %d\n", item.value.registration.ID); *count = 4; return;
+// MARK: Reading text records from streams
+
+bool readTextLinesFromFile(FILE *file, char buffers[][255], TextLine *lines, int lineCount) {
+    // Reads the lines of a record from 'file' with 'fgets' into 'buffers', returns false if 'file' is at its end.
+    bool hasRecord = true;
+    for (int i = 0; i < lineCount; i++) {
+        if (fgets(buffers[i], 255, file) == NULL) { buffers[i][0] = '\0'; hasRecord = hasRecord && i > 0; }
+        lines[i].bytes = buffers[i]; lines[i].length = strcspn(buffers[i], "\n");
     }
+    return hasRecord;
 }
 
-void removeItemBase(Item item, bool forUpdate) {
-    /* Removes the 'item' from the database, if it is in the database.
-     If item's type is 'RegistrationType', then when record found in database,
-     'Still registered: True ' expression changed with 'Still registered: False'.
-     If item's type is different than 'RegistrationType', then record totally removed from file.
-     Removal implemented like this:
-     - Create a new temporary file to write.
-     - Open the database file that holds records of instances of same type as item's type.
-     - Read records from database file and...
-     - If record is item's record, then don't write it to a new file.
-     - Else, copy record to this new temporary file.
-     - After process completed, remove the old database file, and rename the new temporary file to be the same as removed file's name. */
-    char *buffer = malloc(sizeof(char)*255);
-    char *fileName = malloc(sizeof(char)*255);
-    char *checkString = malloc(sizeof(char)*255);
-    char *error = malloc(sizeof(char)*511);
-    char *success = malloc(sizeof(char)*511);
-    int count = 0; int credit = -1;
-    
-    if (buffer == NULL || fileName == NULL || checkString == NULL || error == NULL || success == NULL) {
-        printf("EXCEPTION: Couldn't allocate memory in 'removeItemBase' function.\n"); exit(1);
-    }
-    
-    item = getItem(item); // 'item' might be an artificial instance, so we have to get the rest of the information about 'item'.
-    
-    prepareForRemoval(item, fileName, checkString, error, success, &count);
-    
-    if (!itemIsInDatabase(item)) { printf("%s\n", error); return; }
-    
-    if (item.type == RegistrationType) {
-        // If item's type is RegistrationType, then overwrite "False" on "True "
-        FILE *registrationsFile = fopen(fileName, "r+");
-        if (registrationsFile == NULL) {
-            printf("ERROR: Couldn't open 'Registrations.txt'.\n");
-            free(buffer); free(fileName); free(checkString); free(error); free(success); return;
-        }
-        while (fgets(buffer, 255, registrationsFile)) {
-            if (strcmp(buffer, checkString) == 0) {
-                for (int i = 0; i <= count-2; i++) {
-                    fgets(buffer, 255, registrationsFile);
-                }
-                fseek(registrationsFile, ftell(registrationsFile)-6, SEEK_SET);
-                fprintf(registrationsFile, "False\n"); break;
-            }
-        }; fclose(registrationsFile);
-    }
-    else {
-        // If item's type is InstructorType, CourseType or StudentType...
-        if (item.type == CourseType) { credit = item.value.course.credit; }
-        FILE *tmp = fopen("tmp.txt", "w");
-        FILE *file = fopen(fileName, "r");
-        if (tmp == NULL || file == NULL) {
-            printf("ERROR: Couldn't open '%s' at 'removeItemBase' function.\n", fileName);
-            free(buffer); free(fileName); free(checkString); free(error); free(success); return;
+Item readTextRecordFromFile(FILE *file, Item(*textParsingFunction)(const TextLine*), int lineCount) {
+    // Reads the lines of a record from 'file', and parses them like the lines of a record in a mapping.
+    char buffers[MAX_TEXT_RECORD_LINES][255]; TextLine lines[MAX_TEXT_RECORD_LINES];
+    readTextLinesFromFile(file, buffers, lines, lineCount);
+    return textParsingFunction(lines);
+}
+
+Item readInstructorFromFile(FILE *instructorsFile) {
+    return readTextRecordFromFile(instructorsFile, parseInstructorLines, getTextRecordLineCount(InstructorType));
+}
+
+Item readCourseFromFile(FILE *coursesFile) {
+    return readTextRecordFromFile(coursesFile, parseCourseLines, getTextRecordLineCount(CourseType));
+}
+
+Item readStudentFromFile(FILE *studentsFile) {
+    return readTextRecordFromFile(studentsFile, parseStudentLines, getTextRecordLineCount(StudentType));
+}
+
+Item readRegistrationFromFile(FILE *registrationsFile) {
+    return readTextRecordFromFile(registrationsFile, parseRegistrationLines, getTextRecordLineCount(RegistrationType));
+}
+
+// MARK: - BINARY RECORD FORMAT
+
+/* Binary files start with a header of 'BINARY_HEADER_SIZE' bytes. Header holds a magic string, format version,
+ type of the records in the file, size of a record and the schema of a record, i.e. name, kind, offset and width
+ of every field. After header, records follow each other without any separator. String fields are padded
+ with zeros and always end with at least one zero byte, so longer strings are truncated while encoding.
+ Every record starts with a 'status' field, which tells whether the record is alive or not. Registrations refer
+ to their courses with course IDs, see 'COURSE CODE DICTIONARY'. Files of an older version are not read, they should
+ be converted from text files again with '--convert'. */
+
+#define BINARY_MAGIC "FBDB"
+#define BINARY_FORMAT_VERSION 2
+#define BINARY_HEADER_SIZE 512
+#define MAX_BINARY_FIELDS 8
+#define NAME_LENGTH 128
+#define CODE_LENGTH 32
+#define DATE_LENGTH 20
+#define MAX_RECORD_SIZE 512
+
+typedef enum { Int32Field, StringField } BinaryFieldKind;
+
+typedef enum { RecordRemoved = 0, RecordLive = 1 } RecordStatus;
+
+// First character of a removed record in text format.
+#define TEXT_TOMBSTONE '#'
+
+typedef struct {
+    char name[32];
+    uint32_t kind;
+    uint32_t offset;
+    uint32_t width;
+} BinaryField;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t itemType;
+    uint32_t recordSize;
+    uint32_t fieldCount;
+    BinaryField fields[MAX_BINARY_FIELDS];
+    TableCounts counts; // Kept up to date by every change of the file.
+} BinaryTableHeader;
+
+// Schemas of the records, fields are written in the same order by the encoding functions below.
+
+const BinaryField instructorSchema[] = {
+    { "status", Int32Field, 0, 4 }, { "ID", Int32Field, 4, 4 }, { "name", StringField, 8, NAME_LENGTH },
+    { "surname", StringField, 136, NAME_LENGTH }, { "title", StringField, 264, NAME_LENGTH }
+};
+
+const BinaryField courseSchema[] = {
+    { "status", Int32Field, 0, 4 }, { "code", StringField, 4, CODE_LENGTH }, { "name", StringField, 36, NAME_LENGTH },
+    { "credit", Int32Field, 164, 4 }, { "registered", Int32Field, 168, 4 }, { "total", Int32Field, 172, 4 },
+    { "instructorID", Int32Field, 176, 4 }, { "ID", Int32Field, 180, 4 }
+};
+
+const BinaryField studentSchema[] = {
+    { "status", Int32Field, 0, 4 }, { "studentNumber", Int32Field, 4, 4 }, { "name", StringField, 8, NAME_LENGTH },
+    { "surname", StringField, 136, NAME_LENGTH }, { "numberOfCoursesRegistered", Int32Field, 264, 4 },
+    { "numberOfCreditsTaken", Int32Field, 268, 4 }
+};
+
+const BinaryField registrationSchema[] = {
+    { "status", Int32Field, 0, 4 }, { "ID", Int32Field, 4, 4 }, { "studentNumber", Int32Field, 8, 4 },
+    { "courseCode", StringField, 12, CODE_LENGTH }, { "stillRegistered", Int32Field, 44, 4 },
+    { "date", StringField, 48, DATE_LENGTH }, { "courseID", Int32Field, 68, 4 }
+};
+
+void getSchemaForType(ItemType type, const BinaryField **schema, int *fieldCount) {
+    switch (type) {
+        case InstructorType: *schema = instructorSchema; *fieldCount = sizeof(instructorSchema)/sizeof(BinaryField); return;
+        case CourseType: *schema = courseSchema; *fieldCount = sizeof(courseSchema)/sizeof(BinaryField); return;
+        case StudentType: *schema = studentSchema; *fieldCount = sizeof(studentSchema)/sizeof(BinaryField); return;
+        case RegistrationType: *schema = registrationSchema; *fieldCount = sizeof(registrationSchema)/sizeof(BinaryField); return;
+    }
+}
+
+int getRecordSizeForType(ItemType type) {
+    // Size of a record is the end of its last field.
+    const BinaryField *schema = instructorSchema; int fieldCount = 0;
+    getSchemaForType(type, &schema, &fieldCount);
+    return schema[fieldCount-1].offset + schema[fieldCount-1].width;
+}
+
+int getBinaryFieldOffset(ItemType type, const char *fieldName) {
+    // Returns the offset of the field with 'fieldName' inside of a record, or -1 if record has no such field.
+    const BinaryField *schema = instructorSchema; int fieldCount = 0;
+    getSchemaForType(type, &schema, &fieldCount);
+    for (int i = 0; i < fieldCount; i++) {
+        if (strcmp(schema[i].name, fieldName) == 0) { return schema[i].offset; }
+    }
+    return -1;
+}
+
+long getRecordOffset(ItemType type, long recordNumber) {
+    return BINARY_HEADER_SIZE + recordNumber * getRecordSizeForType(type);
+}
+
+// MARK: Binary header
+
+void writeBinaryHeader(ItemType type, const TableCounts *counts, FILE *file) {
+    // Writes the header of a binary file of 'type', if 'counts' is NULL, records of the file are counted when they are needed.
+    unsigned char block[BINARY_HEADER_SIZE] = { 0 };
+    BinaryTableHeader header; memset(&header, 0, sizeof(header));
+    const BinaryField *schema = instructorSchema; int fieldCount = 0;
+    getSchemaForType(type, &schema, &fieldCount);
+    memcpy(header.magic, BINARY_MAGIC, 4);
+    header.version = BINARY_FORMAT_VERSION;
+    header.itemType = type;
+    header.recordSize = getRecordSizeForType(type);
+    header.fieldCount = fieldCount;
+    memcpy(header.fields, schema, sizeof(BinaryField)*fieldCount);
+    if (counts != NULL) { header.counts = *counts; }
+    memcpy(block, &header, sizeof(header));
+    fwrite(block, BINARY_HEADER_SIZE, 1, file);
+}
+
+bool checkBinaryHeader(ItemType type, const unsigned char *block) {
+    // Checks whether the header in 'block' is compatible with the schema of 'type'.
+    BinaryTableHeader header;
+    memcpy(&header, block, sizeof(header));
+    if (memcmp(header.magic, BINARY_MAGIC, 4) != 0 || header.itemType != (uint32_t)type) {
+        printf("ERROR: File is not a binary database file of the expected type.\n"); return false;
+    }
+    if (header.version != BINARY_FORMAT_VERSION || header.recordSize != (uint32_t)getRecordSizeForType(type)) {
+        printf("ERROR: Binary database file has version %u, but version %d is expected.\n", header.version, BINARY_FORMAT_VERSION); return false;
+    }
+    return true;
+}
+
+bool readBinaryHeader(ItemType type, FILE *file) {
+    /* Reads the header of a binary file and checks whether it is compatible with the schema of 'type'.
+     After this function returns true, 'file' is positioned at the first record. */
+    unsigned char block[BINARY_HEADER_SIZE];
+    if (fread(block, BINARY_HEADER_SIZE, 1, file) != 1) { return false; }
+    return checkBinaryHeader(type, block);
+}
+
+long getBinaryRecordCountOfAFile(ItemType type) {
+    char fileName[255];
+    getFileNameForTypeInFormat(type, BinaryFormat, fileName);
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) { return 0; }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file); fclose(file);
+    if (size <= BINARY_HEADER_SIZE) { return 0; }
+    return (size - BINARY_HEADER_SIZE) / getRecordSizeForType(type);
+}
+
+// MARK: Binary encoding and decoding of fields
+
+void putInt32(unsigned char *record, int *cursor, int32_t value) {
+    memcpy(record + *cursor, &value, sizeof(int32_t)); *cursor += sizeof(int32_t);
+}
+
+void putString(unsigned char *record, int *cursor, int width, const char *string) {
+    // Copies at most 'width'-1 characters, rest of the field is filled with zeros.
+    memset(record + *cursor, 0, width);
+    if (string != NULL) { strncpy((char *)record + *cursor, string, width-1); }
+    *cursor += width;
+}
+
+int32_t getInt32(const unsigned char *record, int *cursor) {
+    int32_t value; memcpy(&value, record + *cursor, sizeof(int32_t)); *cursor += sizeof(int32_t);
+    return value;
+}
+
+bool binaryRecordIsLive(const unsigned char *record) {
+    int cursor = 0;
+    return getInt32(record, &cursor) == RecordLive;
+}
+
+char *getString(const unsigned char *record, int *cursor, int width) {
+    // In an arena, string is a view into 'record' when it is terminated within its field, otherwise it is copied.
+    const unsigned char *field = record + *cursor; *cursor += width;
+    if (decodingArena != NULL && memchr(field, '\0', width) != NULL) { return (char*)field; }
+    char *string = allocateDecodedString(width, "getString");
+    memcpy(string, field, width); string[width-1] = '\0';
+    return string;
+}
+
+Item decodeRecordCopy(Item(*recordDecodingFunction)(const unsigned char*), const unsigned char *record, int recordSize) {
+    /* Decodes a record whose bytes won't outlive the caller, i.e. a record on the stack or in a mapping that is released
+     afterwards. In an arena, record is copied to the arena first, so strings of the item can be views into the copy. */
+    if (decodingArena == NULL) { return recordDecodingFunction(record); }
+    unsigned char *copy = allocateFromArena(decodingArena, recordSize);
+    memcpy(copy, record, recordSize);
+    return recordDecodingFunction(copy);
+}
+
+// MARK: Binary encoding functions
+
+void encodeItemToRecord(Item item, unsigned char *record) {
+    // Writes 'item' to 'record' according to the schema of its type, 'record' should be at least the record size of the type.
+    int cursor = 0;
+    putInt32(record, &cursor, RecordLive);
+    switch (item.type) {
+        case InstructorType:
+            putInt32(record, &cursor, item.value.instructor.ID);
+            putString(record, &cursor, NAME_LENGTH, item.value.instructor.name);
+            putString(record, &cursor, NAME_LENGTH, item.value.instructor.surname);
+            putString(record, &cursor, NAME_LENGTH, item.value.instructor.title); return;
+        case CourseType:
+            putString(record, &cursor, CODE_LENGTH, item.value.course.code);
+            putString(record, &cursor, NAME_LENGTH, item.value.course.name);
+            putInt32(record, &cursor, item.value.course.credit);
+            putInt32(record, &cursor, item.value.course.quota.registered);
+            putInt32(record, &cursor, item.value.course.quota.total);
+            putInt32(record, &cursor, item.value.course.instructorID);
+            putInt32(record, &cursor, item.value.course.ID); return;
+        case StudentType:
+            putInt32(record, &cursor, item.value.student.studentNumber);
+            putString(record, &cursor, NAME_LENGTH, item.value.student.name);
+            putString(record, &cursor, NAME_LENGTH, item.value.student.surname);
+            putInt32(record, &cursor, item.value.student.numberOfCoursesRegistered);
+            putInt32(record, &cursor, item.value.student.numberOfCreditsTaken); return;
+        case RegistrationType:
+            putInt32(record, &cursor, item.value.registration.ID);
+            putInt32(record, &cursor, item.value.registration.studentNumber);
+            putString(record, &cursor, CODE_LENGTH, item.value.registration.courseCode);
+            putInt32(record, &cursor, item.value.registration.stillRegistered);
+            putString(record, &cursor, DATE_LENGTH, item.value.registration.date);
+            putInt32(record, &cursor, courseIDOfCode(item.value.registration.courseCode)); return;
+    }
+}
+
+// MARK: Binary decoding functions
+
+// Those functions are used as a subroutine for creating instances from records of binary files.
+
+Item decodeInstructorRecord(const unsigned char *record) {
+    Instructor instructor; int cursor = 4;
+    instructor.ID = getInt32(record, &cursor);
+    instructor.name = getString(record, &cursor, NAME_LENGTH);
+    instructor.surname = getString(record, &cursor, NAME_LENGTH);
+    instructor.title = getString(record, &cursor, NAME_LENGTH);
+    return wrapInstructor(instructor);
+}
+
+Item decodeCourseRecord(const unsigned char *record) {
+    Course course; int cursor = 4;
+    course.code = getString(record, &cursor, CODE_LENGTH);
+    course.name = getString(record, &cursor, NAME_LENGTH);
+    course.credit = getInt32(record, &cursor);
+    course.quota.registered = getInt32(record, &cursor);
+    course.quota.total = getInt32(record, &cursor);
+    course.instructorID = getInt32(record, &cursor);
+    course.ID = getInt32(record, &cursor);
+    return wrapCourse(course);
+}
+
+Item decodeStudentRecord(const unsigned char *record) {
+    Student student; int cursor = 4;
+    student.studentNumber = getInt32(record, &cursor);
+    student.name = getString(record, &cursor, NAME_LENGTH);
+    student.surname = getString(record, &cursor, NAME_LENGTH);
+    student.numberOfCoursesRegistered = getInt32(record, &cursor);
+    student.numberOfCreditsTaken = getInt32(record, &cursor);
+    return wrapStudent(student);
+}
+
+Item decodeRegistrationRecord(const unsigned char *record) {
+    // An active registration has the current code of its course, an invalidated one has the code it was invalidated with.
+    Registration registration; int cursor = 4;
+    registration.ID = getInt32(record, &cursor);
+    registration.studentNumber = getInt32(record, &cursor);
+    int codeCursor = cursor; cursor += CODE_LENGTH;
+    registration.stillRegistered = getInt32(record, &cursor) != 0;
+    registration.date = getString(record, &cursor, DATE_LENGTH);
+    const char *code = (registration.stillRegistered) ? codeOfCourseID(getInt32(record, &cursor)) : NULL;
+    if (code == NULL) {
+        registration.courseCode = getString(record, &codeCursor, CODE_LENGTH);
+    } else {
+        registration.courseCode = allocateDecodedString(strlen(code) + 1, "decodeRegistrationRecord");
+        strcpy(registration.courseCode, code);
+    }
+    return wrapRegistration(registration);
+}
+
+// MARK: - MEMORY MAPPED FILES
+
+/* Instead of reading database files through the buffer pool, files can be mapped to memory read-only, and records can be
+ decoded straight from the mapping. Mapping of a file is cached, and reused by every scan and lookup as long as
+ the file is unchanged, i.e. same inode, same size and same modification time. Changes made in place by
+ 'write' are visible in a shared mapping anyway, appends and rewrites change the size or the inode of the file.
+ When a file changed while its mapping is still used by an outer iteration, old mapping is retired and
+ unmapped when its last user releases it.
+ 
+ So that a lookup doesn't open and 'fstat' the file every time, every table has a write stamp, which is changed when
+ the program writes, replaces or removes its file, and a mapping is reused without looking at the file while the
+ stamp is the one it was mapped with. Changes made by other programs are noticed when the header or the pages of the
+ table are synchronized with the file, which changes the stamp too. */
+
+bool memoryMappedReads = true;
+
+unsigned long tableWriteStamps[2][4];
+
+void tableFileChanged(StorageFormat format, ItemType type) {
+    // Called after the file of 'type' is written, replaced or removed, so its mapping is checked again by the next lookup.
+    tableWriteStamps[format][type]++;
+}
+
+typedef struct {
+    unsigned char *base;
+    size_t length;
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec modificationTime;
+    StorageFormat format;
+    bool isCopy; // Mapping of the copy of a transaction, see 'TRANSACTIONS'.
+    unsigned long writeStamp;
+    int users;
+    bool retired;
+} MappedFile;
+
+MappedFile *mappedFiles[4] = { NULL, NULL, NULL, NULL };
+
+void unmapFile(MappedFile *mappedFile) {
+    if (mappedFile->base != NULL) { munmap(mappedFile->base, mappedFile->length); }
+    free(mappedFile);
+}
+
+bool mappingIsUpToDate(MappedFile *mappedFile, struct stat *status) {
+    return mappedFile->format == databaseFormat && mappedFile->device == status->st_dev && mappedFile->inode == status->st_ino
+    && mappedFile->size == status->st_size && mappedFile->modificationTime.tv_sec == status->st_mtim.tv_sec
+    && mappedFile->modificationTime.tv_nsec == status->st_mtim.tv_nsec;
+}
+
+MappedFile *acquireFileMapping(ItemType type, int advice) {
+    /* Returns the mapping of the database file of 'type', file is mapped again only if it has changed since the
+     last mapping. 'advice' is passed to 'madvise', i.e. MADV_SEQUENTIAL for scans. Returns NULL if there is no file.
+     Every acquired mapping should be released with 'releaseFileMapping'. */
+    char fileName[255]; struct stat status;
+    MappedFile *mappedFile = mappedFiles[type];
+    bool isCopy = tableIsCopiedForTransaction[databaseFormat][type]; unsigned long writeStamp = tableWriteStamps[databaseFormat][type];
+    if (mappedFile != NULL && mappedFile->format == databaseFormat && mappedFile->isCopy == isCopy && mappedFile->writeStamp == writeStamp) {
+        if (mappedFile->base != NULL) { madvise(mappedFile->base, mappedFile->length, advice); }
+        mappedFile->users++;
+        return mappedFile;
+    }
+    getFileNameForType(type, fileName);
+    int descriptor = open(fileName, O_RDONLY);
+    if (descriptor < 0) { return NULL; }
+    if (fstat(descriptor, &status) != 0) { close(descriptor); return NULL; }
+    if (mappedFile != NULL && mappingIsUpToDate(mappedFile, &status)) {
+        close(descriptor);
+    } else {
+        if (mappedFile != NULL) {
+            if (mappedFile->users == 0) { unmapFile(mappedFile); } else { mappedFile->retired = true; }
+        }
+        mappedFile = malloc(sizeof(MappedFile));
+        if (mappedFile == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'acquireFileMapping' function.\n"); exit(1); }
+        mappedFile->base = NULL; mappedFile->length = (size_t)status.st_size;
+        mappedFile->device = status.st_dev; mappedFile->inode = status.st_ino; mappedFile->size = status.st_size;
+        mappedFile->modificationTime = status.st_mtim; mappedFile->format = databaseFormat;
+        mappedFile->users = 0; mappedFile->retired = false;
+        if (mappedFile->length > 0) {
+            void *base = mmap(NULL, mappedFile->length, PROT_READ, MAP_SHARED, descriptor, 0);
+            if (base == MAP_FAILED) { close(descriptor); free(mappedFile); mappedFiles[type] = NULL; return NULL; }
+            mappedFile->base = base;
+        }
+        close(descriptor);
+        mappedFiles[type] = mappedFile;
+    }
+    mappedFile->isCopy = isCopy; mappedFile->writeStamp = writeStamp;
+    if (mappedFile->base != NULL) { madvise(mappedFile->base, mappedFile->length, advice); }
+    mappedFile->users++;
+    return mappedFile;
+}
+
+void releaseFileMapping(MappedFile *mappedFile) {
+    mappedFile->users--;
+    if (mappedFile->retired && mappedFile->users == 0) { unmapFile(mappedFile); }
+}
+
+int countLinesOfMappedFile(ItemType type) {
+    // Counts the new line characters of a text file through its mapping, used by 'getRecordCountOfAFile'.
+    int lineCount = 0;
+    MappedFile *mappedFile = acquireFileMapping(type, MADV_SEQUENTIAL);
+    if (mappedFile == NULL) { return 0; }
+    if (mappedFile->base != NULL) { lineCount = (int)countNewlines((const char*)mappedFile->base, (const char*)mappedFile->base + mappedFile->length); }
+    releaseFileMapping(mappedFile);
+    return lineCount;
+}
+
+// MARK: - BUFFER POOL
+
+/* Every write to a database file, and the reads that don't use the mapping of the file, go through a pool of pages
+ kept in memory. Files are divided into pages of 'BUFFER_PAGE_SIZE' bytes, and a page is read from its file only if
+ it is not in the pool already, so reading the same part of a file again, i.e. reading a record and then its
+ counters to overwrite them, doesn't need a system call. Pool holds at most 'bufferPoolPageCount' pages, which can be
+ set with '--buffer-pool <pages>', when it is full a page is evicted with the CLOCK algorithm: pages are visited in a
+ circle, and a page that is used since the last visit is given a second chance. Page is pinned while its bytes are
+ used, and pinned pages are never evicted.
+ 
+ Writes are copied to the pages in the pool, which become dirty. Dirty pages are written back at the end of every
+ logged operation after its log record is flushed, or when they are evicted, so a page written more than once in an
+ operation is written to its file once. Parts of a write whose page is not in the pool are written to the file
+ directly. Like mappings, pages of a file are dropped when the file is changed by something else than the pool,
+ i.e. when compaction replaces it, this is detected with the inode, size and modification time of the file. */
+
+#define BUFFER_PAGE_SIZE 4096
+#define MINIMUM_BUFFER_POOL_PAGE_COUNT 8
+
+int bufferPoolPageCount = 256;
+
+typedef struct {
+    bool isUsed;
+    StorageFormat format;
+    ItemType type;
+    bool isCopy; // Page of the copy of a file made by a transaction.
+    long pageNumber;
+    size_t length; // Less than 'BUFFER_PAGE_SIZE' for the last page of a file.
+    size_t dirtyStart, dirtyEnd; // Part of the page that is changed since it was written back.
+    int pins;
+    bool isReferenced;
+    int nextInBucket;
+    unsigned char bytes[BUFFER_PAGE_SIZE];
+} BufferPage;
+
+typedef struct {
+    bool isKnown;
+    bool isWritten; // File is written by the pool since its status is taken.
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec modificationTime;
+} BufferedFile;
+
+BufferPage *bufferPages = NULL;
+int *bufferBuckets = NULL; // Pages are found with a hash table, collisions are chained with 'nextInBucket'.
+int bufferBucketCount = 0;
+int clockHand = 0;
+BufferedFile bufferedFiles[2][4][2];
+
+void initializeBufferPool() {
+    if (bufferPages != NULL) { return; }
+    if (bufferPoolPageCount < MINIMUM_BUFFER_POOL_PAGE_COUNT) { bufferPoolPageCount = MINIMUM_BUFFER_POOL_PAGE_COUNT; }
+    for (bufferBucketCount = 1; bufferBucketCount < bufferPoolPageCount * 2; bufferBucketCount *= 2);
+    bufferPages = calloc(bufferPoolPageCount, sizeof(BufferPage));
+    bufferBuckets = malloc(sizeof(int)*bufferBucketCount);
+    if (bufferPages == NULL || bufferBuckets == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'initializeBufferPool' function.\n"); exit(1); }
+    for (int i = 0; i < bufferBucketCount; i++) { bufferBuckets[i] = -1; }
+}
+
+void getFileNameOfBufferedFile(StorageFormat format, ItemType type, bool isCopy, char *fileName) {
+    bool isCopied = tableIsCopiedForTransaction[format][type];
+    tableIsCopiedForTransaction[format][type] = isCopy;
+    getFileNameForTypeInFormat(type, format, fileName);
+    tableIsCopiedForTransaction[format][type] = isCopied;
+}
+
+int bufferBucketOfPage(StorageFormat format, ItemType type, bool isCopy, long pageNumber) {
+    uint64_t key = ((uint64_t)pageNumber << 4) | ((uint64_t)format << 3) | ((uint64_t)type << 1) | (uint64_t)isCopy;
+    return (int)((key * 11400714819323198485ULL) >> 32) & (bufferBucketCount - 1);
+}
+
+BufferPage *findBufferPage(StorageFormat format, ItemType type, bool isCopy, long pageNumber) {
+    for (int i = bufferBuckets[bufferBucketOfPage(format, type, isCopy, pageNumber)]; i >= 0; i = bufferPages[i].nextInBucket) {
+        BufferPage *page = &bufferPages[i];
+        if (page->pageNumber == pageNumber && page->type == type && page->format == format && page->isCopy == isCopy) { return page; }
+    }
+    return NULL;
+}
+
+void dropBufferPage(BufferPage *page) {
+    // Removes 'page' from the pool without writing it back.
+    int index = (int)(page - bufferPages);
+    int *link = &bufferBuckets[bufferBucketOfPage(page->format, page->type, page->isCopy, page->pageNumber)];
+    while (*link != index) { link = &bufferPages[*link].nextInBucket; }
+    *link = page->nextInBucket;
+    page->isUsed = false;
+}
+
+void writeBackBufferPage(BufferPage *page) {
+    if (page->dirtyEnd <= page->dirtyStart) { return; }
+    char fileName[255];
+    size_t length = page->dirtyEnd - page->dirtyStart;
+    getFileNameOfBufferedFile(page->format, page->type, page->isCopy, fileName);
+    int descriptor = open(fileName, O_WRONLY | O_CREAT, 0644);
+    if (descriptor < 0 || pwrite(descriptor, page->bytes + page->dirtyStart, length, (off_t)page->pageNumber * BUFFER_PAGE_SIZE + page->dirtyStart) != (ssize_t)length) {
+        printf("ERROR: Couldn't write to '%s'.\n", fileName);
+    }
+    if (descriptor >= 0) { close(descriptor); }
+    page->dirtyStart = 0; page->dirtyEnd = 0;
+    bufferedFiles[page->format][page->type][page->isCopy].isWritten = true;
+    tableFileChanged(page->format, page->type);
+}
+
+BufferPage *evictBufferPage() {
+    // Finds an unused page with the CLOCK algorithm, writing back the evicted page if it is dirty.
+    for (int step = 0; step < bufferPoolPageCount * 2; step++) {
+        BufferPage *page = &bufferPages[clockHand];
+        clockHand = (clockHand + 1) % bufferPoolPageCount;
+        if (!page->isUsed) { return page; }
+        if (page->pins > 0) { continue; }
+        if (page->isReferenced) { page->isReferenced = false; continue; }
+        writeBackBufferPage(page); dropBufferPage(page);
+        return page;
+    }
+    printf("EXCEPTION: Every page of the buffer pool is pinned.\n"); exit(1);
+}
+
+// MARK: Keeping pages synchronized with files
+
+void takeStatusOfBufferedFile(BufferedFile *file, const struct stat *status) {
+    file->isKnown = true; file->device = status->st_dev; file->inode = status->st_ino;
+    file->size = status->st_size; file->modificationTime = status->st_mtim;
+}
+
+bool synchronizeBufferedFile(StorageFormat format, ItemType type, bool isCopy) {
+    // Drops the pages of the file if it is changed by something else than the pool. Returns false if there is no file.
+    char fileName[255]; struct stat status;
+    BufferedFile *file = &bufferedFiles[format][type][isCopy];
+    if (file->isWritten) { return true; } // Changed by the pool itself, its status is taken again when the pool is flushed.
+    getFileNameOfBufferedFile(format, type, isCopy, fileName);
+    bool exists = stat(fileName, &status) == 0;
+    if (exists && file->isKnown && file->device == status.st_dev && file->inode == status.st_ino && file->size == status.st_size
+        && file->modificationTime.tv_sec == status.st_mtim.tv_sec && file->modificationTime.tv_nsec == status.st_mtim.tv_nsec) { return true; }
+    initializeBufferPool(); tableFileChanged(format, type);
+    for (int i = 0; i < bufferPoolPageCount; i++) {
+        BufferPage *page = &bufferPages[i];
+        if (page->isUsed && page->format == format && page->type == type && page->isCopy == isCopy) { dropBufferPage(page); }
+    }
+    file->isKnown = false;
+    if (exists) { takeStatusOfBufferedFile(file, &status); }
+    return exists;
+}
+
+bool synchronizeBufferPool(ItemType type) {
+    // Called before reading the file of 'type' through the pool, returns false if there is no file.
+    return synchronizeBufferedFile(databaseFormat, type, tableIsCopiedForTransaction[databaseFormat][type]);
+}
+
+void flushBufferPool() {
+    // Writes back every dirty page, status of the written files is taken again so their pages stay in the pool.
+    if (bufferPages == NULL) { return; }
+    for (int i = 0; i < bufferPoolPageCount; i++) {
+        if (bufferPages[i].isUsed) { writeBackBufferPage(&bufferPages[i]); }
+    }
+    for (int format = 0; format < 2; format++) {
+        for (int type = 0; type < 4; type++) {
+            for (int isCopy = 0; isCopy < 2; isCopy++) {
+                BufferedFile *file = &bufferedFiles[format][type][isCopy];
+                if (!file->isWritten) { continue; }
+                char fileName[255]; struct stat status;
+                getFileNameOfBufferedFile(format, type, isCopy, fileName);
+                if (stat(fileName, &status) == 0) { takeStatusOfBufferedFile(file, &status); } else { file->isKnown = false; }
+                file->isWritten = false;
+            }
+        }
+    }
+}
+
+// MARK: Reading and writing through the pool
+
+BufferPage *pinBufferPage(ItemType type, long pageNumber) {
+    // Returns the page of the file of 'type' pinned, reading it if it is not in the pool. Returns NULL if page is after the end of the file.
+    initializeBufferPool();
+    bool isCopy = tableIsCopiedForTransaction[databaseFormat][type];
+    BufferPage *page = findBufferPage(databaseFormat, type, isCopy, pageNumber);
+    if (page == NULL) {
+        char fileName[255];
+        getFileNameOfBufferedFile(databaseFormat, type, isCopy, fileName);
+        int descriptor = open(fileName, O_RDONLY);
+        if (descriptor < 0) { return NULL; }
+        page = evictBufferPage();
+        ssize_t length = pread(descriptor, page->bytes, BUFFER_PAGE_SIZE, (off_t)pageNumber * BUFFER_PAGE_SIZE);
+        close(descriptor);
+        if (length <= 0) { return NULL; }
+        page->isUsed = true; page->format = databaseFormat; page->type = type; page->isCopy = isCopy;
+        page->pageNumber = pageNumber; page->length = (size_t)length; page->dirtyStart = 0; page->dirtyEnd = 0; page->pins = 0;
+        int *bucket = &bufferBuckets[bufferBucketOfPage(databaseFormat, type, isCopy, pageNumber)];
+        page->nextInBucket = *bucket; *bucket = (int)(page - bufferPages);
+    }
+    page->pins++; page->isReferenced = true;
+    return page;
+}
+
+void unpinBufferPage(BufferPage *page) {
+    page->pins--;
+}
+
+size_t readFromBufferPool(ItemType type, long offset, void *buffer, size_t length) {
+    // Copies 'length' bytes at 'offset' of the file of 'type' to 'buffer', returns the number of bytes copied, which is less at the end of the file.
+    size_t cursor = 0;
+    while (cursor < length) {
+        long position = offset + (long)cursor;
+        size_t pageOffset = (size_t)(position % BUFFER_PAGE_SIZE);
+        BufferPage *page = pinBufferPage(type, position / BUFFER_PAGE_SIZE);
+        if (page == NULL) { break; }
+        size_t chunk = (pageOffset < page->length) ? page->length - pageOffset : 0;
+        if (chunk > length - cursor) { chunk = length - cursor; }
+        memcpy((unsigned char *)buffer + cursor, page->bytes + pageOffset, chunk);
+        bool isLastPage = page->length < BUFFER_PAGE_SIZE;
+        unpinBufferPage(page);
+        cursor += chunk;
+        if (chunk == 0 || isLastPage) { break; }
+    }
+    return cursor;
+}
+
+void writeToBufferPool(StorageFormat format, ItemType type, long offset, const unsigned char *bytes, size_t length) {
+    /* Copies the parts of the write whose pages are in the pool to the pages, including the appends to the last page of
+     the file, other parts are written to the file directly. */
+    char fileName[255]; int descriptor = -1;
+    bool isCopy = tableIsCopiedForTransaction[format][type];
+    getFileNameOfBufferedFile(format, type, isCopy, fileName);
+    synchronizeBufferedFile(format, type, isCopy);
+    if (length == 0) { descriptor = open(fileName, O_WRONLY | O_CREAT, 0644); } // Only creates the file.
+    for (size_t cursor = 0; cursor < length; ) {
+        long position = offset + (long)cursor;
+        size_t pageOffset = (size_t)(position % BUFFER_PAGE_SIZE);
+        size_t chunk = BUFFER_PAGE_SIZE - pageOffset;
+        if (chunk > length - cursor) { chunk = length - cursor; }
+        BufferPage *page = findBufferPage(format, type, isCopy, position / BUFFER_PAGE_SIZE);
+        if (page != NULL && pageOffset <= page->length) {
+            memcpy(page->bytes + pageOffset, bytes + cursor, chunk);
+            if (pageOffset + chunk > page->length) { page->length = pageOffset + chunk; }
+            if (page->dirtyEnd <= page->dirtyStart) { page->dirtyStart = pageOffset; page->dirtyEnd = pageOffset + chunk; }
+            if (pageOffset < page->dirtyStart) { page->dirtyStart = pageOffset; }
+            if (pageOffset + chunk > page->dirtyEnd) { page->dirtyEnd = pageOffset + chunk; }
+            page->isReferenced = true;
+        } else {
+            // A page that doesn't reach 'position' would have a gap, it is written back and dropped.
+            if (page != NULL) { writeBackBufferPage(page); dropBufferPage(page); }
+            if (descriptor < 0) { descriptor = open(fileName, O_WRONLY | O_CREAT, 0644); }
+            if (descriptor < 0 || pwrite(descriptor, bytes + cursor, chunk, position) != (ssize_t)chunk) {
+                printf("ERROR: Couldn't write to '%s'.\n", fileName);
+                if (descriptor < 0) { break; }
+            }
+        }
+        cursor += chunk;
+    }
+    if (descriptor >= 0) { close(descriptor); }
+    bufferedFiles[format][type][isCopy].isWritten = true;
+    tableFileChanged(format, type);
+}
+
+void dropBufferPagesOfTable(StorageFormat format, ItemType type) {
+    // Called when a file is replaced with its copy made by a transaction.
+    flushBufferPool();
+    if (bufferPages == NULL) { return; }
+    for (int i = 0; i < bufferPoolPageCount; i++) {
+        BufferPage *page = &bufferPages[i];
+        if (page->isUsed && page->format == format && page->type == type) { dropBufferPage(page); }
+    }
+    bufferedFiles[format][type][0].isKnown = false; bufferedFiles[format][type][1].isKnown = false;
+}
+
+// MARK: Streams on the pool
+
+/* Text records are decoded from a 'FILE', so text files are read through the pool with a stream whose reads are
+ served by 'readFromBufferPool'. */
+
+typedef struct {
+    ItemType type;
+    long position;
+} TableStream;
+
+ssize_t readTableStream(void *cookie, char *buffer, size_t size) {
+    TableStream *stream = cookie;
+    size_t length = readFromBufferPool(stream->type, stream->position, buffer, size);
+    stream->position += (long)length;
+    return (ssize_t)length;
+}
+
+int seekTableStream(void *cookie, off64_t *offset, int whence) {
+    // Streams are only used for reading records, so the end of the file isn't needed.
+    TableStream *stream = cookie;
+    if (whence == SEEK_END) { return -1; }
+    long position = (whence == SEEK_SET) ? (long)*offset : stream->position + (long)*offset;
+    if (position < 0) { return -1; }
+    stream->position = position; *offset = position;
+    return 0;
+}
+
+int closeTableStream(void *cookie) {
+    free(cookie);
+    return 0;
+}
+
+FILE *openTableStream(ItemType type) {
+    // Opens a stream that reads the file of 'type' through the pool, returns NULL if there is no file.
+    if (!synchronizeBufferPool(type)) { return NULL; }
+    TableStream *stream = malloc(sizeof(TableStream));
+    if (stream == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'openTableStream' function.\n"); exit(1); }
+    stream->type = type; stream->position = 0;
+    cookie_io_functions_t functions = { readTableStream, NULL, seekTableStream, closeTableStream };
+    FILE *file = fopencookie(stream, "r", functions);
+    if (file == NULL) { free(stream); }
+    return file;
+}
+
+// MARK: - FUNCTION PROTOTYPES
+
+void prepareForIteration(ItemType type, char *fileName, Item(**decodingFunction)(FILE*));
+void prepareForBinaryIteration(ItemType type, Item(**recordDecodingFunction)(const unsigned char*));
+void synchronizeIndexesOfType(ItemType type);
+void closeIndexesOfType(ItemType type);
+void adoptIndexesOfType(ItemType type);
+int getIndexFileNamesOfType(ItemType type, StorageFormat format, char fileNames[][255]);
+void prepareTableForChange(ItemType type);
+void replaceTableWithTransactionCopy(StorageFormat format, ItemType type);
+void removeTransactionCopies(void);
+void stampIndexesOfType(ItemType type);
+void indexItemAdded(Item item, long offset);
+void indexItemChanged(Item oldVersion, Item newVersion, long offset);
+void indexItemRemoved(Item item, long offset);
+void removeRecordAtOffset(Item item, long offset);
+void synchronizeTableHeader(ItemType type);
+void tableHeaderChanged(ItemType type, long liveDifference, long tombstoneDifference);
+void stampTableHeader(ItemType type);
+long allocateTableID(ItemType type);
+long getTombstoneCountOfAFile(ItemType type);
+void compactTableIfNeeded(ItemType type);
+bool findOffsetOfItemInDatabase(Item item, long *offset);
+bool findOffsetOfItem(Item item, long *offset);
+void rebuildIndexesOfType(ItemType type);
+typedef struct OffsetShift OffsetShift;
+void shiftRegistrationColumns(const OffsetShift *shift);
+void synchronizeRegistrationColumns(void);
+void dropRegistrationColumns(void);
+void stampRegistrationColumns(void);
+void registrationColumnsItemAdded(Item item, long offset);
+void registrationColumnsItemChanged(Item newVersion, long offset);
+void registrationColumnsItemRemoved(Item item, long offset);
+void renameCourseInRegistrationColumns(const char *oldCode, const char *newCode);
+void synchronizeCourseDictionary(void);
+void dropCourseDictionary(void);
+void stampCourseDictionary(void);
+void courseDictionaryItemWritten(Item item);
+OptionalItem RegistrationColumnsOfCourseOrStudentIterator(Item courseOrStudent, OptionalItem(*aimFunction)(Item, Item), Item aimItem);
+OptionalItem findItemInDatabase(Item item);
+bool conditionForQuery(Item decodedItem, Item queriedItem);
+OptionalItem ItemIterator(ItemType type, OptionalItem(*aimFunction)(Item, Item), Item aimItem);
+OptionalItem query(Item decodedItem, Item queriedItem);
+bool itemIsInDatabase(Item item);
+Item getItem(Item item);
+void removeCoursesGivenByInstructor(Item instructorItem);
+void invalidateRegistrationsAfterCourseOrStudentRemoval(Item courseOrStudent);
+void updateStudentsCreditStatus(int studentNumber, bool afterRegisteration, int credit, bool changeCourseCount);
+void updateRegistrationsAfterCourseOrStudentsUniqueKeyHasChanged(Item courseOrStudentToRemove, Item updatedVersion);
+void updateStudentsCreditIfCoursesCreditHasChanged(int creditDifference, Item course);
+void updateCoursesAfterInstructorIDChange(Item instructorItem, Item updatedVersion);
+bool addItemBase(Item item, bool forUpdate);
+bool removeItemBase(Item item, bool forUpdate);
+bool registerStudentForCourseBase(char *courseCode, int studentNumber, int MAX_COUNT, int MAX_CREDIT, bool forUpdate);
+bool updateItemBase(Item itemToBeUpdated, Item updatedVersion, bool printMessage);
+void updateItemSilently(Item itemToBeUpdated, Item updatedVersion);
+void updateItem(Item itemToBeUpdated, Item updatedVersion);
+
+// MARK: - WRITE-AHEAD LOG
+
+/* Every change to a database file, except rewriting the whole file, goes through 'writeToTable'. Writes of one
+ logical operation, i.e. a registration together with the student and course counters it changes, are collected
+ between 'beginLoggedOperation' and 'commitLoggedOperation', and written to 'Database.wal' as one log record. Only
+ after the log is flushed to disk with 'fsync', writes are applied to the database files. So if program stops in
+ the middle of an operation, either the whole operation is in the log, or none of it is applied.
+ 
+ Writes of a committed operation are applied to the pages of the buffer pool, and the pages are written to the
+ files before the commit returns, since mapped reads see the files and not the buffer pool. Only 'fsync' of the
+ files is deferred: they are flushed to disk at a checkpoint, which also empties the log. So a commit costs one
+ 'fsync' of the log, not one for every file it changes. Checkpoint happens when the log grows too big, before a
+ file is rewritten, i.e. by compaction, and when the program exits. When the program starts, records in the log
+ are applied again by 'recoverFromLog', a record at the end of the log that is not written completely is ignored.
+ Applying a record again is harmless, since a write is a fixed bytes at a fixed offset of a file.
+ 
+ There is no group commit of separate operations, the program runs one operation at a time, and every commit is
+ flushed before it returns. Instead, operations that change many records together, i.e. registering a batch of
+ students or removing the courses of an instructor with their registrations, open one operation around all of
+ their writes, so they are committed as one log record with one 'fsync'. Writes
+ collected in an open operation are not visible to reads until the operation is committed, so an operation should
+ not read what it writes. A transaction writes to copies of the files, which are not logged, and its commit is
+ logged as one record that replaces the files with the copies, see 'TRANSACTIONS'. Index hooks are called while
+ operations are collected, and indexes are stamped again after the writes are applied. */
+
+#define LOG_FILE_NAME "Database.wal"
+#define LOG_RECORD_MAGIC 0x4C415746
+#define LOG_CHECKPOINT_SIZE (4 << 20)
+
+bool writeAheadLogging = true;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t writeCount;
+    uint64_t sequenceNumber;
+    uint64_t length; // Length of the writes that follow the header.
+    uint64_t checksum;
+} LogRecordHeader;
+
+typedef struct {
+    uint32_t format;
+    uint32_t type;
+    int64_t offset;
+    uint64_t length;
+} LogWriteHeader;
+
+typedef struct {
+    StorageFormat format;
+    ItemType type;
+    long offset;
+    size_t length;
+    unsigned char *bytes;
+} LoggedWrite;
+
+typedef struct {
+    LoggedWrite *writes;
+    int count;
+    int capacity;
+} LoggedOperation;
+
+LoggedOperation currentOperation;
+int loggedOperationDepth = 0;
+int logDescriptor = -1;
+uint64_t nextSequenceNumber = 1;
+bool touchedTables[2][4]; // Database files that are changed since the last checkpoint.
+
+uint64_t checksumOfBytes(const unsigned char *bytes, size_t length) {
+    // FNV-1a hash of 'bytes'.
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) { hash = (hash ^ bytes[i]) * 1099511628211ULL; }
+    return hash;
+}
+
+void addLoggedWrite(LoggedOperation *operation, StorageFormat format, ItemType type, long offset, const void *bytes, size_t length) {
+    if (operation->count == operation->capacity) {
+        operation->capacity = (operation->capacity == 0) ? 8 : operation->capacity * 2;
+        operation->writes = realloc(operation->writes, sizeof(LoggedWrite)*operation->capacity);
+        if (operation->writes == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'addLoggedWrite' function.\n"); exit(1); }
+    }
+    LoggedWrite *write = &operation->writes[operation->count++];
+    write->format = format; write->type = type; write->offset = offset; write->length = length;
+    write->bytes = malloc(length);
+    if (write->bytes == NULL && length > 0) { printf("EXCEPTION: Couldn't allocate memory in 'addLoggedWrite' function.\n"); exit(1); }
+    if (length > 0) { memcpy(write->bytes, bytes, length); }
+}
+
+void clearLoggedOperation(LoggedOperation *operation) {
+    for (int i = 0; i < operation->count; i++) { free(operation->writes[i].bytes); }
+    free(operation->writes);
+    operation->writes = NULL; operation->count = 0; operation->capacity = 0;
+}
+
+void applyLoggedWrite(StorageFormat format, ItemType type, long offset, const unsigned char *bytes, size_t length) {
+    // A write with a negative offset replaces the file with its copy made by a transaction.
+    if (offset < 0) { dropBufferPagesOfTable(format, type); replaceTableWithTransactionCopy(format, type); return; }
+    writeToBufferPool(format, type, offset, bytes, length);
+    touchedTables[format][type] = true;
+}
+
+// MARK: Log file
+
+int openLogFile() {
+    if (logDescriptor < 0) { logDescriptor = open(LOG_FILE_NAME, O_RDWR | O_CREAT | O_APPEND, 0644); }
+    return logDescriptor;
+}
+
+void checkpointLog() {
+    // Flushes the database files changed since the last checkpoint to disk, and empties the log.
+    flushBufferPool();
+    for (int format = 0; format < 2; format++) {
+        for (int type = 0; type < 4; type++) {
+            if (!touchedTables[format][type]) { continue; }
+            char fileName[255];
+            getFileNameForTypeInFormat(type, format, fileName);
+            int descriptor = open(fileName, O_RDONLY);
+            if (descriptor >= 0) { fsync(descriptor); close(descriptor); }
+            touchedTables[format][type] = false;
+        }
+    }
+    if (openLogFile() < 0) { return; }
+    if (ftruncate(logDescriptor, 0) != 0) { printf("ERROR: Couldn't truncate '%s'.\n", LOG_FILE_NAME); }
+    fsync(logDescriptor);
+}
+
+void appendLogRecord(unsigned char **buffer, size_t *length, size_t *capacity, const LoggedOperation *operation) {
+    // Serializes 'operation' as a log record to the end of 'buffer'.
+    size_t recordLength = sizeof(LogRecordHeader);
+    for (int i = 0; i < operation->count; i++) { recordLength += sizeof(LogWriteHeader) + operation->writes[i].length; }
+    if (*length + recordLength > *capacity) {
+        *capacity = (*length + recordLength) * 2;
+        *buffer = realloc(*buffer, *capacity);
+        if (*buffer == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'appendLogRecord' function.\n"); exit(1); }
+    }
+    unsigned char *record = *buffer + *length; size_t cursor = sizeof(LogRecordHeader);
+    for (int i = 0; i < operation->count; i++) {
+        LogWriteHeader writeHeader;
+        writeHeader.format = operation->writes[i].format; writeHeader.type = operation->writes[i].type;
+        writeHeader.offset = operation->writes[i].offset; writeHeader.length = operation->writes[i].length;
+        memcpy(record + cursor, &writeHeader, sizeof(LogWriteHeader)); cursor += sizeof(LogWriteHeader);
+        memcpy(record + cursor, operation->writes[i].bytes, operation->writes[i].length); cursor += operation->writes[i].length;
+    }
+    LogRecordHeader header;
+    header.magic = LOG_RECORD_MAGIC; header.writeCount = operation->count; header.sequenceNumber = nextSequenceNumber++;
+    header.length = recordLength - sizeof(LogRecordHeader);
+    header.checksum = checksumOfBytes(record + sizeof(LogRecordHeader), header.length);
+    memcpy(record, &header, sizeof(LogRecordHeader));
+    *length += recordLength;
+}
+
+// MARK: Committing operations
+
+void commitLoggedWrites(LoggedOperation *operation) {
+    // Writes the operation as a log record, flushes the log, and then applies its writes to the database files in order.
+    if (operation->count == 0) { return; }
+    unsigned char *buffer = NULL; size_t length = 0, capacity = 0;
+    bool touchedTypes[4] = { false, false, false, false }; bool shouldLog = false;
+    appendLogRecord(&buffer, &length, &capacity, operation);
+    for (int i = 0; i < operation->count; i++) {
+        // Writes to the copies of a transaction are not logged, copies are dropped if program stops before they replace the files.
+        LoggedWrite *write = &operation->writes[i];
+        if (write->offset < 0 || !tableIsCopiedForTransaction[write->format][write->type]) { shouldLog = true; }
+    }
+    if (writeAheadLogging && shouldLog) {
+        if (openLogFile() < 0 || write(logDescriptor, buffer, length) != (ssize_t)length || fsync(logDescriptor) != 0) {
+            printf("ERROR: Couldn't write to '%s'.\n", LOG_FILE_NAME);
+        }
+    }
+    for (int i = 0; i < operation->count; i++) {
+        LoggedWrite *write = &operation->writes[i];
+        applyLoggedWrite(write->format, write->type, write->offset, write->bytes, write->length);
+        if (write->format == databaseFormat) { touchedTypes[write->type] = true; }
+    }
+    free(buffer);
+    flushBufferPool();
+    for (int type = 0; type < 4; type++) {
+        if (touchedTypes[type]) { stampIndexesOfType(type); stampTableHeader(type); }
+    }
+    if (writeAheadLogging && logDescriptor >= 0 && lseek(logDescriptor, 0, SEEK_END) > LOG_CHECKPOINT_SIZE) { checkpointLog(); }
+}
+
+void beginLoggedOperation() {
+    // Operations can be nested, the writes of nested operations belong to the outermost operation.
+    loggedOperationDepth++;
+}
+
+void commitLoggedOperation() {
+    if (--loggedOperationDepth > 0) { return; }
+    commitLoggedWrites(&currentOperation);
+    clearLoggedOperation(&currentOperation);
+}
+
+void writeToTable(ItemType type, long offset, const void *bytes, size_t length) {
+    // Writes 'bytes' at 'offset' of the database file of 'type', as a part of the open operation if there is one.
+    beginLoggedOperation();
+    addLoggedWrite(&currentOperation, databaseFormat, type, offset, bytes, length);
+    commitLoggedOperation();
+}
+
+long getTableEndOffset(ItemType type) {
+    // Offset of the end of the database file of 'type', including the appends in the open operation.
+    char fileName[255]; struct stat status;
+    getFileNameForType(type, fileName);
+    long end = (stat(fileName, &status) == 0) ? (long)status.st_size : 0;
+    for (int i = 0; i < currentOperation.count; i++) {
+        LoggedWrite *write = &currentOperation.writes[i];
+        if (write->format == databaseFormat && write->type == type && write->offset + (long)write->length > end) {
+            end = write->offset + (long)write->length;
+        }
+    }
+    return end;
+}
+
+void writeBinaryHeaderToTable(ItemType type, const TableCounts *counts) {
+    // Writes the whole header of an empty binary file of 'type' with 'writeToTable'.
+    unsigned char header[BINARY_HEADER_SIZE];
+    FILE *headerStream = fmemopen(header, BINARY_HEADER_SIZE, "wb");
+    if (headerStream == NULL) { printf("EXCEPTION: Couldn't open a memory stream in 'writeBinaryHeaderToTable' function.\n"); exit(1); }
+    writeBinaryHeader(type, counts, headerStream); fclose(headerStream);
+    writeToTable(type, 0, header, BINARY_HEADER_SIZE);
+}
+
+long appendToTable(ItemType type, const void *bytes, size_t length) {
+    // Appends 'bytes' to the database file of 'type', header of a binary file is written first if file is empty. Returns the offset of 'bytes'.
+    long offset = getTableEndOffset(type);
+    beginLoggedOperation();
+    if (databaseFormat == BinaryFormat && offset == 0) { writeBinaryHeaderToTable(type, NULL); offset = BINARY_HEADER_SIZE; }
+    writeToTable(type, offset, bytes, length);
+    commitLoggedOperation();
+    return offset;
+}
+
+// MARK: Recovery
+
+void recoverFromLog() {
+    /* Applies the records in the log again, stops at the first record that is not written completely. Then database
+     files are flushed and the log is emptied. Log is also checkpointed when program exits. */
+    static bool isRecovered = false;
+    if (isRecovered) { return; }
+    isRecovered = true; atexit(checkpointLog);
+    if (openLogFile() < 0) { return; }
+    off_t size = lseek(logDescriptor, 0, SEEK_END);
+    if (size <= 0) { removeTransactionCopies(); return; }
+    unsigned char *log = malloc(size);
+    if (log == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'recoverFromLog' function.\n"); exit(1); }
+    if (pread(logDescriptor, log, size, 0) != size) { free(log); printf("ERROR: Couldn't read '%s'.\n", LOG_FILE_NAME); return; }
+    int recoveredCount = 0; size_t cursor = 0;
+    while (cursor + sizeof(LogRecordHeader) <= (size_t)size) {
+        LogRecordHeader header;
+        memcpy(&header, log + cursor, sizeof(LogRecordHeader));
+        const unsigned char *record = log + cursor + sizeof(LogRecordHeader);
+        if (header.magic != LOG_RECORD_MAGIC || header.length > (size_t)size - cursor - sizeof(LogRecordHeader)
+            || checksumOfBytes(record, header.length) != header.checksum) { break; }
+        size_t writeCursor = 0;
+        for (uint32_t i = 0; i < header.writeCount; i++) {
+            LogWriteHeader writeHeader;
+            memcpy(&writeHeader, record + writeCursor, sizeof(LogWriteHeader)); writeCursor += sizeof(LogWriteHeader);
+            applyLoggedWrite(writeHeader.format, writeHeader.type, writeHeader.offset, record + writeCursor, writeHeader.length);
+            writeCursor += writeHeader.length;
+        }
+        cursor += sizeof(LogRecordHeader) + header.length; recoveredCount++;
+    }
+    free(log);
+    if (recoveredCount > 0) { printf("Recovered %d operations from the write-ahead log.\n", recoveredCount); }
+    checkpointLog();
+    removeTransactionCopies(); // Copies left by a transaction that wasn't committed.
+}
+
+// MARK: - TRANSACTIONS
+
+/* Operations called between 'beginTransaction' and 'commitTransaction' are not applied right away, they are
+ buffered as the steps of the transaction, and 'abortTransaction' drops them. When the transaction is committed,
+ steps are applied in order to copies of the database files, so every step sees the changes of the steps before it.
+ If a step fails, i.e. a course is added for an instructor that doesn't exist, copies are dropped and none of the
+ steps are applied. A file is copied once, before a step changes it for the first time, so a transaction rewrites
+ every file it changes only once, however many steps change it. Indexes are copied with their file.
+ 
+ When every step is applied, copies are flushed to disk and replace the files. Replacements are written to the
+ write-ahead log as one record first, so if program stops while files are replaced, the rest of the files are
+ replaced by 'recoverFromLog'. Transactions are begun, committed and aborted with the '6' option of the menu. */
+
+#define INDEX_COUNT_LIMIT 4 // Maximum number of indexes of a type.
+
+typedef enum { AddStep, RemoveStep, UpdateStep, RegisterStep } TransactionStepKind;
+
+typedef struct {
+    TransactionStepKind kind;
+    Item item; // Registration with the course code and student number for 'RegisterStep'.
+    Item updatedVersion; // Only for 'UpdateStep'.
+    int maxCount;
+    int maxCredit;
+} TransactionStep;
+
+typedef struct {
+    bool isOpen;
+    bool isApplying;
+    TransactionStep *steps;
+    int count;
+    int capacity;
+} Transaction;
+
+Transaction transaction;
+
+bool beginTransaction() {
+    if (transaction.isOpen) { printf("ERROR: Couldn't begin the transaction. There is already an open transaction.\n"); return false; }
+    transaction.isOpen = true;
+    return true;
+}
+
+bool bufferTransactionStep(TransactionStepKind kind, Item item, Item updatedVersion, int maxCount, int maxCredit) {
+    // Buffers the operation as a step of the open transaction. Returns false if there is no open transaction, so operation should be applied right away.
+    if (!transaction.isOpen || transaction.isApplying) { return false; }
+    if (transaction.count == transaction.capacity) {
+        transaction.capacity = (transaction.capacity == 0) ? 16 : transaction.capacity * 2;
+        transaction.steps = realloc(transaction.steps, sizeof(TransactionStep)*transaction.capacity);
+        if (transaction.steps == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'bufferTransactionStep' function.\n"); exit(1); }
+    }
+    TransactionStep *step = &transaction.steps[transaction.count++];
+    step->kind = kind; step->item = copyItem(item);
+    step->updatedVersion = (kind == UpdateStep) ? copyItem(updatedVersion) : step->item;
+    step->maxCount = maxCount; step->maxCredit = maxCredit;
+    return true;
+}
+
+void clearTransaction() {
+    for (int i = 0; i < transaction.count; i++) {
+        freeItem(transaction.steps[i].item);
+        if (transaction.steps[i].kind == UpdateStep) { freeItem(transaction.steps[i].updatedVersion); }
+    }
+    free(transaction.steps);
+    transaction.steps = NULL; transaction.count = 0; transaction.capacity = 0;
+    transaction.isOpen = false; transaction.isApplying = false;
+}
+
+void abortTransaction() {
+    if (!transaction.isOpen) { printf("ERROR: Couldn't abort the transaction. There is no open transaction.\n"); return; }
+    printf("Aborted the transaction, %d operations are discarded.\n", transaction.count);
+    clearTransaction();
+}
+
+// MARK: Copies of files
+
+bool copyFile(const char *sourceName, const char *destinationName) {
+    // Copies the file 'sourceName' to 'destinationName', returns false if there is no such file.
+    int source = open(sourceName, O_RDONLY);
+    if (source < 0) { return false; }
+    int destination = open(destinationName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (destination < 0) { printf("ERROR: Couldn't open '%s'.\n", destinationName); close(source); return false; }
+    unsigned char buffer[65536]; ssize_t length;
+    while ((length = read(source, buffer, sizeof(buffer))) > 0) {
+        if (write(destination, buffer, length) != length) { printf("ERROR: Couldn't write to '%s'.\n", destinationName); break; }
+    }
+    close(source); close(destination);
+    return true;
+}
+
+void copyTableForTransaction(ItemType type) {
+    /* Copies the file of 'type' and its indexes, following changes of the transaction are made on the copies.
+     Indexes and the tombstone count are synchronized first, so they are still fresh for the copy of the file. */
+    char fileName[255], copyName[255]; char indexNames[INDEX_COUNT_LIMIT][255], indexCopyNames[INDEX_COUNT_LIMIT][255];
+    synchronizeIndexesOfType(type); synchronizeTableHeader(type);
+    getFileNameForType(type, fileName);
+    int indexCount = getIndexFileNamesOfType(type, databaseFormat, indexNames);
+    closeIndexesOfType(type);
+    tableIsCopiedForTransaction[databaseFormat][type] = true;
+    getFileNameForType(type, copyName);
+    getIndexFileNamesOfType(type, databaseFormat, indexCopyNames);
+    if (!copyFile(fileName, copyName)) { return; } // Copy is created by the first append.
+    for (int i = 0; i < indexCount && indexedLookups; i++) { copyFile(indexNames[i], indexCopyNames[i]); }
+    adoptIndexesOfType(type); stampTableHeader(type);
+}
+
+void prepareTableForChange(ItemType type) {
+    /* Called before the file of 'type' is changed. Indexes and the tombstone count of the file are synchronized,
+     so the ones that are stale because of others are rebuilt before the change. While a transaction is applied,
+     file is copied before its first change. */
+    if (transaction.isApplying && !tableIsCopiedForTransaction[databaseFormat][type]) { copyTableForTransaction(type); }
+    synchronizeIndexesOfType(type); synchronizeTableHeader(type);
+}
+
+void replaceTableWithTransactionCopy(StorageFormat format, ItemType type) {
+    // Renames the copy of the file and its indexes to their original names. Called again by 'recoverFromLog', so copies may be already renamed.
+    char fileName[255], copyName[255]; char indexNames[INDEX_COUNT_LIMIT][255], indexCopyNames[INDEX_COUNT_LIMIT][255];
+    char headerName[255], headerCopyName[255];
+    tableIsCopiedForTransaction[format][type] = true;
+    getFileNameForTypeInFormat(type, format, copyName);
+    getIndexFileNamesOfType(type, format, indexCopyNames);
+    getTableHeaderFileName(type, format, headerCopyName);
+    tableIsCopiedForTransaction[format][type] = false;
+    getFileNameForTypeInFormat(type, format, fileName);
+    int indexCount = getIndexFileNamesOfType(type, format, indexNames);
+    getTableHeaderFileName(type, format, headerName);
+    for (int i = 0; i < indexCount; i++) { rename(indexCopyNames[i], indexNames[i]); }
+    rename(headerCopyName, headerName);
+    rename(copyName, fileName);
+    tableFileChanged(format, type);
+}
+
+void removeTransactionCopies() {
+    // Removes the copies of the files and their indexes, copies are not used any more, i.e. transaction failed.
+    char copyName[255], headerCopyName[255]; char indexCopyNames[INDEX_COUNT_LIMIT][255];
+    for (int format = 0; format < 2; format++) {
+        for (int type = 0; type < 4; type++) {
+            bool isCopied = tableIsCopiedForTransaction[format][type];
+            tableIsCopiedForTransaction[format][type] = true;
+            getFileNameForTypeInFormat(type, format, copyName);
+            int indexCount = getIndexFileNamesOfType(type, format, indexCopyNames);
+            getTableHeaderFileName(type, format, headerCopyName);
+            tableIsCopiedForTransaction[format][type] = false;
+            remove(copyName); remove(headerCopyName);
+            for (int i = 0; i < indexCount; i++) { remove(indexCopyNames[i]); }
+            // Indexes opened on the copies are closed, they are opened again on the original files.
+            if (isCopied && format == (int)databaseFormat) { closeIndexesOfType(type); }
+        }
+    }
+}
+
+void replaceTablesWithTransactionCopies() {
+    // Flushes the copies, logs their replacement with one record, and then replaces the files with them.
+    LoggedOperation replacement = { NULL, 0, 0 };
+    checkpointLog(); // Writes logged during the transaction, i.e. counts of an old binary header, are not replayed on the copies.
+    for (int type = 0; type < 4; type++) {
+        if (!tableIsCopiedForTransaction[databaseFormat][type]) { continue; }
+        char copyName[255];
+        getFileNameForType(type, copyName);
+        int descriptor = open(copyName, O_RDONLY);
+        if (descriptor >= 0) { fsync(descriptor); close(descriptor); }
+        addLoggedWrite(&replacement, databaseFormat, type, -1, NULL, 0);
+    }
+    commitLoggedWrites(&replacement);
+    clearLoggedOperation(&replacement);
+    int directory = open(".", O_RDONLY);
+    if (directory >= 0) { fsync(directory); close(directory); }
+    checkpointLog();
+}
+
+// MARK: Committing transactions
+
+bool applyTransactionStep(TransactionStep *step) {
+    switch (step->kind) {
+        case AddStep: return addItemBase(step->item, false);
+        case RemoveStep: return removeItemBase(step->item, false);
+        case UpdateStep: return updateItemBase(step->item, step->updatedVersion, true);
+        case RegisterStep:
+            return registerStudentForCourseBase(step->item.value.registration.courseCode, step->item.value.registration.studentNumber,
+                                                step->maxCount, step->maxCredit, false);
+    }
+    return false;
+}
+
+bool commitTransaction() {
+    // Applies the steps of the transaction in order, returns false if a step failed and none of them are applied.
+    if (!transaction.isOpen) { printf("ERROR: Couldn't commit the transaction. There is no open transaction.\n"); return false; }
+    checkpointLog(); // Log shouldn't have writes of the files that are going to be replaced.
+    transaction.isApplying = true;
+    int failedStep = -1;
+    for (int i = 0; i < transaction.count && failedStep < 0; i++) {
+        if (!applyTransactionStep(&transaction.steps[i])) { failedStep = i; }
+    }
+    if (failedStep < 0) {
+        replaceTablesWithTransactionCopies();
+    } else {
+        removeTransactionCopies();
+        printf("ERROR: Transaction is aborted, because operation %d of %d failed. None of its operations are applied.\n",
+               failedStep + 1, transaction.count);
+    }
+    clearTransaction();
+    return failedStep < 0;
+}
+
+// MARK: - ADDING 'Item' TO THE DATABASE
+
+// MARK: Encoding functions
+
+/* These functions are used as a subroutine for writing instances to a file in database.
+ Adding Registration record to database is handled separately, but it uses the same encoding functions.
+ If function's are called as a subroutine of UPDATE operation, then no message are printed
+ if they get called as a subroutine of ADD operation, then message is printed. */
+
+void encodeItemAsText(Item item, FILE *file) {
+    // Writes 'item' to 'file' in text format, one "Key: value" line for every property and an empty line after the record.
+    Instructor instructor = item.value.instructor;
+    Course course = item.value.course;
+    Student student = item.value.student;
+    Registration registration = item.value.registration;
+    switch (item.type) {
+        case InstructorType:
+            fprintf(file, "ID: %d\n", instructor.ID);
+            fprintf(file, "Name: %s\n", instructor.name);
+            fprintf(file, "Surname: %s\n", instructor.surname);
+            fprintf(file, "Title: %s\n\n", instructor.title); return;
+        case CourseType:
+            fprintf(file, "Course code: %s\n", course.code);
+            fprintf(file, "Course name: %s\n", course.name);
+            fprintf(file, "Credit: %d\n", course.credit);
+            fprintf(file, "Quota: %d/%d\n", course.quota.registered, course.quota.total);
+            fprintf(file, "Instructor ID: %d\n\n", course.instructorID); return;
+        case StudentType:
+            fprintf(file, "Student number: %d\n", student.studentNumber);
+            fprintf(file, "Name: %s\n", student.name);
+            fprintf(file, "Surname: %s\n", student.surname);
+            fprintf(file, "Number of courses registered: %d\n", student.numberOfCoursesRegistered);
+            fprintf(file, "Number of credits taken: %d\n\n", student.numberOfCreditsTaken); return;
+        case RegistrationType:
+            fprintf(file, "ID: %d\n", registration.ID);
+            fprintf(file, "Course code: %s\n", registration.courseCode);
+            fprintf(file, "Student number: %d\n", registration.studentNumber);
+            fprintf(file, "Still registered: %s\n", (registration.stillRegistered) ? "True " : "False");
+            fprintf(file, "Registration date: %s\n\n", registration.date); return;
+    }
+}
+
+void printAdditionMessage(Item item) {
+    // Registrations print their own message after the registration process.
+    switch (item.type) {
+        case InstructorType:
+            printf("Added the instructor '%s %s %s' with ID: %d.\n", item.value.instructor.title, item.value.instructor.name,
+                   item.value.instructor.surname, item.value.instructor.ID); return;
+        case CourseType: printf("Added the course '%s %s'.\n", item.value.course.code, item.value.course.name); return;
+        case StudentType: printf("Added the student '%s %s'.\n", item.value.student.name, item.value.student.surname); return;
+        case RegistrationType: return;
+    }
+}
+
+long appendItemToTable(Item item) {
+    /* Appends the record of 'item' to the database file of its type, in the current format of the database, and
+     counts it in the header of the file in the same logged operation. Returns the offset of the record, indexes of
+     the file are synchronized before it is changed. */
+    long offset = 0;
+    beginLoggedOperation();
+    prepareTableForChange(item.type);
+    if (databaseFormat == BinaryFormat) {
+        unsigned char record[MAX_RECORD_SIZE];
+        encodeItemToRecord(item, record);
+        offset = appendToTable(item.type, record, getRecordSizeForType(item.type));
+    } else {
+        char *text = NULL; size_t length = 0;
+        FILE *stream = open_memstream(&text, &length);
+        if (stream == NULL) { printf("EXCEPTION: Couldn't open a memory stream in 'appendItemToTable' function.\n"); exit(1); }
+        encodeItemAsText(item, stream); fclose(stream);
+        offset = appendToTable(item.type, text, length);
+        free(text);
+    }
+    tableHeaderChanged(item.type, 1, 0);
+    commitLoggedOperation();
+    return offset;
+}
+
+// MARK: Update counters in place
+
+/* Every registration changes the quota of a course, and the course count and credits of a student. Instead of
+ removing the record and adding it again, these counters are overwritten where they are. In binary format counters
+ have fixed width, so they are always overwritten in place. In text format a counter line is overwritten only if its
+ length doesn't change, i.e. 'Quota: 9/10' can't become 'Quota: 10/10' in place, then the record is marked as
+ removed and its updated version is appended to the end of the file. */
+
+int getCounterLinesOfItem(Item item, int *lineNumbers, char lines[][255]) {
+    // Assigns the text lines of the counters of 'item', and the line numbers of them in a record. Returns the number of counters.
+    switch (item.type) {
+        case CourseType:
+            lineNumbers[0] = 3; sprintf(lines[0], "Quota: %d/%d\n", item.value.course.quota.registered, item.value.course.quota.total);
+            return 1;
+        case StudentType:
+            lineNumbers[0] = 3; sprintf(lines[0], "Number of courses registered: %d\n", item.value.student.numberOfCoursesRegistered);
+            lineNumbers[1] = 4; sprintf(lines[1], "Number of credits taken: %d\n", item.value.student.numberOfCreditsTaken);
+            return 2;
+        default: return 0;
+    }
+}
+
+bool overwriteCountersOfTextRecord(Item updatedVersion, FILE *file, long offset) {
+    // Lines of the record are read from 'file', and the counter lines are written with 'writeToTable'.
+    int lineNumbers[2]; char lines[2][255]; char buffer[255];
+    long lineOffsets[6]; size_t lineLengths[6];
+    int counterCount = getCounterLinesOfItem(updatedVersion, lineNumbers, lines);
+    if (counterCount == 0) { return false; }
+    fseek(file, offset, SEEK_SET);
+    for (int i = 0; i <= lineNumbers[counterCount-1]; i++) {
+        lineOffsets[i] = ftell(file);
+        if (fgets(buffer, 255, file) == NULL) { return false; }
+        lineLengths[i] = strlen(buffer);
+    }
+    for (int i = 0; i < counterCount; i++) {
+        if (strlen(lines[i]) != lineLengths[lineNumbers[i]]) { return false; }
+    }
+    for (int i = 0; i < counterCount; i++) {
+        writeToTable(updatedVersion.type, lineOffsets[lineNumbers[i]], lines[i], strlen(lines[i]));
+    }
+    return true;
+}
+
+bool overwriteCountersOfRecord(Item item, Item updatedVersion, long offset) {
+    // Overwrites the counters of the record at 'offset' with the counters of 'updatedVersion', returns false if they can't be overwritten in place.
+    bool overwritten = true;
+    prepareTableForChange(item.type);
+    FILE *file = openTableStream(item.type);
+    if (file == NULL) { return false; }
+    if (databaseFormat == BinaryFormat) {
+        unsigned char record[MAX_RECORD_SIZE];
+        const char *counterFields[] = { "registered", "numberOfCoursesRegistered", "numberOfCreditsTaken" };
+        encodeItemToRecord(updatedVersion, record);
+        for (int i = 0; i < 3; i++) {
+            int fieldOffset = getBinaryFieldOffset(item.type, counterFields[i]);
+            if (fieldOffset < 0) { continue; }
+            writeToTable(item.type, offset + fieldOffset, record + fieldOffset, sizeof(int32_t));
+        }
+    } else {
+        overwritten = overwriteCountersOfTextRecord(updatedVersion, file, offset);
+    }
+    fclose(file);
+    if (overwritten) { indexItemChanged(item, updatedVersion, offset); }
+    return overwritten;
+}
+
+void relocateRecord(Item item, Item updatedVersion, long offset) {
+    /* Marks the record of 'item' at 'offset' as removed, and appends 'updatedVersion' to the end of the file in the
+     same logged operation. Unlike removing the item and adding it again, it doesn't read the file after changing it,
+     so it can be a part of an operation whose writes are not applied yet. */
+    beginLoggedOperation();
+    removeRecordAtOffset(item, offset);
+    long newOffset = appendItemToTable(updatedVersion);
+    indexItemAdded(updatedVersion, newOffset);
+    commitLoggedOperation();
+    compactTableIfNeeded(item.type);
+}
+
+void updateCountersOfItem(Item item, Item updatedVersion) {
+    // Changes the counters of 'item' to the counters of 'updatedVersion', other properties of them should be the same.
+    long offset = -1;
+    if (!findOffsetOfItemInDatabase(item, &offset)) { updateItemSilently(item, updatedVersion); return; }
+    if (!overwriteCountersOfRecord(item, updatedVersion, offset)) { relocateRecord(item, updatedVersion, offset); }
+}
+
+// MARK: Add Item
+
+void updateStudentsCreditStatus(int studentNumber, bool registerationAdded, int credit, bool changeCourseCount) {
+    // Helper function for updating students credit status. Assumes student is in database.
+    int count = (registerationAdded) ? 1 : -1; credit = (registerationAdded) ? credit : -credit;
+    Item studentToUpdate = getItem(wrapStudentWithStudentNumber(studentNumber));
+    Item updatedVersion = studentToUpdate;
+    if (changeCourseCount) {
+        updatedVersion.value.student.numberOfCoursesRegistered += count;
+    }
+    updatedVersion.value.student.numberOfCreditsTaken += credit;
+    updateCountersOfItem(studentToUpdate, updatedVersion); freeItem(studentToUpdate);
+}
+
+void updateCourseQuota(char *courseCode, bool studentAdded) {
+    // Updates the quota of the course. Assumes course is in database.
+    Item course = getItem(wrapCourseWithCode(courseCode));
+    course.value.course.quota.registered += (studentAdded) ? 1 : -1;
+    updateCountersOfItem(course, course); freeItem(course);
+}
+
+void prepareForAppend(Item item, char *error, char *error2) {
+    /* Convenience function for adding an Item to the database. This function assigns error messages to pointers
+     passed as parameters, according to the type of the 'item'. Adding 'Registration' record is handled separately. */
+    switch (item.type) {
+        case InstructorType:
+            sprintf(error, "ERROR: Couldn't add the instructor. There is already an instructor with the same ID: %d.\n", item.value.instructor.ID);
+            break;
+        case CourseType:
+            sprintf(error, "ERROR: Couldn't add the course. There is already a course with the same course code: %s.\n", item.value.course.code);
+            sprintf(error2, "ERROR: Couldn't add the course. There is no instructor with the ID: %d.\n", item.value.course.instructorID);
+            break;
+        case StudentType:
+            sprintf(error, "ERROR: Couldn't add the student. There is already a student with the number: %d.\n", item.value.student.studentNumber);
+            break;
+        case RegistrationType: return; // Registrations handled separately.
+    }
+}
+
+bool addItemBase(Item item, bool forUpdate) {
+    /* This function adds 'item' to the database.
+     This function, first checks whether 'item' is already in database or not.
+     Also, if Item's type is 'CourseType', then function checks whether course's instructor
+     is in database or not. If all conditions are met, 'item' is added in database. Returns whether 'item' is added. */
+    Arena arena = EMPTY_ARENA; bool isAdded = false;
+    char *error = allocateFromArena(&arena, sizeof(char)*511);
+    char *error2 = allocateFromArena(&arena, sizeof(char)*511);
+    prepareForAppend(item, error, error2);
+    if (itemIsInDatabase(item)) {
+        printf("%s", error);
+    } else if (item.type == CourseType && !itemIsInDatabase(wrapInstructorWithID(item.value.course.instructorID))) {
+        printf("%s", error2);
+    } else {
+        // A new course is given an ID in binary format, an updated course keeps its ID, see 'COURSE CODE DICTIONARY'.
+        beginLoggedOperation();
+        if (item.type == CourseType && !forUpdate && databaseFormat == BinaryFormat) { item.value.course.ID = (int)allocateTableID(CourseType); }
+        long offset = appendItemToTable(item);
+        if (!forUpdate) { printAdditionMessage(item); }
+        indexItemAdded(item, offset); isAdded = true;
+        commitLoggedOperation();
+    }
+    releaseArena(&arena);
+    return isAdded;
+}
+
+/* If 'addItemBase' function should print success message, then its 'forUpdate' parameter
+ should be false, otherwise it should be true. Functions below are just convenience functions for calling
+ 'addItemBase' function. In a transaction, 'addItem' buffers the addition until the transaction is committed. */
+
+void addItem(Item item) {
+    if (!bufferTransactionStep(AddStep, item, item, 0, 0)) { addItemBase(item, false); }
+}
+void addItemAsAPartOfUpdateProcess(Item item) { addItemBase(item, true); }
+
+// MARK: Registering student for a course
+
+void getDateForRegistration(char *date) {
+    // Helper function for adding date to 'Registration' record.
+    time_t t = time(NULL);
+    struct tm time = *localtime(&t);
+    sprintf(date, "%d-%02d-%02d %02d:%02d:%02d", time.tm_year + 1900, time.tm_mon + 1, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
+}
+
+bool registerStudentForCourseBase(char *courseCode, int studentNumber, int MAX_COUNT, int MAX_CREDIT, bool forUpdate) {
+    /* Registers student with given 'studentNumber', for the course with given 'courseCode'.
+     If course is not in database, or student is not in database, or student is already registered for more courses
+     than he/she should have registered, or student is already taken more credits than he/she should have taken, or student is
+     already registered for the same course then error is thrown and process failed. Otherwise, registration record is added to
+     the database, and student's status is updated. Returns whether student is registered. */
+    bool isRegistered = false;
+    Course course = getItem(wrapCourseWithCode(courseCode)).value.course; bool shouldClearCourse = true;
+    Student student = getItem(wrapStudentWithStudentNumber(studentNumber)).value.student; bool shouldClearStudent = true;
+    Item registration = getItem(wrapRegistrationWithStudentNumberAndCourseCode(studentNumber, courseCode));
+    if (!itemIsInDatabase(wrapCourse(course))) {
+        shouldClearCourse = false;
+        printf("ERROR: Couldn't register for course. There is no course with code: %s.\n", course.code);
+    } else if (!itemIsInDatabase(wrapStudent(student))) {
+        shouldClearStudent = false;
+        printf("ERROR: Couldn't register for course. There is no student with student number: %d.\n", student.studentNumber);
+    } else if (student.numberOfCoursesRegistered >= MAX_COUNT) {
+        printf("ERROR: Couldn't register for course. '%s %s' is already registered in %d courses "
+               "which is the maximum number of courses a student can register on a quarter.\n", student.name, student.surname, student.numberOfCoursesRegistered);
+    } else if (student.numberOfCreditsTaken + course.credit > MAX_CREDIT) {
+        printf("ERROR: Couldn't register for course. Maximum number of credits exceeded. A student can \n"
+               "take maximum of %d credits in a quarter and '%s %s' takes %d credits already, and course \n"
+               "he/she wants to register for is %d credits worth.\n",
+               MAX_CREDIT, student.name, student.surname, student.numberOfCreditsTaken, course.credit);
+    } else if (course.quota.total - course.quota.registered == 0) {
+        printf("ERROR: Couldn't register for course, quota of course is exceeded.\n");
+    } else if (itemIsInDatabase(registration)) {
+        printf("ERROR: Couldn't register for course. %s %s already registered for %s %s.\n", student.name, student.surname, course.code, course.name); freeItem(registration);
+    } else {
+        char *date = malloc(sizeof(char)*20);
+        if (date == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'registerStudentForCourseBase' function.\n"); exit(1); }
+        getDateForRegistration(date);
+        // Registration record, and the counters of the student and the course are written as one logged operation.
+        beginLoggedOperation(); isRegistered = true;
+        Registration newRegistration = { (int)allocateTableID(RegistrationType), student.studentNumber, course.code, true, date };
+        long offset = appendItemToTable(wrapRegistration(newRegistration));
+        indexItemAdded(wrapRegistration(newRegistration), offset);
+        free(date);
+        if (!forUpdate) {
+            /* If we use this function as a part of UPDATE operation, then quota and credit shouldn't get updated
+             also no success message should get printed. */
+            updateStudentsCreditStatus(studentNumber, true, course.credit, true);
+            updateCourseQuota(courseCode, true);
+        }
+        commitLoggedOperation();
+        if (!forUpdate) {
+            printf("Successfully registered %s %s for the course %s %s\n", student.name, student.surname, course.code, course.name);
+        }
+    }
+    if (shouldClearCourse) { freeItem(wrapCourse(course)); }
+    if (shouldClearStudent) { freeItem(wrapStudent(student)); }
+    return isRegistered;
+}
+
+/* If 'registerStudentForCourseBase' function should print success message, then its 'forUpdate' parameter
+ should be false, otherwise it should be true. Functions below are just convenience functions for calling
+ 'registerStudentForCourseBase' function. */
+
+void registerStudentForCourse(char *courseCode, int studentNumber, int MAX_COUNT, int MAX_CREDIT) {
+    Item registration = wrapRegistrationWithStudentNumberAndCourseCode(studentNumber, courseCode);
+    if (!bufferTransactionStep(RegisterStep, registration, registration, MAX_COUNT, MAX_CREDIT)) {
+        registerStudentForCourseBase(courseCode, studentNumber, MAX_COUNT, MAX_CREDIT, false);
+    }
+}
+
+// MARK: - REMOVING 'Item' FROM DATABASE
+
+void prepareForRemoval(Item item, char *fileName, char *error, char *success) {
+    /* Convenience function for removing an Item from database. This function assigns error message, success message
+     and file name, to pointers passed as parameters, according to the type of the 'item'. */
+    getFileNameForType(item.type, fileName);
+    switch (item.type) {
+        case InstructorType:
+            sprintf(error, "ERROR: Couldn't remove the instructor. There is no instructor with the ID: %d.\n", item.value.instructor.ID) ;
+            sprintf(success, "Removed the instructor '%s %s %s' with ID: %d.\n",item.value.instructor.title,
+                    item.value.instructor.name, item.value.instructor.surname, item.value.instructor.ID); return;
+        case CourseType:
+            sprintf(error, "ERROR: Couldn't remove the course. There is no course with the course code: %s.\n", item.value.course.code) ;
+            sprintf(success, "Removed the course '%s %s'.\n", item.value.course.code, item.value.course.name); return;
+        case StudentType:
+            sprintf(error, "ERROR: Couldn't remove the student. There is no student with the student number: %d.\n", item.value.student.studentNumber) ;
+            sprintf(success, "Removed the student '%s %s'.\n", item.value.student.name, item.value.student.surname); return;
+        case RegistrationType:
+            sprintf(error, "ERROR: Couldn't remove the registration.\n") ;
+            sprintf(success, "Removed the registration.\n"); return;
+    }
+}
+
+void invalidateRegistrationAtOffset(Item registration, long offset) {
+    /* Overwrites "False" on "True " of the registration record at 'offset', or zero on its 'stillRegistered' field in binary
+     format. In binary format, current code of its course is also written, since it isn't decoded from the course ID any more. */
+    prepareTableForChange(RegistrationType);
+    if (databaseFormat == BinaryFormat) {
+        int32_t notRegistered = 0; unsigned char code[CODE_LENGTH]; int cursor = 0;
+        putString(code, &cursor, CODE_LENGTH, registration.value.registration.courseCode);
+        writeToTable(RegistrationType, offset + getBinaryFieldOffset(RegistrationType, "courseCode"), code, CODE_LENGTH);
+        writeToTable(RegistrationType, offset + getBinaryFieldOffset(RegistrationType, "stillRegistered"), &notRegistered, sizeof(int32_t));
+    } else {
+        char buffer[255];
+        FILE *file = openTableStream(RegistrationType);
+        if (file == NULL) { printf("ERROR: Couldn't open the file of registrations.\n"); return; }
+        fseek(file, offset, SEEK_SET);
+        for (int i = 0; i < 4; i++) { fgets(buffer, 255, file); }
+        long position = ftell(file)-6; fclose(file);
+        writeToTable(RegistrationType, position, "False\n", 6);
+    }
+    Item invalidated = registration; invalidated.value.registration.stillRegistered = false;
+    indexItemChanged(registration, invalidated, offset);
+}
+
+void removeRecordAtOffset(Item item, long offset) {
+    /* Marks the record of 'item' at 'offset' as removed, by overwriting '#' on the first character of the record,
+     or zero on its status field in binary format. Removed record stays in the file as a tombstone, which is
+     skipped by every reader of the file, until the file is compacted. Counts in the header of the file are
+     changed in the same logged operation. */
+    beginLoggedOperation();
+    prepareTableForChange(item.type);
+    if (databaseFormat == BinaryFormat) {
+        int32_t status = RecordRemoved;
+        writeToTable(item.type, offset, &status, sizeof(int32_t));
+    } else {
+        char tombstone = TEXT_TOMBSTONE;
+        writeToTable(item.type, offset, &tombstone, 1);
+    }
+    tableHeaderChanged(item.type, -1, 1); indexItemRemoved(item, offset);
+    commitLoggedOperation();
+}
+
+bool removeItemBase(Item item, bool forUpdate) {
+    /* Removes the 'item' from the database, if it is in the database.
+     If item's type is 'RegistrationType', then when record found in database,
+     'Still registered: True ' expression changed with 'Still registered: False'.
+     If item's type is different than 'RegistrationType', then record is marked as removed where it is, with
+     'removeRecordAtOffset', so nothing else in the file is written. Removed records are reclaimed together by
+     'compactTableIfNeeded', when they make up enough of the file. Returns whether 'item' is removed. */
+    Arena arena = EMPTY_ARENA; // Scratch memory of the removal, released in one step.
+    char *fileName = allocateFromArena(&arena, sizeof(char)*255);
+    char *error = allocateFromArena(&arena, sizeof(char)*511);
+    char *success = allocateFromArena(&arena, sizeof(char)*511);
+    
+    item = getItem(item); // 'item' might be an artificial instance, so we have to get the rest of the information about 'item'.
+    
+    prepareForRemoval(item, fileName, error, success);
+    
+    long offset = -1;
+    if (!itemIsInDatabase(item) || !findOffsetOfItemInDatabase(item, &offset)) { printf("%s\n", error); releaseArena(&arena); return false; }
+    
+    if (item.type == RegistrationType) {
+        // Invalidation of a registration, and the counters it changes are written as one logged operation.
+        beginLoggedOperation(); invalidateRegistrationAtOffset(item, offset);
+    } else {
+        removeRecordAtOffset(item, offset); compactTableIfNeeded(item.type);
+    }
+    
+    if (!forUpdate) {
+        // Make necessary changes in database after removal, if item is not removed as a part of an update process.
+        printf("%s", success);
+        Course course;
+        switch (item.type) {
+            case InstructorType:
+                /* If removed item is of type InstructorType, then remove all the courses associated with the
+                 deleted instructor's instructorID, this also going to trigger all registrations that associated
+                 with courses given by this instructor, to get cancelled. */
+                removeCoursesGivenByInstructor(item); break;
+            case RegistrationType:
+                /* If removed item is of type RegistrationType, then student's credit value
+                 and course's quota value should get updated according to the registration. */
+                course = getItem(wrapCourseWithCode(item.value.registration.courseCode)).value.course;
+                updateStudentsCreditStatus(item.value.registration.studentNumber, false, course.credit, true);
+                updateCourseQuota(course.code, false); freeItem(wrapCourse(course)); break;
+            default:
+                /* This will invalidate all registrations associated with 'item'. If 'item' is of type CourseType,
+                 then all registrations with the same course code as 'item' will be removed, if 'item' is of type StudentType,
+                 then all registrations made with the same studentNumber will be removed from the database. */
+                invalidateRegistrationsAfterCourseOrStudentRemoval(item); break;
+        }
+    }
+    if (item.type == RegistrationType) { commitLoggedOperation(); }
+    releaseArena(&arena); freeItem(item);
+    return true;
+}
+
+/* If 'removeItemBase' function should print success message, then its 'forUpdate' parameter
+ should be false, otherwise it should be true. Functions below are just convenience functions for calling
+ 'removeItemBase' function. */
+
+void removeItem(Item item) {
+    if (!bufferTransactionStep(RemoveStep, item, item, 0, 0)) { removeItemBase(item, false); }
+}
+void removeItemAsAPartOfUpdateProcess(Item item) { removeItemBase(item, true); }
+
+// MARK: - UPDATING 'Item'
+
+void prepareForUpdate(Item itemToBeUpdated, Item updatedVersion, bool *uniqueIdentifierHasChanged, char *error1, char *error2) {
+    /* Convenience function for updating an Item. This function assigns error messages, and whether item's unique identifier
+     has changed with update or not, to pointers passed as parameters, according to the type of the items. */
+    switch (itemToBeUpdated.type) {
+        case InstructorType:
+            *uniqueIdentifierHasChanged = itemToBeUpdated.value.instructor.ID != updatedVersion.value.instructor.ID;
+            sprintf(error2, "Update failed. There is already an instructor with the ID: %d.\n", updatedVersion.value.instructor.ID);
+            sprintf(error1, "ERROR: Update failed. Couldn't find the instructor to be updated.\n"); return;
+        case CourseType:
+            *uniqueIdentifierHasChanged = strcmp(itemToBeUpdated.value.course.code, updatedVersion.value.course.code) != 0;
+            sprintf(error2, "ERROR: Update failed. There is already a course with the same code: %s.\n", updatedVersion.value.course.code);
+            sprintf(error1, "ERROR: Update failed. Couldn't find the course to be updated.\n"); return;
+        case StudentType:
+            *uniqueIdentifierHasChanged = itemToBeUpdated.value.student.studentNumber != updatedVersion.value.student.studentNumber;
+            sprintf(error2, "ERROR: Update failed. There is already a student with student number: %d.\n", updatedVersion.value.student.studentNumber);
+            sprintf(error1, "ERROR: Update failed. Couldn't find the student to be updated %d.\n", itemToBeUpdated.value.student.studentNumber); return;
+        case RegistrationType: return;
+    }
+}
+
+bool updateItemBase(Item itemToBeUpdated, Item updatedVersion, bool printMessage) {
+    /* Changes the record of 'itemToBeUpdated' with 'updatedVersion'. If unique identifier
+     of the item has changed, i.e. course code of a course, than all records that uses that
+     information gets updated, i.e. registrations that have old course code are changed to have
+     new course code, they keep their IDs and dates.
+     Returns whether item is updated. */
+    Arena arena = EMPTY_ARENA;
+    char *error1 = allocateFromArena(&arena, sizeof(char)*511);
+    char *error2 = allocateFromArena(&arena, sizeof(char)*511);
+    bool uniqueIdentifierHasChanged = false; bool isUpdated = false;
+    prepareForUpdate(itemToBeUpdated, updatedVersion, &uniqueIdentifierHasChanged, error1, error2);
+    
+    // If 'itemToBeUpdated' is not in database, throw error
+    if (!itemIsInDatabase(itemToBeUpdated)) { printf("%s", error1); }
+    // If 'updatedVersion's unique identifier is already used by a record in database, throw error
+    else if (uniqueIdentifierHasChanged && itemIsInDatabase(updatedVersion)) {
+        printf("%s", error2);
+    } else if (itemToBeUpdated.type == CourseType && !itemIsInDatabase(wrapInstructorWithID(updatedVersion.value.course.instructorID))) {
+        printf("ERROR: Update failed. There is no instructor with the ID: %d\n", updatedVersion.value.course.instructorID);
+    } else {
+        int difference = 0; isUpdated = true; long offset = -1;
+        Item item = getItem(itemToBeUpdated); // 'itemToBeUpdated' might be an artificial instance.
+        if (itemToBeUpdated.type == CourseType) {
+            // Updated course keeps the ID of the course, so its registrations still refer to it.
+            updatedVersion.value.course.ID = item.value.course.ID;
+            if (printMessage) {
+                difference = updatedVersion.value.course.credit - item.value.course.credit;
+                updatedVersion.value.course.quota.registered = item.value.course.quota.registered;
+            }
+        } else if (printMessage && itemToBeUpdated.type == StudentType) {
+            updatedVersion.value.student.numberOfCoursesRegistered = item.value.student.numberOfCoursesRegistered;
+            updatedVersion.value.student.numberOfCreditsTaken = item.value.student.numberOfCreditsTaken;
+        }
+        // A renamed course or student and the new key of its registrations are committed in one logged operation.
+        bool renamesRegistrations = uniqueIdentifierHasChanged && (itemToBeUpdated.type == CourseType || itemToBeUpdated.type == StudentType);
+        if (renamesRegistrations) { beginLoggedOperation(); }
+        // Old record is marked as removed and the updated version is appended in one logged operation, so a crash can't lose the record.
+        if (findOffsetOfItemInDatabase(item, &offset)) { relocateRecord(item, updatedVersion, offset); }
+        freeItem(item);
+        if (printMessage) { printf("Updated succesfully!\n"); }
+        
+        // If unique identifier has changed for an item...
+        if (uniqueIdentifierHasChanged) {
+            switch (updatedVersion.type) {
+                case InstructorType:
+                    // If instructor's ID has changed, then reflect that change to course records.
+                    updateCoursesAfterInstructorIDChange(itemToBeUpdated, updatedVersion); break;
+                case CourseType:
+                    // If course's course code has changed, then reflect that change to registration records.
+                    updateRegistrationsAfterCourseOrStudentsUniqueKeyHasChanged(itemToBeUpdated, updatedVersion); break;
+                case StudentType:
+                    // If student's student number has changed, then reflect that change to registration records.
+                    updateRegistrationsAfterCourseOrStudentsUniqueKeyHasChanged(itemToBeUpdated, updatedVersion); break;
+                case RegistrationType: break; // There is nothing to update about registration records.
+            }
+        }
+        if (renamesRegistrations) { commitLoggedOperation(); compactTableIfNeeded(itemToBeUpdated.type); }
+        // If updated item is a Course item, and this course's credit has changed, then reflect that change to student records.
+        if (itemToBeUpdated.type == CourseType && (itemToBeUpdated.value.course.credit != updatedVersion.value.course.credit)) {
+            updateStudentsCreditIfCoursesCreditHasChanged(difference, updatedVersion);
+        }
+    }
+    releaseArena(&arena);
+    return isUpdated;
+}
+
+/* If 'updateItemBase' function should print success message, then its 'printMessage' parameter
+ should be false, otherwise it should be true. Functions below are just convenience functions for calling
+ 'updateItemBase' function. */
+
+void updateItem(Item itemToBeUpdated, Item updatedVersion) {
+    if (!bufferTransactionStep(UpdateStep, itemToBeUpdated, updatedVersion, 0, 0)) { updateItemBase(itemToBeUpdated, updatedVersion, true); }
+}
+
+void updateItemSilently(Item itemToBeUpdated, Item updatedVersion) {
+    updateItemBase(itemToBeUpdated, updatedVersion, false);
+}
+
+// MARK: - PREDICATES
+
+/* Queries used to need an 'aimFunction' that checked the fields of every record, and an artificial 'aimItem' to carry
+ the constants it compared them with. A 'Predicate' describes such a condition instead: a field compared with a
+ constant, or an AND or an OR of two predicates, i.e. registrations whose 'courseCode' is equal to "CS50" and whose
+ 'stillRegistered' is equal to 1. Fields are named like the fields of binary records, see 'BINARY RECORD FORMAT',
+ every field can be compared except the IDs of courses. A number field is compared with a number constant and a text
+ field with a text constant, and texts are compared like 'strcmp' does.
+ 
+ Scans evaluate a predicate on the bytes of a binary record or on the lines of a text record, before the record is
+ decoded, so a record that doesn't match is never decoded and none of its strings are copied, see 'FilteredRecordScanner'.
+ 'PredicateScanner' also uses an index when the predicate requires the key of the index to be equal to a constant. */
+
+typedef enum { IsEqualTo, IsNotEqualTo, IsLessThan, IsLessThanOrEqualTo, IsGreaterThan, IsGreaterThanOrEqualTo } Comparator;
+
+typedef enum { ComparisonPredicate, AndPredicate, OrPredicate } PredicateKind;
+
+typedef struct Predicate {
+    PredicateKind kind;
+    const char *field;
+    Comparator comparator;
+    int number;
+    const char *text; // NULL if the constant is a number.
+    const struct Predicate *left; // Operands of an AND or an OR.
+    const struct Predicate *right;
+} Predicate;
+
+typedef struct {
+    ItemType type;
+    const char *name;
+    bool isText;
+    int line; // Line of the field in a text record, and the key the line starts with.
+    const char *key;
+    size_t keyLength;
+    bool isWord;
+} PredicateField;
+
+const PredicateField predicateFields[] = {
+    { InstructorType, "ID", false, 0, TEXT_KEY("ID:"), true },
+    { InstructorType, "name", true, 1, TEXT_KEY("Name:"), true },
+    { InstructorType, "surname", true, 2, TEXT_KEY("Surname:"), true },
+    { InstructorType, "title", true, 3, TEXT_KEY("Title:"), true },
+    { CourseType, "code", true, 0, TEXT_KEY("Course code:"), true },
+    { CourseType, "name", true, 1, TEXT_KEY("Course name:"), false },
+    { CourseType, "credit", false, 2, TEXT_KEY("Credit:"), true },
+    { CourseType, "registered", false, 3, TEXT_KEY("Quota:"), true },
+    { CourseType, "total", false, 3, TEXT_KEY("Quota:"), true },
+    { CourseType, "instructorID", false, 4, TEXT_KEY("Instructor ID:"), true },
+    { StudentType, "studentNumber", false, 0, TEXT_KEY("Student number:"), true },
+    { StudentType, "name", true, 1, TEXT_KEY("Name:"), false },
+    { StudentType, "surname", true, 2, TEXT_KEY("Surname:"), false },
+    { StudentType, "numberOfCoursesRegistered", false, 3, TEXT_KEY("Number of courses registered:"), true },
+    { StudentType, "numberOfCreditsTaken", false, 4, TEXT_KEY("Number of credits taken:"), true },
+    { RegistrationType, "ID", false, 0, TEXT_KEY("ID:"), true },
+    { RegistrationType, "courseCode", true, 1, TEXT_KEY("Course code:"), true },
+    { RegistrationType, "studentNumber", false, 2, TEXT_KEY("Student number:"), true },
+    { RegistrationType, "stillRegistered", false, 3, TEXT_KEY("Still registered:"), true },
+    { RegistrationType, "date", true, 4, TEXT_KEY("Registration date:"), false }
+};
+
+typedef struct {
+    const unsigned char *bytes; // A binary record,
+    const TextLine *lines; // or the lines of a text record,
+    const Item *item; // or a decoded item.
+} PredicateRecord;
+
+typedef struct {
+    int number;
+    const char *text;
+    size_t length;
+} FieldValue;
+
+Predicate fieldComparedToNumber(const char *field, Comparator comparator, int number) {
+    Predicate predicate = { ComparisonPredicate, field, comparator, number, NULL, NULL, NULL }; return predicate;
+}
+
+Predicate fieldComparedToText(const char *field, Comparator comparator, const char *text) {
+    Predicate predicate = { ComparisonPredicate, field, comparator, 0, text, NULL, NULL }; return predicate;
+}
+
+Predicate bothOfPredicates(const Predicate *left, const Predicate *right) {
+    Predicate predicate = { AndPredicate, NULL, IsEqualTo, 0, NULL, left, right }; return predicate;
+}
+
+Predicate eitherOfPredicates(const Predicate *left, const Predicate *right) {
+    Predicate predicate = { OrPredicate, NULL, IsEqualTo, 0, NULL, left, right }; return predicate;
+}
+
+const PredicateField *findPredicateField(ItemType type, const char *name) {
+    for (size_t i = 0; i < sizeof(predicateFields)/sizeof(PredicateField); i++) {
+        if (predicateFields[i].type == type && strcmp(predicateFields[i].name, name) == 0) { return &predicateFields[i]; }
+    }
+    return NULL;
+}
+
+FieldValue textValue(const char *text) {
+    FieldValue value = { 0, text, (text != NULL) ? strlen(text) : 0 }; return value;
+}
+
+FieldValue numberValue(int number) {
+    FieldValue value = { number, NULL, 0 }; return value;
+}
+
+FieldValue valueOfItemField(const Item *item, const PredicateField *field) {
+    const char *name = field->name;
+    switch (item->type) {
+        case InstructorType: {
+            Instructor instructor = item->value.instructor;
+            if (strcmp(name, "ID") == 0) { return numberValue(instructor.ID); }
+            return textValue((strcmp(name, "name") == 0) ? instructor.name : (strcmp(name, "surname") == 0) ? instructor.surname : instructor.title);
+        }
+        case CourseType: {
+            Course course = item->value.course;
+            if (strcmp(name, "code") == 0) { return textValue(course.code); }
+            if (strcmp(name, "name") == 0) { return textValue(course.name); }
+            if (strcmp(name, "credit") == 0) { return numberValue(course.credit); }
+            if (strcmp(name, "registered") == 0) { return numberValue(course.quota.registered); }
+            if (strcmp(name, "total") == 0) { return numberValue(course.quota.total); }
+            return numberValue(course.instructorID);
+        }
+        case StudentType: {
+            Student student = item->value.student;
+            if (strcmp(name, "studentNumber") == 0) { return numberValue(student.studentNumber); }
+            if (strcmp(name, "name") == 0) { return textValue(student.name); }
+            if (strcmp(name, "surname") == 0) { return textValue(student.surname); }
+            if (strcmp(name, "numberOfCoursesRegistered") == 0) { return numberValue(student.numberOfCoursesRegistered); }
+            return numberValue(student.numberOfCreditsTaken);
+        }
+        case RegistrationType: {
+            Registration registration = item->value.registration;
+            if (strcmp(name, "ID") == 0) { return numberValue(registration.ID); }
+            if (strcmp(name, "courseCode") == 0) { return textValue(registration.courseCode); }
+            if (strcmp(name, "studentNumber") == 0) { return numberValue(registration.studentNumber); }
+            if (strcmp(name, "stillRegistered") == 0) { return numberValue(registration.stillRegistered); }
+            return textValue(registration.date);
+        }
+    }
+    return numberValue(0);
+}
+
+FieldValue valueOfBinaryField(const unsigned char *record, ItemType type, const PredicateField *field) {
+    // Fields are read from the bytes of the record like the decoding functions read them, but strings are not copied.
+    const BinaryField *schema = instructorSchema; int fieldCount = 0;
+    getSchemaForType(type, &schema, &fieldCount);
+    if (type == RegistrationType && strcmp(field->name, "courseCode") == 0) {
+        // An active registration has the current code of its course, see 'decodeRegistrationRecord'.
+        int statusCursor = getBinaryFieldOffset(type, "stillRegistered"), IDCursor = getBinaryFieldOffset(type, "courseID");
+        const char *code = (getInt32(record, &statusCursor) != 0) ? codeOfCourseID(getInt32(record, &IDCursor)) : NULL;
+        if (code != NULL) { return textValue(code); }
+    }
+    for (int i = 0; i < fieldCount; i++) {
+        if (strcmp(schema[i].name, field->name) != 0) { continue; }
+        int cursor = schema[i].offset;
+        if (schema[i].kind == StringField) {
+            FieldValue value = { 0, (const char*)record + cursor, strnlen((const char*)record + cursor, schema[i].width - 1) }; return value;
+        }
+        int number = getInt32(record, &cursor);
+        return numberValue((strcmp(field->name, "stillRegistered") == 0) ? number != 0 : number);
+    }
+    return numberValue(0);
+}
+
+FieldValue valueOfTextField(const TextLine *lines, const PredicateField *field) {
+    // Fields are found in the lines of the record like the parsing functions find them, but strings are not copied.
+    const char *end; const char *value = boundsOfTextValue(lines[field->line], field->key, field->keyLength, field->isWord, &end);
+    if (field->isText) { FieldValue textField = { 0, value, end - value }; return textField; }
+    if (strcmp(field->name, "stillRegistered") == 0) { return numberValue(!(end - value == 5 && memcmp(value, "False", 5) == 0)); }
+    int number = 0; const char *cursor = parseTextInteger(value, end, &number);
+    if (strcmp(field->name, "total") == 0) {
+        number = 0;
+        if (cursor < end && *cursor == '/') { parseTextInteger(cursor + 1, end, &number); }
+    }
+    return numberValue(number);
+}
+
+bool comparisonIsTrue(int order, Comparator comparator) {
+    switch (comparator) {
+        case IsEqualTo: return order == 0;
+        case IsNotEqualTo: return order != 0;
+        case IsLessThan: return order < 0;
+        case IsLessThanOrEqualTo: return order <= 0;
+        case IsGreaterThan: return order > 0;
+        case IsGreaterThanOrEqualTo: return order >= 0;
+    }
+    return false;
+}
+
+bool predicateMatches(const Predicate *predicate, ItemType type, PredicateRecord record) {
+    // Returns true if the record satisfies 'predicate', a NULL predicate matches every record.
+    if (predicate == NULL) { return true; }
+    if (predicate->kind == AndPredicate) { return predicateMatches(predicate->left, type, record) && predicateMatches(predicate->right, type, record); }
+    if (predicate->kind == OrPredicate) { return predicateMatches(predicate->left, type, record) || predicateMatches(predicate->right, type, record); }
+    const PredicateField *field = findPredicateField(type, predicate->field);
+    if (field == NULL || field->isText != (predicate->text != NULL)) { return false; } // Unknown fields and constants of another kind match nothing.
+    FieldValue value = (record.item != NULL) ? valueOfItemField(record.item, field)
+    : (record.bytes != NULL) ? valueOfBinaryField(record.bytes, type, field) : valueOfTextField(record.lines, field);
+    if (!field->isText) { return comparisonIsTrue((value.number > predicate->number) - (value.number < predicate->number), predicate->comparator); }
+    size_t constantLength = strlen(predicate->text), commonLength = (value.length < constantLength) ? value.length : constantLength;
+    int order = (value.text != NULL) ? memcmp(value.text, predicate->text, commonLength) : 0;
+    if (order == 0) { order = (value.length > constantLength) - (value.length < constantLength); }
+    return comparisonIsTrue(order, predicate->comparator);
+}
+
+bool binaryRecordMatches(const Predicate *predicate, ItemType type, const unsigned char *record) {
+    PredicateRecord predicateRecord = { record, NULL, NULL }; return predicateMatches(predicate, type, predicateRecord);
+}
+
+bool textRecordMatches(const Predicate *predicate, ItemType type, const TextLine *lines) {
+    PredicateRecord predicateRecord = { NULL, lines, NULL }; return predicateMatches(predicate, type, predicateRecord);
+}
+
+bool itemMatches(const Predicate *predicate, Item item) {
+    PredicateRecord predicateRecord = { NULL, NULL, &item }; return predicateMatches(predicate, item.type, predicateRecord);
+}
+
+// MARK: - GENERIC ITERATOR FUNCTION
+
+/*
+ 'ItemIterator' function is at the heart of many functionality.
+ Actually, all of the functionality below, is implemented using this function.
+ 
+ It takes three arguments:
+ - type: This parameter indicates which database file should be iterated on, and the type of the return value if needed.
+ - aimFunction: This is the function that is applied in every iteration.
+ - aimItem: This is passed as second parameter for aimFunction.
+ 
+ Basic strategy works like this: Assume we want to print every student that registered
+ for a course. Then we should call iterator with 'type' value of 'RegistarionType' because
+ we keep record of students that registered for some course in Registrations file.
+ On every iteration, we are going to have a decoded Registration item.
+ 'aimItem' should be the course that we want to print every student that registered for it.
+ And 'aimFunction' takes these two as its parameters, and does the following:
+ - Look whether decoded Registration item's course code is same with the aimItem's course code.
+ - If that's true, then print students information.
+ - If not, do nothing.
+ And 'aimFunction' returns 'OptionalItem'. But if we have an operation that doesn't need to return a value--like the one above,
+ we don't need to return any value for printing student information--'aimFunction' should return an 'OptionalItem' value that has
+ no value--its 'hasValue' bool should be false; otherwise, if 'aimFunction' returns an OptionalItem that has a value, then iteration stops.
+ 
+ With passing appropriate 'aimFunction' and appropriate 'aimItem' parameter values, we can make various types of operations
+ with the same strategy, for example listing every course given by a specific instructor, listing every course that a specific student registered for.
+ 
+ This function also can be used to get an actual 'Item' value--and is actually used in 'getItem' and 'itemIsInDatabase' functions.
+ If we need to return a value, then 'aimFunction' should set its 'hasValue' bool to true, this will cause 'ItemIterator' to return that 'OptionalItem'.
+ */
+
+void prepareForIteration(ItemType type, char *fileName, Item(**decodingFunction)(FILE*)) {
+    getFileNameForType(type, fileName);
+    switch (type) {
+        case InstructorType: *decodingFunction = readInstructorFromFile; return;
+        case CourseType: *decodingFunction = readCourseFromFile; return;
+        case StudentType: *decodingFunction = readStudentFromFile; return;
+        case RegistrationType: *decodingFunction = readRegistrationFromFile; return;
+    }
+}
+
+void prepareForTextParsing(ItemType type, Item(**textParsingFunction)(const TextLine*), int *lineCount) {
+    *lineCount = getTextRecordLineCount(type);
+    switch (type) {
+        case InstructorType: *textParsingFunction = parseInstructorLines; return;
+        case CourseType: *textParsingFunction = parseCourseLines; return;
+        case StudentType: *textParsingFunction = parseStudentLines; return;
+        case RegistrationType: *textParsingFunction = parseRegistrationLines; return;
+    }
+}
+
+void prepareForBinaryIteration(ItemType type, Item(**recordDecodingFunction)(const unsigned char*)) {
+    switch (type) {
+        case InstructorType: *recordDecodingFunction = decodeInstructorRecord; return;
+        case CourseType: *recordDecodingFunction = decodeCourseRecord; return;
+        case StudentType: *recordDecodingFunction = decodeStudentRecord; return;
+        case RegistrationType: synchronizeCourseDictionary(); *recordDecodingFunction = decodeRegistrationRecord; return; // Codes of courses are decoded from the dictionary.
+    }
+}
+
+/* 'ItemIterator' is built on 'RecordScanner', which visits every record of a file together with the offset of the
+ record in the file, removed records are skipped. Offsets are needed by indexes, so they can point to records.
+ Records are decoded in the arena of the scan, which is reset after every record, so the item passed to 'visitor' is
+ valid only until 'visitor' returns, and 'visitor' should copy it with 'copyItem' if it keeps it. 'visitor' returns
+ true to stop the scan. 'context' is passed to 'visitor' as it is. */
+
+Item decodeRecordInArena(Arena *arena, Item(*recordDecodingFunction)(const unsigned char*), const unsigned char *record) {
+    Arena *previous = setDecodingArena(arena);
+    Item item = recordDecodingFunction(record);
+    setDecodingArena(previous);
+    return item;
+}
+
+Item decodeTextRecordInArena(Arena *arena, Item(*decodingFunction)(FILE*), FILE *file) {
+    Arena *previous = setDecodingArena(arena);
+    Item item = decodingFunction(file);
+    setDecodingArena(previous);
+    return item;
+}
+
+Item parseTextLinesInArena(Arena *arena, Item(*textParsingFunction)(const TextLine*), const TextLine *lines) {
+    Arena *previous = setDecodingArena(arena);
+    Item item = textParsingFunction(lines);
+    setDecodingArena(previous);
+    return item;
+}
+
+void scanBinaryRecordsOfMapping(ItemType type, const MappedFile *mappedFile, size_t startOffset, size_t endOffset, const Predicate *predicate, bool(*visitor)(Item, long, void*), void *context) {
+    // Decodes the records between 'startOffset' and 'endOffset' of the mapping that match 'predicate', 'startOffset' should be the start of a record.
+    int recordSize = getRecordSizeForType(type); Arena arena = EMPTY_ARENA;
+    Item(*recordDecodingFunction)(const unsigned char*) = decodeInstructorRecord;
+    prepareForBinaryIteration(type, &recordDecodingFunction);
+    for (size_t offset = startOffset; offset + recordSize <= endOffset; offset += recordSize) {
+        if (!binaryRecordIsLive(mappedFile->base + offset) || !binaryRecordMatches(predicate, type, mappedFile->base + offset)) { continue; }
+        bool shouldStop = visitor(decodeRecordInArena(&arena, recordDecodingFunction, mappedFile->base + offset), (long)offset, context);
+        resetArena(&arena);
+        if (shouldStop) { break; }
+    }
+    releaseArena(&arena);
+}
+
+bool binaryMappingIsValid(ItemType type, const MappedFile *mappedFile) {
+    return mappedFile->length >= BINARY_HEADER_SIZE && checkBinaryHeader(type, mappedFile->base);
+}
+
+void scanBinaryRecordsFromMapping(ItemType type, const Predicate *predicate, bool(*visitor)(Item, long, void*), void *context) {
+    // Records are decoded straight from the mapping of the file.
+    MappedFile *mappedFile = acquireFileMapping(type, MADV_SEQUENTIAL);
+    if (mappedFile == NULL) { return; }
+    if (binaryMappingIsValid(type, mappedFile)) { scanBinaryRecordsOfMapping(type, mappedFile, BINARY_HEADER_SIZE, mappedFile->length, predicate, visitor, context); }
+    releaseFileMapping(mappedFile);
+}
+
+void scanBinaryRecordsFromBufferPool(ItemType type, const Predicate *predicate, bool(*visitor)(Item, long, void*), void *context) {
+    // Used when 'memoryMappedReads' is false, every record is copied from the pages of the file in the buffer pool in one go.
+    unsigned char header[BINARY_HEADER_SIZE];
+    unsigned char record[MAX_RECORD_SIZE];
+    int recordSize = getRecordSizeForType(type); Arena arena = EMPTY_ARENA;
+    Item(*recordDecodingFunction)(const unsigned char*) = decodeInstructorRecord;
+    prepareForBinaryIteration(type, &recordDecodingFunction);
+    if (!synchronizeBufferPool(type)) { return; }
+    if (readFromBufferPool(type, 0, header, BINARY_HEADER_SIZE) != BINARY_HEADER_SIZE || !checkBinaryHeader(type, header)) { return; }
+    for (long offset = BINARY_HEADER_SIZE; readFromBufferPool(type, offset, record, recordSize) == (size_t)recordSize; offset += recordSize) {
+        if (!binaryRecordIsLive(record) || !binaryRecordMatches(predicate, type, record)) { continue; }
+        bool shouldStop = visitor(decodeRecordInArena(&arena, recordDecodingFunction, record), offset, context);
+        resetArena(&arena);
+        if (shouldStop) { break; }
+    }
+    releaseArena(&arena);
+}
+
+void scanTextRecordsOfMapping(ItemType type, const MappedFile *mappedFile, size_t startOffset, size_t endOffset, const Predicate *predicate, bool(*visitor)(Item, long, void*), void *context) {
+    // Parses the records between 'startOffset' and 'endOffset' of the mapping that match 'predicate', 'startOffset' should be the start of a record.
+    Item(*textParsingFunction)(const TextLine*) = parseInstructorLines; int lineCount; Arena arena = EMPTY_ARENA;
+    prepareForTextParsing(type, &textParsingFunction, &lineCount);
+    const char *start = (const char*)mappedFile->base;
+    if (start == NULL) { return; }
+    const char *end = start + endOffset;
+    TextLine lines[MAX_TEXT_RECORD_LINES];
+    for (const char *cursor = start + startOffset; cursor < end;) {
+        long offset = cursor - start; bool isRemoved = *cursor == TEXT_TOMBSTONE;
+        cursor = splitTextLines(cursor, start + mappedFile->length, lines, lineCount);
+        if (isRemoved || !textRecordMatches(predicate, type, lines)) { continue; }
+        bool shouldStop = visitor(parseTextLinesInArena(&arena, textParsingFunction, lines), offset, context);
+        resetArena(&arena);
+        if (shouldStop) { break; }
+    }
+    releaseArena(&arena);
+}
+
+void scanTextRecords(ItemType type, const Predicate *predicate, bool(*visitor)(Item, long, void*), void *context) {
+    /* When 'memoryMappedReads' is true, records are parsed straight from the mapping of the file, and the lines of
+     removed records are skipped without parsing them. Otherwise the lines of every record are read through a stream
+     on the buffer pool, and like in a mapping, only the lines of the records that match 'predicate' are parsed. */
+    Arena arena = EMPTY_ARENA;
+    if (memoryMappedReads) {
+        MappedFile *mappedFile = acquireFileMapping(type, MADV_SEQUENTIAL);
+        if (mappedFile == NULL) { return; }
+        scanTextRecordsOfMapping(type, mappedFile, 0, mappedFile->length, predicate, visitor, context);
+        releaseFileMapping(mappedFile);
+    } else {
+        Item(*textParsingFunction)(const TextLine*) = parseInstructorLines; int lineCount;
+        char buffers[MAX_TEXT_RECORD_LINES][255]; TextLine lines[MAX_TEXT_RECORD_LINES];
+        prepareForTextParsing(type, &textParsingFunction, &lineCount);
+        FILE *file = openTableStream(type);
+        if (file != NULL) {
+            for (long offset = ftell(file); readTextLinesFromFile(file, buffers, lines, lineCount); offset = ftell(file)) {
+                if (lines[0].bytes[0] == TEXT_TOMBSTONE || !textRecordMatches(predicate, type, lines)) { continue; }
+                bool shouldStop = visitor(parseTextLinesInArena(&arena, textParsingFunction, lines), offset, context);
+                resetArena(&arena);
+                if (shouldStop) { break; }
+            }
+            fclose(file);
+        }
+    }
+    releaseArena(&arena);
+}
+
+void FilteredRecordScanner(ItemType type, const Predicate *predicate, bool(*visitor)(Item, long, void*), void *context) {
+    // Visits the records that match 'predicate', other records are not decoded, see 'PREDICATES'.
+    if (databaseFormat == TextFormat) { scanTextRecords(type, predicate, visitor, context); }
+    else if (memoryMappedReads) { scanBinaryRecordsFromMapping(type, predicate, visitor, context); }
+    else { scanBinaryRecordsFromBufferPool(type, predicate, visitor, context); }
+}
+
+void RecordScanner(ItemType type, bool(*visitor)(Item, long, void*), void *context) {
+    FilteredRecordScanner(type, NULL, visitor, context);
+}
+
+/* 'ParallelRecordScanner' visits the records of a mapped file like 'RecordScanner', but splits the file into
+ partitions of whole records and scans each of them in a thread of its own, so a scan of a big file is not limited by
+ one core. Partition 'i' is visited with 'contexts[i]', and a visitor that returns true stops only its partition.
+ Records are decoded into an arena of the thread, see 'decodingArena', so a visitor should only read shared state,
+ or change it atomically. Returns the number of partitions, which is at most 'maxPartitionCount'. If files are not
+ mapped to memory, or the file is small, all records are visited by the calling thread with 'contexts[0]'. */
+
+#define MIN_PARTITION_SIZE (1 << 20) // Bytes, smaller files are not worth a thread.
+
+typedef struct {
+    ItemType type;
+    const MappedFile *mappedFile;
+    size_t startOffset;
+    size_t endOffset;
+    bool(*visitor)(Item, long, void*);
+    void *context;
+} ScanPartition;
+
+void *scanPartition(void *context) {
+    ScanPartition *partition = context;
+    if (databaseFormat == TextFormat) { scanTextRecordsOfMapping(partition->type, partition->mappedFile, partition->startOffset, partition->endOffset, NULL, partition->visitor, partition->context); }
+    else { scanBinaryRecordsOfMapping(partition->type, partition->mappedFile, partition->startOffset, partition->endOffset, NULL, partition->visitor, partition->context); }
+    return NULL;
+}
+
+const char *firstTextKeys[4] = { "ID:", "Course code:", "Student number:", "ID:" };
+
+bool textRecordStartsAt(ItemType type, const MappedFile *mappedFile, size_t offset) {
+    /* Every line of a text record starts with the key of its property, so an empty property is a line with only its key,
+     and only the line after the record is empty. Strings can't have new lines, the loader skips them and the menu reads
+     one line for a string. Still, a record is taken to start after an empty line only if its first line has the key of
+     the first property, whose first character is the tombstone if the record is removed, and the line after it is empty. */
+    const char *base = (const char*)mappedFile->base;
+    const char *key = firstTextKeys[type]; size_t keyLength = strlen(key);
+    if (offset < 2 || base[offset-1] != '\n' || base[offset-2] != '\n') { return false; }
+    if (offset + keyLength > mappedFile->length || memcmp(base + offset + 1, key + 1, keyLength - 1) != 0) { return false; }
+    TextLine lines[MAX_TEXT_RECORD_LINES]; int lineCount = getTextRecordLineCount(type);
+    splitTextLines(base + offset, base + mappedFile->length, lines, lineCount);
+    return lines[lineCount-1].length == 0;
+}
+
+size_t startOfPartition(ItemType type, const MappedFile *mappedFile, size_t dataOffset, size_t offset) {
+    // Returns the start of the first record at or after 'offset', see 'textRecordStartsAt' for text records.
+    if (databaseFormat == BinaryFormat) {
+        size_t recordSize = getRecordSizeForType(type);
+        return dataOffset + (offset - dataOffset)/recordSize*recordSize;
+    }
+    while (offset < mappedFile->length && offset >= 2 && !textRecordStartsAt(type, mappedFile, offset)) { offset++; }
+    return offset;
+}
+
+int ParallelRecordScanner(ItemType type, bool(*visitor)(Item, long, void*), void **contexts, int maxPartitionCount) {
+    MappedFile *mappedFile = (memoryMappedReads) ? acquireFileMapping(type, MADV_SEQUENTIAL) : NULL;
+    if (mappedFile == NULL) { RecordScanner(type, visitor, contexts[0]); return 1; }
+    size_t dataOffset = (databaseFormat == BinaryFormat) ? BINARY_HEADER_SIZE : 0;
+    if (mappedFile->base == NULL || (databaseFormat == BinaryFormat && !binaryMappingIsValid(type, mappedFile))) { releaseFileMapping(mappedFile); return 1; }
+    long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t partitionCount = (processorCount < maxPartitionCount) ? (size_t)processorCount : (size_t)maxPartitionCount;
+    if (partitionCount > mappedFile->length/MIN_PARTITION_SIZE) { partitionCount = mappedFile->length/MIN_PARTITION_SIZE; }
+    if (partitionCount < 1) { partitionCount = 1; }
+    ScanPartition *partitions = malloc(partitionCount*sizeof(ScanPartition));
+    pthread_t *threads = malloc(partitionCount*sizeof(pthread_t)); bool *isStarted = malloc(partitionCount*sizeof(bool));
+    if (partitions == NULL || threads == NULL || isStarted == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'ParallelRecordScanner' function.\n"); exit(1); }
+    Item(*recordDecodingFunction)(const unsigned char*) = decodeInstructorRecord;
+    if (databaseFormat == BinaryFormat) { prepareForBinaryIteration(type, &recordDecodingFunction); } // Course dictionary is loaded before the threads share it.
+    selectVectorKernel();
+    size_t dataLength = mappedFile->length - dataOffset;
+    for (size_t i = 0; i < partitionCount; i++) {
+        ScanPartition partition = { type, mappedFile, startOfPartition(type, mappedFile, dataOffset, dataOffset + dataLength*i/partitionCount),
+            startOfPartition(type, mappedFile, dataOffset, dataOffset + dataLength*(i + 1)/partitionCount), visitor, contexts[i] };
+        if (i + 1 == partitionCount) { partition.endOffset = mappedFile->length; }
+        partitions[i] = partition;
+        // First partition is scanned by the calling thread, and so is a partition whose thread couldn't be started.
+        isStarted[i] = i > 0 && pthread_create(&threads[i], NULL, scanPartition, &partitions[i]) == 0;
+    }
+    for (size_t i = 0; i < partitionCount; i++) { if (!isStarted[i]) { scanPartition(&partitions[i]); } }
+    for (size_t i = 0; i < partitionCount; i++) { if (isStarted[i]) { pthread_join(threads[i], NULL); } }
+    free(partitions); free(threads); free(isStarted);
+    releaseFileMapping(mappedFile);
+    return (int)partitionCount;
+}
+
+typedef struct {
+    OptionalItem(*aimFunction)(Item, Item);
+    Item aimItem;
+    OptionalItem optionalItem;
+} ItemIteratorContext;
+
+bool itemIteratorVisitor(Item item, long offset, void *context) {
+    ItemIteratorContext *iteratorContext = context;
+    iteratorContext->optionalItem = iteratorContext->aimFunction(item, iteratorContext->aimItem);
+    iteratorContext->optionalItem.item.type = item.type;
+    if (!iteratorContext->optionalItem.hasValue) { return false; }
+    // Returned item outlives the arena of the scan.
+    iteratorContext->optionalItem.item = copyItem(iteratorContext->optionalItem.item);
+    return true;
+}
+
+OptionalItem ItemIterator(ItemType type, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
+    ItemIteratorContext context;
+    context.aimFunction = aimFunction; context.aimItem = aimItem; context.optionalItem.hasValue = false;
+    RecordScanner(type, itemIteratorVisitor, &context);
+    return context.optionalItem;
+}
+
+// MARK: Reading a record at an offset
+
+bool readItemAtOffset(ItemType type, long offset, Item *item) {
+    /* Decodes the record that starts at 'offset' of the file of 'type', returns false if there is no such record,
+     or if the record is removed. Offsets are taken from indexes, so this is used for point lookups. */
+    if (offset < 0) { return false; }
+    char fileName[255];
+    Item(*decodingFunction)(FILE*) = readInstructorFromFile;
+    Item(*recordDecodingFunction)(const unsigned char*) = decodeInstructorRecord;
+    Item(*textParsingFunction)(const TextLine*) = parseInstructorLines; int lineCount;
+    int recordSize = getRecordSizeForType(type);
+    prepareForIteration(type, fileName, &decodingFunction);
+    prepareForBinaryIteration(type, &recordDecodingFunction);
+    prepareForTextParsing(type, &textParsingFunction, &lineCount);
+    if (memoryMappedReads) {
+        bool found = false;
+        MappedFile *mappedFile = acquireFileMapping(type, MADV_RANDOM);
+        if (mappedFile == NULL) { return false; }
+        if (databaseFormat == BinaryFormat && (size_t)offset + recordSize <= mappedFile->length) {
+            found = binaryRecordIsLive(mappedFile->base + offset);
+            if (found) { *item = decodeRecordCopy(recordDecodingFunction, mappedFile->base + offset, recordSize); }
+        } else if (databaseFormat == TextFormat && (size_t)offset < mappedFile->length && mappedFile->base[offset] != TEXT_TOMBSTONE) {
+            TextLine lines[MAX_TEXT_RECORD_LINES];
+            splitTextLines((const char*)mappedFile->base + offset, (const char*)mappedFile->base + mappedFile->length, lines, lineCount);
+            *item = textParsingFunction(lines); found = true;
+        }
+        releaseFileMapping(mappedFile);
+        return found;
+    }
+    if (databaseFormat == BinaryFormat) {
+        unsigned char record[MAX_RECORD_SIZE];
+        bool found = synchronizeBufferPool(type) && readFromBufferPool(type, offset, record, recordSize) == (size_t)recordSize && binaryRecordIsLive(record);
+        if (found) { *item = decodeRecordCopy(recordDecodingFunction, record, recordSize); }
+        return found;
+    }
+    FILE *file = openTableStream(type);
+    if (file == NULL) { return false; }
+    int firstCharacter = (fseek(file, offset, SEEK_SET) == 0) ? getc(file) : EOF;
+    bool found = firstCharacter != EOF && firstCharacter != TEXT_TOMBSTONE;
+    if (found) { fseek(file, offset, SEEK_SET); *item = decodingFunction(file); }
+    fclose(file);
+    return found;
+}
+
+// MARK: - INDEXES
+
+/* Without an index, finding a record means scanning the whole file with 'ItemIterator'. Indexes are hash tables
+ stored in their own files, next to the file of the records, i.e. 'Courses.txt.primary.idx'. An index maps a key,
+ i.e. course code of a course, to the offset of the record in the file, and the record is then read straight from
+ that offset with 'readItemAtOffset'. Every index is described by an 'IndexDefinition'.
+ 
+ Index file starts with a header, and an array of buckets follows the header. Collisions are resolved with linear
+ probing, removed entries are marked as deleted, and the bucket array is doubled when it becomes 70% full.
+ Header also holds the size, modification time and inode of the records file at the time index was last
+ synchronized with it. If records file is changed by someone else, this stamp won't match and index is rebuilt
+ from the records file with one scan. Operations that change records file update the index, and stamp it again.
+ An index can also be ordered, then it is a B+tree instead of a hash table, see 'Ordered indexes' below. Indexes
+ that aren't unique are always ordered, since every entry of a key would be on the probe sequence of that key in a
+ hash table, and placing or finding one of them would take as long as the number of entries of that key. */
+
+#define INDEX_MAGIC "FBIX"
+#define INDEX_FORMAT_VERSION 2
+#define INDEX_HEADER_SIZE 64
+#define INITIAL_BUCKET_COUNT 64
+
+bool indexedLookups = true;
+
+typedef struct {
+    int32_t number;
+    char text[CODE_LENGTH];
+} IndexKey;
+
+typedef enum { EmptyBucket, UsedBucket, DeletedBucket } BucketState;
+
+typedef struct {
+    uint32_t state;
+    IndexKey key;
+    int64_t offset;
+} IndexBucket;
+
+typedef struct {
+    int64_t size;
+    int64_t modificationSeconds;
+    int64_t modificationNanoseconds;
+    uint64_t inode;
+} TableStamp;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    TableStamp tableStamp;
+    union {
+        struct { // Hash indexes.
+            uint32_t bucketCount;
+            uint32_t usedCount;
+            uint32_t deletedCount;
+        };
+        struct { // Ordered indexes.
+            uint32_t pageCount;
+            uint32_t rootPage;
+            uint32_t height;
+            uint32_t entryCount;
+        };
+    };
+} IndexHeader;
+
+typedef struct {
+    ItemType type;
+    const char *name;
+    bool unique;
+    bool (*includesItem)(Item item); // NULL if every record is in the index.
+    IndexKey (*keyOfItem)(Item item);
+    bool ordered; // B+tree instead of a hash table.
+    const char *keyField; // Field of the key, and the field whose records are in the index if it isn't zero, see 'PREDICATES'.
+    const char *filterField;
+} IndexDefinition;
+
+typedef struct {
+    bool isOpen;
+    bool ordered;
+    int descriptor;
+    IndexHeader header;
+} OpenIndex;
+
+// MARK: Index keys
+
+IndexKey makeNumberKey(int number) {
+    IndexKey key; memset(&key, 0, sizeof(key)); key.number = number; return key;
+}
+
+IndexKey makeTextKey(const char *text) {
+    IndexKey key; memset(&key, 0, sizeof(key));
+    if (text != NULL) { strncpy(key.text, text, CODE_LENGTH-1); }
+    return key;
+}
+
+IndexKey primaryKeyOfItem(Item item) {
+    switch (item.type) {
+        case InstructorType: return makeNumberKey(item.value.instructor.ID);
+        case CourseType: return makeTextKey(item.value.course.code);
+        case StudentType: return makeNumberKey(item.value.student.studentNumber);
+        case RegistrationType: return makeNumberKey(item.value.registration.ID);
+    }
+    return makeNumberKey(0);
+}
+
+bool keysAreEqual(IndexKey key1, IndexKey key2) {
+    return key1.number == key2.number && strcmp(key1.text, key2.text) == 0;
+}
+
+uint64_t hashOfKey(IndexKey key) {
+    // FNV-1a hash of the number and the text of the key.
+    uint64_t hash = 14695981039346656037ULL;
+    const unsigned char *bytes = (const unsigned char *)&key.number;
+    for (size_t i = 0; i < sizeof(key.number); i++) { hash = (hash ^ bytes[i]) * 1099511628211ULL; }
+    for (const char *c = key.text; *c != '\0'; c++) { hash = (hash ^ (unsigned char)*c) * 1099511628211ULL; }
+    return hash;
+}
+
+IndexKey makeCourseCodeKey(const char *code) {
+    // Registrations of a binary file are indexed by the IDs of their courses, see 'COURSE CODE DICTIONARY'.
+    if (databaseFormat == BinaryFormat) { return makeNumberKey(courseIDOfCode(code)); }
+    return makeTextKey(code);
+}
+
+IndexKey courseCodeOfRegistration(Item registration) { return makeCourseCodeKey(registration.value.registration.courseCode); }
+IndexKey studentNumberOfRegistration(Item registration) { return makeNumberKey(registration.value.registration.studentNumber); }
+bool registrationIsActive(Item registration) { return registration.value.registration.stillRegistered; }
+IndexKey instructorIDOfCourse(Item course) { return makeNumberKey(course.value.course.instructorID); }
+
+// MARK: Index definitions
+
+/* Primary indexes are unique and have every record of the file. Primary index of students is ordered, so students
+ can also be visited in the order of their student numbers, or in a range of student numbers. Secondary indexes of registrations map a course
+ code or a student number to every active registration of that course or student, so an invalidated registration
+ is removed from them. The instructor index of courses maps an instructor ID to every course given by that instructor.
+ Secondary indexes are ordered by their keys and offsets, so an entry is found, added or removed by descending the tree
+ to it, and the entries of a key are next to each other on the leaves. */
+
+const IndexDefinition indexDefinitions[] = {
+    { InstructorType, "primary", true, NULL, primaryKeyOfItem, false, "ID", NULL },
+    { CourseType, "primary", true, NULL, primaryKeyOfItem, false, "code", NULL },
+    { StudentType, "primary", true, NULL, primaryKeyOfItem, true, "studentNumber", NULL },
+    { RegistrationType, "primary", true, NULL, primaryKeyOfItem, false, "ID", NULL },
+    { RegistrationType, "course", false, registrationIsActive, courseCodeOfRegistration, true, "courseCode", "stillRegistered" },
+    { RegistrationType, "student", false, registrationIsActive, studentNumberOfRegistration, true, "studentNumber", "stillRegistered" },
+    { CourseType, "instructor", false, NULL, instructorIDOfCourse, true, "instructorID", NULL }
+};
+
+#define INDEX_COUNT (int)(sizeof(indexDefinitions)/sizeof(IndexDefinition))
+
+// Open indexes of text and binary files, files are opened once and kept open.
+OpenIndex openIndexes[2][INDEX_COUNT];
+
+int findIndexDefinition(ItemType type, const char *name) {
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        if (indexDefinitions[i].type == type && strcmp(indexDefinitions[i].name, name) == 0) { return i; }
+    }
+    return -1;
+}
+
+int primaryIndexOfType(ItemType type) { return findIndexDefinition(type, "primary"); }
+
+void getIndexFileNameInFormat(int definitionIndex, StorageFormat format, char *fileName) {
+    // Index names are short, 32 bytes are left for the '.<name>.<extension>' suffix of the table's name.
+    char tableFileName[255 - 32];
+    getFileNameForTypeInFormat(indexDefinitions[definitionIndex].type, format, tableFileName);
+    const char *extension = (indexDefinitions[definitionIndex].ordered) ? "bpt" : "idx";
+    snprintf(fileName, 255, "%s.%s.%s", tableFileName, indexDefinitions[definitionIndex].name, extension);
+}
+
+void getIndexFileName(int definitionIndex, char *fileName) {
+    getIndexFileNameInFormat(definitionIndex, databaseFormat, fileName);
+}
+
+int getIndexFileNamesOfType(ItemType type, StorageFormat format, char fileNames[][255]) {
+    // Assigns the file names of the indexes of 'type' in 'format', returns the number of them.
+    int count = 0;
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        if (indexDefinitions[i].type == type) { getIndexFileNameInFormat(i, format, fileNames[count++]); }
+    }
+    return count;
+}
+
+// MARK: Reading and writing index files
+
+void readBucket(OpenIndex *index, uint32_t bucketNumber, IndexBucket *bucket) {
+    off_t position = INDEX_HEADER_SIZE + (off_t)bucketNumber * sizeof(IndexBucket);
+    if (pread(index->descriptor, bucket, sizeof(IndexBucket), position) != sizeof(IndexBucket)) { bucket->state = EmptyBucket; }
+}
+
+void writeBucket(OpenIndex *index, uint32_t bucketNumber, IndexBucket *bucket) {
+    off_t position = INDEX_HEADER_SIZE + (off_t)bucketNumber * sizeof(IndexBucket);
+    if (pwrite(index->descriptor, bucket, sizeof(IndexBucket), position) != sizeof(IndexBucket)) {
+        printf("ERROR: Couldn't write to an index file.\n");
+    }
+}
+
+void writeIndexHeader(OpenIndex *index) {
+    unsigned char block[INDEX_HEADER_SIZE] = { 0 };
+    memcpy(block, &index->header, sizeof(IndexHeader));
+    if (pwrite(index->descriptor, block, INDEX_HEADER_SIZE, 0) != INDEX_HEADER_SIZE) {
+        printf("ERROR: Couldn't write to an index file.\n");
+    }
+}
+
+void getTableStamp(ItemType type, TableStamp *stamp) {
+    // Size, modification time and inode of the records file, size is -1 if there is no such file.
+    char fileName[255]; struct stat status;
+    getFileNameForType(type, fileName);
+    if (stat(fileName, &status) != 0) {
+        stamp->size = -1; stamp->modificationSeconds = 0; stamp->modificationNanoseconds = 0; stamp->inode = 0; return;
+    }
+    stamp->size = status.st_size;
+    stamp->modificationSeconds = status.st_mtim.tv_sec;
+    stamp->modificationNanoseconds = status.st_mtim.tv_nsec;
+    stamp->inode = status.st_ino;
+}
+
+bool tableStampsAreEqual(TableStamp stamp1, TableStamp stamp2) {
+    return stamp1.size == stamp2.size && stamp1.inode == stamp2.inode && stamp1.modificationSeconds == stamp2.modificationSeconds
+    && stamp1.modificationNanoseconds == stamp2.modificationNanoseconds;
+}
+
+bool indexIsFresh(int definitionIndex, OpenIndex *index) {
+    TableStamp current;
+    getTableStamp(indexDefinitions[definitionIndex].type, &current);
+    return tableStampsAreEqual(current, index->header.tableStamp);
+}
+
+void stampIndex(int definitionIndex, OpenIndex *index) {
+    getTableStamp(indexDefinitions[definitionIndex].type, &index->header.tableStamp);
+    writeIndexHeader(index);
+}
+
+// MARK: Ordered indexes
+
+/* An ordered index is a B+tree stored in fixed size pages of its index file, the first page holds the header. Leaves
+ hold the entries in ascending order of their keys and offsets, and every leaf points to the next leaf. So records
+ can be visited in the order of their keys without sorting, and a range of keys is visited by descending to the
+ first entry of the range, and walking on the leaves until the last one. A point lookup reads one page for every
+ level of the tree. An entry is removed from its leaf without merging leaves, since the tree is rebuilt packed
+ whenever the records file is rewritten. */
+
+#define TREE_MAGIC "FBBT"
+#define TREE_PAGE_SIZE 4096
+#define LEAF_CAPACITY 84
+#define BRANCH_CAPACITY 72
+
+typedef struct {
+    IndexKey key;
+    int64_t offset;
+} TreeEntry;
+
+typedef struct {
+    TreeEntry separator; // Smallest entry of the subtree of 'child'.
+    uint32_t child;
+} TreeBranch;
+
+typedef struct {
+    uint32_t isLeaf;
+    uint32_t entryCount;
+    uint32_t nextLeaf; // 0 for the last leaf.
+    uint32_t firstChild; // Child of a branch for the entries smaller than its first separator.
+    union {
+        TreeEntry entries[LEAF_CAPACITY];
+        TreeBranch branches[BRANCH_CAPACITY];
+    };
+} TreePage;
+
+typedef struct {
+    bool hasSplit;
+    TreeBranch branch; // First entry and page number of the new right sibling.
+} TreeSplit;
+
+typedef struct {
+    TreePage page;
+    uint32_t pageNumber;
+    uint32_t position;
+} TreeCursor;
+
+int compareKeys(IndexKey key1, IndexKey key2) {
+    if (key1.number != key2.number) { return (key1.number > key2.number) ? 1 : -1; }
+    int difference = strcmp(key1.text, key2.text);
+    return (difference > 0) - (difference < 0);
+}
+
+int compareTreeEntries(const void *entry1, const void *entry2) {
+    // Entries are ordered by their keys, and entries with the same key are ordered by their offsets.
+    const TreeEntry *treeEntry1 = entry1; const TreeEntry *treeEntry2 = entry2;
+    int difference = compareKeys(treeEntry1->key, treeEntry2->key);
+    if (difference != 0) { return difference; }
+    return (treeEntry1->offset > treeEntry2->offset) - (treeEntry1->offset < treeEntry2->offset);
+}
+
+void readTreePage(OpenIndex *index, uint32_t pageNumber, TreePage *page) {
+    if (pread(index->descriptor, page, sizeof(TreePage), (off_t)pageNumber * TREE_PAGE_SIZE) != sizeof(TreePage)) {
+        memset(page, 0, sizeof(TreePage)); page->isLeaf = true;
+    }
+}
+
+void writeTreePage(OpenIndex *index, uint32_t pageNumber, TreePage *page) {
+    if (pwrite(index->descriptor, page, sizeof(TreePage), (off_t)pageNumber * TREE_PAGE_SIZE) != sizeof(TreePage)) {
+        printf("ERROR: Couldn't write to an index file.\n");
+    }
+}
+
+uint32_t allocateTreePage(OpenIndex *index) { return index->header.pageCount++; }
+
+uint32_t childForEntry(const TreePage *page, const TreeEntry *entry, uint32_t *position) {
+    // Returns the child of the last separator that is not greater than 'entry', 'position' is the number of such separators.
+    uint32_t low = 0, high = page->entryCount;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (compareTreeEntries(&page->branches[middle].separator, entry) <= 0) { low = middle + 1; } else { high = middle; }
+    }
+    *position = low;
+    return (low == 0) ? page->firstChild : page->branches[low-1].child;
+}
+
+uint32_t lowerBoundInLeaf(const TreePage *page, const TreeEntry *entry) {
+    // Position of the first entry of the leaf that is not smaller than 'entry'.
+    uint32_t low = 0, high = page->entryCount;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (compareTreeEntries(&page->entries[middle], entry) < 0) { low = middle + 1; } else { high = middle; }
+    }
+    return low;
+}
+
+bool seekTree(OpenIndex *index, const TreeEntry *entry, TreeCursor *cursor) {
+    // Points 'cursor' to the first entry that is not smaller than 'entry', returns false if there is no such entry.
+    uint32_t position;
+    cursor->pageNumber = index->header.rootPage;
+    readTreePage(index, cursor->pageNumber, &cursor->page);
+    while (!cursor->page.isLeaf) {
+        cursor->pageNumber = childForEntry(&cursor->page, entry, &position);
+        readTreePage(index, cursor->pageNumber, &cursor->page);
+    }
+    cursor->position = lowerBoundInLeaf(&cursor->page, entry);
+    while (cursor->position == cursor->page.entryCount) {
+        if (cursor->page.nextLeaf == 0) { return false; }
+        cursor->pageNumber = cursor->page.nextLeaf; cursor->position = 0;
+        readTreePage(index, cursor->pageNumber, &cursor->page);
+    }
+    return true;
+}
+
+bool advanceTreeCursor(OpenIndex *index, TreeCursor *cursor) {
+    // Moves 'cursor' to the next entry, returns false at the end of the tree.
+    cursor->position++;
+    while (cursor->position >= cursor->page.entryCount) {
+        if (cursor->page.nextLeaf == 0) { return false; }
+        cursor->pageNumber = cursor->page.nextLeaf; cursor->position = 0;
+        readTreePage(index, cursor->pageNumber, &cursor->page);
+    }
+    return true;
+}
+
+TreeSplit insertIntoTreePage(OpenIndex *index, uint32_t pageNumber, TreeEntry entry) {
+    // Inserts 'entry' to the subtree of the page, if the page is split, returns the separator for its new sibling.
+    TreeSplit split; split.hasSplit = false;
+    TreePage page, sibling; uint32_t position;
+    readTreePage(index, pageNumber, &page);
+    memset(&sibling, 0, sizeof(TreePage));
+    if (page.isLeaf) {
+        TreeEntry entries[LEAF_CAPACITY + 1];
+        position = lowerBoundInLeaf(&page, &entry);
+        memcpy(entries, page.entries, sizeof(TreeEntry)*position); entries[position] = entry;
+        memcpy(entries + position + 1, page.entries + position, sizeof(TreeEntry)*(page.entryCount - position));
+        uint32_t count = page.entryCount + 1;
+        page.entryCount = (count <= LEAF_CAPACITY) ? count : count / 2;
+        memcpy(page.entries, entries, sizeof(TreeEntry)*page.entryCount);
+        if (count > LEAF_CAPACITY) {
+            // Upper half of the entries are moved to a new leaf, which is placed after this leaf.
+            sibling.isLeaf = true; sibling.entryCount = count - page.entryCount; sibling.nextLeaf = page.nextLeaf;
+            memcpy(sibling.entries, entries + page.entryCount, sizeof(TreeEntry)*sibling.entryCount);
+            split.hasSplit = true; split.branch.separator = sibling.entries[0];
+            split.branch.child = allocateTreePage(index); page.nextLeaf = split.branch.child;
+            writeTreePage(index, split.branch.child, &sibling);
+        }
+        writeTreePage(index, pageNumber, &page);
+        return split;
+    }
+    TreeSplit childSplit = insertIntoTreePage(index, childForEntry(&page, &entry, &position), entry);
+    if (!childSplit.hasSplit) { return split; }
+    TreeBranch branches[BRANCH_CAPACITY + 1];
+    memcpy(branches, page.branches, sizeof(TreeBranch)*position); branches[position] = childSplit.branch;
+    memcpy(branches + position + 1, page.branches + position, sizeof(TreeBranch)*(page.entryCount - position));
+    uint32_t count = page.entryCount + 1;
+    page.entryCount = (count <= BRANCH_CAPACITY) ? count : count / 2;
+    memcpy(page.branches, branches, sizeof(TreeBranch)*page.entryCount);
+    if (count > BRANCH_CAPACITY) {
+        // Middle separator moves up to the parent, separators after it are moved to a new branch.
+        TreeBranch middle = branches[page.entryCount];
+        sibling.isLeaf = false; sibling.firstChild = middle.child; sibling.entryCount = count - page.entryCount - 1;
+        memcpy(sibling.branches, branches + page.entryCount + 1, sizeof(TreeBranch)*sibling.entryCount);
+        split.hasSplit = true; split.branch.separator = middle.separator; split.branch.child = allocateTreePage(index);
+        writeTreePage(index, split.branch.child, &sibling);
+    }
+    writeTreePage(index, pageNumber, &page);
+    return split;
+}
+
+void insertIntoTree(OpenIndex *index, const IndexDefinition *definition, IndexKey key, long offset) {
+    TreeEntry entry; entry.key = key; entry.offset = offset;
+    if (definition->unique) {
+        // If 'key' is already in a unique index, only its offset is replaced.
+        TreeCursor cursor; TreeEntry probe = entry; probe.offset = -1;
+        if (seekTree(index, &probe, &cursor) && keysAreEqual(cursor.page.entries[cursor.position].key, key)) {
+            cursor.page.entries[cursor.position].offset = offset;
+            writeTreePage(index, cursor.pageNumber, &cursor.page); return;
+        }
+    }
+    TreeSplit split = insertIntoTreePage(index, index->header.rootPage, entry);
+    if (split.hasSplit) {
+        // Root is split, so a new root is placed above the old root and its new sibling.
+        TreePage root; memset(&root, 0, sizeof(TreePage));
+        root.isLeaf = false; root.entryCount = 1; root.firstChild = index->header.rootPage; root.branches[0] = split.branch;
+        index->header.rootPage = allocateTreePage(index); index->header.height++;
+        writeTreePage(index, index->header.rootPage, &root);
+    }
+    index->header.entryCount++;
+}
+
+void removeFromTree(OpenIndex *index, const IndexDefinition *definition, IndexKey key, long offset) {
+    // Removes the entry of 'key' from its leaf, if index is not unique, entry should also have the same 'offset'.
+    TreeCursor cursor; TreeEntry probe; probe.key = key; probe.offset = (definition->unique) ? -1 : offset;
+    if (!seekTree(index, &probe, &cursor)) { return; }
+    TreeEntry *entry = &cursor.page.entries[cursor.position];
+    if (!keysAreEqual(entry->key, key) || (!definition->unique && entry->offset != offset)) { return; }
+    memmove(entry, entry + 1, sizeof(TreeEntry)*(cursor.page.entryCount - cursor.position - 1));
+    cursor.page.entryCount--;
+    writeTreePage(index, cursor.pageNumber, &cursor.page);
+    index->header.entryCount--;
+}
+
+void forEachOffsetInKeyRange(OpenIndex *index, IndexKey lowestKey, IndexKey highestKey, bool(*visitor)(long, void*), void *context) {
+    // Calls 'visitor' with the offsets of the keys from 'lowestKey' to 'highestKey' in ascending order, until 'visitor' returns true.
+    TreeCursor cursor; TreeEntry probe; probe.key = lowestKey; probe.offset = -1;
+    if (!seekTree(index, &probe, &cursor)) { return; }
+    do {
+        TreeEntry *entry = &cursor.page.entries[cursor.position];
+        if (compareKeys(entry->key, highestKey) > 0 || visitor((long)entry->offset, context)) { return; }
+    } while (advanceTreeCursor(index, &cursor));
+}
+
+// MARK: Building ordered indexes
+
+typedef struct {
+    const IndexDefinition *definition;
+    IndexKey lowestKey;
+    IndexKey highestKey;
+    bool filtersKeys; // Only the keys from 'lowestKey' to 'highestKey' are collected if it is true.
+    TreeEntry *entries;
+    uint32_t count;
+    uint32_t capacity;
+} TreeEntryCollector;
+
+bool treeEntryCollectorVisitor(Item item, long offset, void *context) {
+    TreeEntryCollector *collector = context;
+    if (collector->definition->includesItem == NULL || collector->definition->includesItem(item)) {
+        TreeEntry entry; entry.key = collector->definition->keyOfItem(item); entry.offset = offset;
+        if (!collector->filtersKeys || (compareKeys(entry.key, collector->lowestKey) >= 0 && compareKeys(entry.key, collector->highestKey) <= 0)) {
+            if (collector->count == collector->capacity) {
+                collector->capacity = (collector->capacity == 0) ? 64 : collector->capacity * 2;
+                collector->entries = realloc(collector->entries, sizeof(TreeEntry)*collector->capacity);
+                if (collector->entries == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'treeEntryCollectorVisitor' function.\n"); exit(1); }
+            }
+            collector->entries[collector->count++] = entry;
+        }
+    }
+    return false;
+}
+
+void rebuildTree(int definitionIndex, OpenIndex *index) {
+    /* Collects the entries with one scan of the records file, sorts them, and writes the tree level by level, from
+     the leaves to the root. Pages are filled completely, since records are looked up much more than they are added. */
+    TreeEntryCollector collector; memset(&collector, 0, sizeof(collector));
+    collector.definition = &indexDefinitions[definitionIndex];
+    RecordScanner(collector.definition->type, treeEntryCollectorVisitor, &collector);
+    if (ftruncate(index->descriptor, 0) != 0) { printf("ERROR: Couldn't truncate an index file.\n"); }
+    index->header.pageCount = 1; index->header.entryCount = 0; index->header.height = 1;
+    TreePage page;
+    if (collector.count == 0) {
+        // An empty table is a single empty leaf, there is nothing to sort or to copy into pages.
+        memset(&page, 0, sizeof(TreePage)); page.isLeaf = true;
+        index->header.rootPage = allocateTreePage(index);
+        writeTreePage(index, index->header.rootPage, &page);
+        stampIndex(definitionIndex, index);
+        return;
+    }
+    qsort(collector.entries, collector.count, sizeof(TreeEntry), compareTreeEntries);
+    if (collector.definition->unique) {
+        // Only the last record of a key is kept, as it is with a hash index.
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < collector.count; i++) {
+            if (i + 1 < collector.count && keysAreEqual(collector.entries[i].key, collector.entries[i+1].key)) { continue; }
+            collector.entries[count++] = collector.entries[i];
+        }
+        collector.count = count;
+    }
+    index->header.entryCount = collector.count;
+    uint32_t levelCount = (collector.count + LEAF_CAPACITY - 1) / LEAF_CAPACITY;
+    TreeBranch *level = calloc(levelCount, sizeof(TreeBranch)); // First entry and page number of every page of a level.
+    if (level == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'rebuildTree' function.\n"); exit(1); }
+    for (uint32_t i = 0; i < levelCount; i++) {
+        memset(&page, 0, sizeof(TreePage)); page.isLeaf = true;
+        page.entryCount = (i + 1 < levelCount) ? LEAF_CAPACITY : collector.count - i * LEAF_CAPACITY;
+        memcpy(page.entries, collector.entries + i * LEAF_CAPACITY, sizeof(TreeEntry)*page.entryCount);
+        level[i].child = allocateTreePage(index);
+        page.nextLeaf = (i + 1 < levelCount) ? level[i].child + 1 : 0;
+        level[i].separator = page.entries[0];
+        writeTreePage(index, level[i].child, &page);
+    }
+    while (levelCount > 1) {
+        uint32_t parentCount = (levelCount + BRANCH_CAPACITY) / (BRANCH_CAPACITY + 1);
+        for (uint32_t i = 0; i < parentCount; i++) {
+            uint32_t first = i * (BRANCH_CAPACITY + 1);
+            uint32_t last = (first + BRANCH_CAPACITY < levelCount) ? first + BRANCH_CAPACITY : levelCount - 1;
+            memset(&page, 0, sizeof(TreePage)); page.isLeaf = false;
+            page.firstChild = level[first].child; page.entryCount = last - first;
+            memcpy(page.branches, level + first + 1, sizeof(TreeBranch)*page.entryCount);
+            level[i].separator = level[first].separator; level[i].child = allocateTreePage(index);
+            writeTreePage(index, level[i].child, &page);
+        }
+        levelCount = parentCount; index->header.height++;
+    }
+    index->header.rootPage = level[0].child;
+    stampIndex(definitionIndex, index);
+    free(level); free(collector.entries);
+}
+
+// MARK: Building indexes in memory
+
+void placeBucket(IndexBucket *buckets, uint32_t bucketCount, IndexBucket bucket) {
+    // Places 'bucket' to the first empty bucket of its probe sequence, used while building or resizing an index.
+    uint32_t bucketNumber = (uint32_t)(hashOfKey(bucket.key) % bucketCount);
+    while (buckets[bucketNumber].state == UsedBucket) { bucketNumber = (bucketNumber + 1) % bucketCount; }
+    bucket.state = UsedBucket; buckets[bucketNumber] = bucket;
+}
+
+void writeAllBuckets(OpenIndex *index, IndexBucket *buckets, uint32_t bucketCount, uint32_t usedCount) {
+    // Replaces the content of the index file with 'buckets'.
+    index->header.bucketCount = bucketCount; index->header.usedCount = usedCount; index->header.deletedCount = 0;
+    if (ftruncate(index->descriptor, 0) != 0) { printf("ERROR: Couldn't truncate an index file.\n"); }
+    writeIndexHeader(index);
+    size_t length = sizeof(IndexBucket)*bucketCount;
+    if (pwrite(index->descriptor, buckets, length, INDEX_HEADER_SIZE) != (ssize_t)length) {
+        printf("ERROR: Couldn't write to an index file.\n");
+    }
+}
+
+void resizeIndex(OpenIndex *index, uint32_t newBucketCount) {
+    // Rehashes every used bucket into a bucket array with 'newBucketCount' buckets, deleted buckets are dropped.
+    uint32_t bucketCount = index->header.bucketCount;
+    IndexBucket *buckets = malloc(sizeof(IndexBucket)*bucketCount);
+    IndexBucket *newBuckets = calloc(newBucketCount, sizeof(IndexBucket));
+    if (buckets == NULL || newBuckets == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'resizeIndex' function.\n"); exit(1); }
+    size_t length = sizeof(IndexBucket)*bucketCount;
+    if (pread(index->descriptor, buckets, length, INDEX_HEADER_SIZE) != (ssize_t)length) { memset(buckets, 0, length); }
+    uint32_t usedCount = 0;
+    for (uint32_t i = 0; i < bucketCount; i++) {
+        if (buckets[i].state == UsedBucket) { placeBucket(newBuckets, newBucketCount, buckets[i]); usedCount++; }
+    }
+    writeAllBuckets(index, newBuckets, newBucketCount, usedCount);
+    free(buckets); free(newBuckets);
+}
+
+typedef struct {
+    const IndexDefinition *definition;
+    IndexBucket *buckets;
+    uint32_t bucketCount;
+    uint32_t usedCount;
+} IndexBuilder;
+
+void addToIndexBuilder(IndexBuilder *builder, IndexKey key, long offset) {
+    if ((builder->usedCount + 1) * 10 > builder->bucketCount * 7) {
+        // Doubling the bucket array, and placing every bucket again.
+        uint32_t newBucketCount = builder->bucketCount * 2;
+        IndexBucket *newBuckets = calloc(newBucketCount, sizeof(IndexBucket));
+        if (newBuckets == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'addToIndexBuilder' function.\n"); exit(1); }
+        for (uint32_t i = 0; i < builder->bucketCount; i++) {
+            if (builder->buckets[i].state == UsedBucket) { placeBucket(newBuckets, newBucketCount, builder->buckets[i]); }
+        }
+        free(builder->buckets); builder->buckets = newBuckets; builder->bucketCount = newBucketCount;
+    }
+    IndexBucket bucket; bucket.key = key; bucket.offset = offset;
+    placeBucket(builder->buckets, builder->bucketCount, bucket);
+    builder->usedCount++;
+}
+
+bool indexBuilderVisitor(Item item, long offset, void *context) {
+    IndexBuilder *builder = context;
+    if (builder->definition->includesItem == NULL || builder->definition->includesItem(item)) {
+        addToIndexBuilder(builder, builder->definition->keyOfItem(item), offset);
+    }
+    return false;
+}
+
+void rebuildIndex(int definitionIndex, OpenIndex *index) {
+    // Builds the index in memory with one scan of the records file, and writes it in one go.
+    if (indexDefinitions[definitionIndex].ordered) { rebuildTree(definitionIndex, index); return; }
+    IndexBuilder builder;
+    builder.definition = &indexDefinitions[definitionIndex];
+    builder.bucketCount = INITIAL_BUCKET_COUNT; builder.usedCount = 0;
+    builder.buckets = calloc(builder.bucketCount, sizeof(IndexBucket));
+    if (builder.buckets == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'rebuildIndex' function.\n"); exit(1); }
+    RecordScanner(builder.definition->type, indexBuilderVisitor, &builder);
+    writeAllBuckets(index, builder.buckets, builder.bucketCount, builder.usedCount);
+    stampIndex(definitionIndex, index);
+    free(builder.buckets);
+}
+
+// MARK: Opening indexes
+
+OpenIndex *openIndex(int definitionIndex, bool synchronize) {
+    /* Returns the open index with 'definitionIndex'. If index file doesn't exist or has a different version, it is
+     rebuilt. If 'synchronize' is true, index is also rebuilt when it is stale. Returns NULL if index file can't be opened. */
+    OpenIndex *index = &openIndexes[databaseFormat][definitionIndex];
+    if (!index->isOpen) {
+        char fileName[255];
+        getIndexFileName(definitionIndex, fileName);
+        index->descriptor = open(fileName, O_RDWR | O_CREAT, 0644);
+        if (index->descriptor < 0) { return NULL; }
+        index->isOpen = true; index->ordered = indexDefinitions[definitionIndex].ordered;
+        const char *magic = (index->ordered) ? TREE_MAGIC : INDEX_MAGIC;
+        unsigned char block[INDEX_HEADER_SIZE];
+        bool valid = pread(index->descriptor, block, INDEX_HEADER_SIZE, 0) == INDEX_HEADER_SIZE;
+        if (valid) { memcpy(&index->header, block, sizeof(IndexHeader)); }
+        if (!valid || memcmp(index->header.magic, magic, 4) != 0 || index->header.version != INDEX_FORMAT_VERSION) {
+            memset(&index->header, 0, sizeof(IndexHeader));
+            memcpy(index->header.magic, magic, 4); index->header.version = INDEX_FORMAT_VERSION;
+            rebuildIndex(definitionIndex, index); return index;
+        }
+    }
+    if (synchronize && !indexIsFresh(definitionIndex, index)) { rebuildIndex(definitionIndex, index); }
+    return index;
+}
+
+OpenIndex *getIndex(int definitionIndex) {
+    // Returns the open index with 'definitionIndex', which is synchronized with its records file.
+    return openIndex(definitionIndex, true);
+}
+
+// MARK: Index operations
+
+void insertIntoIndex(OpenIndex *index, const IndexDefinition *definition, IndexKey key, long offset) {
+    /* Inserts 'key' with 'offset' to the index. If index is unique and 'key' is already in the index,
+     its offset is replaced. */
+    if (index->ordered) { insertIntoTree(index, definition, key, offset); return; }
+    if ((index->header.usedCount + index->header.deletedCount + 1) * 10 > index->header.bucketCount * 7) {
+        uint32_t bucketCount = index->header.bucketCount;
+        // Deleted buckets are dropped by resizing, so index grows only if it is full of used buckets.
+        resizeIndex(index, (index->header.usedCount * 10 > bucketCount * 5) ? bucketCount * 2 : bucketCount);
+    }
+    IndexBucket bucket; int64_t freeBucket = -1;
+    uint32_t bucketNumber = (uint32_t)(hashOfKey(key) % index->header.bucketCount);
+    while (true) {
+        readBucket(index, bucketNumber, &bucket);
+        if (bucket.state == EmptyBucket) { break; }
+        if (bucket.state == DeletedBucket && freeBucket < 0) {
+            freeBucket = bucketNumber;
+            if (!definition->unique) { break; }
+        }
+        if (bucket.state == UsedBucket && definition->unique && keysAreEqual(bucket.key, key)) {
+            bucket.offset = offset; writeBucket(index, bucketNumber, &bucket); return;
+        }
+        bucketNumber = (bucketNumber + 1) % index->header.bucketCount;
+    }
+    if (freeBucket >= 0) { bucketNumber = (uint32_t)freeBucket; index->header.deletedCount--; }
+    bucket.state = UsedBucket; bucket.key = key; bucket.offset = offset;
+    writeBucket(index, bucketNumber, &bucket);
+    index->header.usedCount++;
+}
+
+void removeFromIndex(OpenIndex *index, const IndexDefinition *definition, IndexKey key, long offset) {
+    // Marks the bucket of 'key' as deleted, if index is not unique, bucket should also have the same 'offset'.
+    if (index->ordered) { removeFromTree(index, definition, key, offset); return; }
+    IndexBucket bucket;
+    uint32_t bucketNumber = (uint32_t)(hashOfKey(key) % index->header.bucketCount);
+    for (uint32_t probes = 0; probes < index->header.bucketCount; probes++) {
+        readBucket(index, bucketNumber, &bucket);
+        if (bucket.state == EmptyBucket) { return; }
+        if (bucket.state == UsedBucket && keysAreEqual(bucket.key, key) && (definition->unique || bucket.offset == offset)) {
+            bucket.state = DeletedBucket; writeBucket(index, bucketNumber, &bucket);
+            index->header.usedCount--; index->header.deletedCount++; return;
+        }
+        bucketNumber = (bucketNumber + 1) % index->header.bucketCount;
+    }
+}
+
+void forEachOffsetOfKey(OpenIndex *index, IndexKey key, bool(*visitor)(long, void*), void *context) {
+    // Calls 'visitor' with every offset of 'key' in the index, until 'visitor' returns true.
+    if (index->ordered) { forEachOffsetInKeyRange(index, key, key, visitor, context); return; }
+    IndexBucket bucket;
+    uint32_t bucketNumber = (uint32_t)(hashOfKey(key) % index->header.bucketCount);
+    for (uint32_t probes = 0; probes < index->header.bucketCount; probes++) {
+        readBucket(index, bucketNumber, &bucket);
+        if (bucket.state == EmptyBucket) { return; }
+        if (bucket.state == UsedBucket && keysAreEqual(bucket.key, key)) {
+            if (visitor((long)bucket.offset, context)) { return; }
+        }
+        bucketNumber = (bucketNumber + 1) % index->header.bucketCount;
+    }
+}
+
+// MARK: Keeping indexes synchronized with records files
+
+/* Functions below are called by the functions that change records files. 'synchronizeIndexesOfType' should be
+ called before changing the file, so indexes that are stale because of others are rebuilt before the change. After
+ the change, 'indexItemAdded', 'indexItemRemoved' or 'rebuildIndexesOfType' updates the indexes, and stamps them
+ with the new state of the records file. They also keep the columns of registrations synchronized, see 'COLUMNAR
+ REGISTRATIONS', and the dictionary of course codes, see 'COURSE CODE DICTIONARY', both are kept even if indexes
+ are disabled. */
+
+void synchronizeIndexesOfType(ItemType type) {
+    if (type == RegistrationType) { synchronizeRegistrationColumns(); }
+    if (type == CourseType || type == RegistrationType) { synchronizeCourseDictionary(); }
+    if (!indexedLookups) { return; }
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        if (indexDefinitions[i].type == type) { getIndex(i); }
+    }
+}
+
+void closeIndexesOfType(ItemType type) {
+    // Closes the index files of 'type', they are opened again by the next lookup, i.e. after the records file is replaced.
+    if (type == RegistrationType) { dropRegistrationColumns(); }
+    if (type == CourseType) { dropCourseDictionary(); }
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        OpenIndex *index = &openIndexes[databaseFormat][i];
+        if (indexDefinitions[i].type == type && index->isOpen) { close(index->descriptor); index->isOpen = false; }
+    }
+}
+
+void adoptIndexesOfType(ItemType type) {
+    /* Opens the index files of 'type' without synchronizing them, and stamps them with the current state of the
+     records file. Used after a records file and its indexes are copied together, so indexes are known to be fresh. */
+    if (type == RegistrationType) { stampRegistrationColumns(); }
+    if (type == CourseType) { stampCourseDictionary(); }
+    if (!indexedLookups) { return; }
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        if (indexDefinitions[i].type != type) { continue; }
+        OpenIndex *index = openIndex(i, false);
+        if (index != NULL) { stampIndex(i, index); }
+    }
+}
+
+void stampIndexesOfType(ItemType type) {
+    if (type == RegistrationType) { stampRegistrationColumns(); }
+    if (type == CourseType) { stampCourseDictionary(); }
+    if (!indexedLookups) { return; }
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        OpenIndex *index = &openIndexes[databaseFormat][i];
+        if (indexDefinitions[i].type == type && index->isOpen) { stampIndex(i, index); }
+    }
+}
+
+void indexItemAdded(Item item, long offset) {
+    // Called after 'item' is written at 'offset' of its records file.
+    registrationColumnsItemAdded(item, offset); courseDictionaryItemWritten(item);
+    if (!indexedLookups) { stampIndexesOfType(item.type); return; }
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        const IndexDefinition *definition = &indexDefinitions[i];
+        OpenIndex *index = &openIndexes[databaseFormat][i];
+        if (definition->type != item.type || !index->isOpen) { continue; }
+        if (definition->includesItem == NULL || definition->includesItem(item)) {
+            insertIntoIndex(index, definition, definition->keyOfItem(item), offset);
+        }
+    }
+    stampIndexesOfType(item.type);
+}
+
+void indexItemChanged(Item oldVersion, Item newVersion, long offset) {
+    /* Called after the record at 'offset' is changed in place from 'oldVersion' to 'newVersion', i.e. after a
+     registration is invalidated. Entry of the record is moved only in indexes whose key or filter has changed. */
+    registrationColumnsItemChanged(newVersion, offset); courseDictionaryItemWritten(newVersion);
+    if (!indexedLookups) { stampIndexesOfType(oldVersion.type); return; }
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        const IndexDefinition *definition = &indexDefinitions[i];
+        OpenIndex *index = &openIndexes[databaseFormat][i];
+        if (definition->type != oldVersion.type || !index->isOpen) { continue; }
+        bool wasIncluded = definition->includesItem == NULL || definition->includesItem(oldVersion);
+        bool isIncluded = definition->includesItem == NULL || definition->includesItem(newVersion);
+        IndexKey oldKey = definition->keyOfItem(oldVersion); IndexKey newKey = definition->keyOfItem(newVersion);
+        bool keyHasChanged = !keysAreEqual(oldKey, newKey);
+        if (wasIncluded && (!isIncluded || keyHasChanged)) { removeFromIndex(index, definition, oldKey, offset); }
+        if (isIncluded && (!wasIncluded || keyHasChanged)) { insertIntoIndex(index, definition, newKey, offset); }
+    }
+    stampIndexesOfType(oldVersion.type);
+}
+
+void indexItemRemoved(Item item, long offset) {
+    // Called after the record of 'item' at 'offset' is marked as removed.
+    registrationColumnsItemRemoved(item, offset);
+    if (!indexedLookups) { stampIndexesOfType(item.type); return; }
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        const IndexDefinition *definition = &indexDefinitions[i];
+        OpenIndex *index = &openIndexes[databaseFormat][i];
+        if (definition->type != item.type || !index->isOpen) { continue; }
+        if (definition->includesItem == NULL || definition->includesItem(item)) {
+            removeFromIndex(index, definition, definition->keyOfItem(item), offset);
+        }
+    }
+    stampIndexesOfType(item.type);
+}
+
+void rebuildIndexesOfType(ItemType type) {
+    // Called after records file of 'type' is rewritten, since offsets of the records have changed.
+    if (type == RegistrationType) { dropRegistrationColumns(); }
+    if (type == CourseType) { stampCourseDictionary(); } // IDs and codes of courses don't change, and codes of removed courses are kept.
+    if (!indexedLookups) { return; }
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        if (indexDefinitions[i].type != type) { continue; }
+        OpenIndex *index = openIndex(i, false);
+        if (index != NULL) { rebuildIndex(i, index); }
+    }
+}
+
+// MARK: Shifting offsets of resized records
+
+/* When some records of a text file are rewritten with a line of a different length, i.e. by
+ 'rewriteKeyLinesOfTextRegistrations', every record after one of them moves by the total change of length before it,
+ but the order and the keys of the records don't change. So the offsets in the open indexes are shifted where they are,
+ with one pass over each index file, instead of rebuilding the indexes from the records file. Buckets of a hash index
+ stay where they are, and entries of a B+tree stay in order, since no record passes another one. */
+
+struct OffsetShift {
+    const long *offsets; // Offsets of the resized records before the rewrite, in ascending order.
+    const long *shifts; // Total change of length of the resized records up to and including each of them.
+    int count;
+};
+
+long shiftedOffset(const OffsetShift *shift, long offset) {
+    // A resized record starts before its changed line, so it is moved only by the resized records before it.
+    int low = 0, high = shift->count;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (shift->offsets[middle] < offset) { low = middle + 1; } else { high = middle; }
+    }
+    return (low == 0) ? offset : offset + shift->shifts[low-1];
+}
+
+void shiftOffsetsOfHashIndex(int definitionIndex, OpenIndex *index, const OffsetShift *shift) {
+    size_t length = sizeof(IndexBucket)*index->header.bucketCount;
+    IndexBucket *buckets = malloc(length);
+    if (buckets == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'shiftOffsetsOfHashIndex' function.\n"); exit(1); }
+    if (pread(index->descriptor, buckets, length, INDEX_HEADER_SIZE) != (ssize_t)length) { free(buckets); rebuildIndex(definitionIndex, index); return; }
+    for (uint32_t i = 0; i < index->header.bucketCount; i++) {
+        if (buckets[i].state == UsedBucket) { buckets[i].offset = shiftedOffset(shift, (long)buckets[i].offset); }
+    }
+    if (pwrite(index->descriptor, buckets, length, INDEX_HEADER_SIZE) != (ssize_t)length) {
+        printf("ERROR: Couldn't write to an index file.\n");
+    }
+    free(buckets);
+}
+
+void shiftOffsetsOfTree(OpenIndex *index, const OffsetShift *shift) {
+    // Every page after the header page is a page of the tree, separators of branches are shifted like the entries of leaves.
+    TreePage page;
+    for (uint32_t pageNumber = 1; pageNumber < index->header.pageCount; pageNumber++) {
+        readTreePage(index, pageNumber, &page);
+        for (uint32_t i = 0; i < page.entryCount; i++) {
+            int64_t *offset = (page.isLeaf) ? &page.entries[i].offset : &page.branches[i].separator.offset;
+            *offset = shiftedOffset(shift, (long)*offset);
+        }
+        writeTreePage(index, pageNumber, &page);
+    }
+}
+
+void shiftIndexesOfType(ItemType type, const OffsetShift *shift) {
+    /* Called after the records file of 'type' is rewritten with resized records, instead of 'rebuildIndexesOfType'.
+     Indexes should be synchronized before the rewrite, closed ones are rebuilt when they are opened. */
+    if (type == RegistrationType) { shiftRegistrationColumns(shift); }
+    if (indexedLookups) {
+        for (int i = 0; i < INDEX_COUNT; i++) {
+            OpenIndex *index = &openIndexes[databaseFormat][i];
+            if (indexDefinitions[i].type != type || !index->isOpen) { continue; }
+            if (index->ordered) { shiftOffsetsOfTree(index, shift); } else { shiftOffsetsOfHashIndex(i, index, shift); }
+        }
+    }
+    stampIndexesOfType(type);
+}
+
+// MARK: Lookups with indexes
+
+typedef struct {
+    Item queriedItem;
+    OptionalItem optionalItem;
+    long offset;
+    Arena arena;
+} IndexLookupContext;
+
+bool readItemAtOffsetInArena(Arena *arena, ItemType type, long offset, Item *item) {
+    Arena *previous = setDecodingArena(arena);
+    bool found = readItemAtOffset(type, offset, item);
+    setDecodingArena(previous);
+    return found;
+}
+
+bool indexLookupVisitor(long offset, void *context) {
+    // Reads the record at 'offset' in the arena of the lookup, and checks whether it is really the queried item.
+    IndexLookupContext *lookupContext = context;
+    Item item;
+    bool found = readItemAtOffsetInArena(&lookupContext->arena, lookupContext->queriedItem.type, offset, &item)
+    && conditionForQuery(item, lookupContext->queriedItem);
+    if (found) {
+        lookupContext->optionalItem.hasValue = true; lookupContext->optionalItem.item = copyItem(item);
+        lookupContext->offset = offset;
+    }
+    resetArena(&lookupContext->arena);
+    return found;
+}
+
+bool findItemWithIndex(Item item, OptionalItem *optionalItem, long *offset) {
+    /* Looks 'item' up with the primary index of its type, and assigns the offset of its record to 'offset'.
+     A registration that is queried with its student number and course code instead of its ID, is looked up
+     among the active registrations of the student. Returns false if indexes are disabled. */
+    if (!indexedLookups) { return false; }
+    int definitionIndex = primaryIndexOfType(item.type);
+    IndexKey key = primaryKeyOfItem(item);
+    if (item.type == RegistrationType && item.value.registration.ID < 0) {
+        if (item.value.registration.courseCode == NULL) { return false; }
+        definitionIndex = findIndexDefinition(RegistrationType, "student"); key = studentNumberOfRegistration(item);
+    }
+    OpenIndex *index = getIndex(definitionIndex);
+    if (index == NULL) { return false; }
+    IndexLookupContext context; Arena arena = EMPTY_ARENA;
+    context.queriedItem = item; context.optionalItem.hasValue = false; context.offset = -1; context.arena = arena;
+    forEachOffsetOfKey(index, key, indexLookupVisitor, &context);
+    releaseArena(&context.arena);
+    *optionalItem = context.optionalItem; *offset = context.offset;
+    return true;
+}
+
+bool findOffsetOfItem(Item item, long *offset) {
+    // Assigns the offset of the record of 'item' to 'offset', returns false if it can't be found with an index.
+    OptionalItem optionalItem;
+    if (!findItemWithIndex(item, &optionalItem, offset) || !optionalItem.hasValue) { return false; }
+    freeItem(optionalItem.item); return true;
+}
+
+// MARK: Iterating over the records of a key
+
+/* 'IndexedItemIterator' works like 'ItemIterator', but it only visits the records that have 'key' in the index
+ with 'indexName', i.e. only registrations of a course. Records are visited in the same order as they are in the
+ file, so the result is the same with 'ItemIterator', but the cost is proportional to the number of records
+ visited. 'aimFunction' should still check the records, since it is also used with 'ItemIterator' when
+ indexes are disabled. */
+
+typedef struct {
+    long *offsets;
+    int count;
+    int capacity;
+} OffsetList;
+
+bool offsetCollector(long offset, void *context) {
+    OffsetList *list = context;
+    if (list->count == list->capacity) {
+        list->capacity = (list->capacity == 0) ? 16 : list->capacity * 2;
+        list->offsets = realloc(list->offsets, sizeof(long)*list->capacity);
+        if (list->offsets == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'offsetCollector' function.\n"); exit(1); }
+    }
+    list->offsets[list->count++] = offset; return false;
+}
+
+int compareOffsets(const void *offset1, const void *offset2) {
+    long difference = *(const long *)offset1 - *(const long *)offset2;
+    return (difference > 0) - (difference < 0);
+}
+
+OptionalItem visitItemsAtOffsets(ItemType type, OffsetList *list, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
+    // Calls 'aimFunction' with the records at the offsets of 'list' in order, records are decoded in one arena which is reset after every record.
+    OptionalItem optionalItem; optionalItem.hasValue = false;
+    Arena arena = EMPTY_ARENA;
+    for (int i = 0; i < list->count; i++) {
+        Item item;
+        if (!readItemAtOffsetInArena(&arena, type, list->offsets[i], &item)) { continue; }
+        optionalItem = aimFunction(item, aimItem);
+        optionalItem.item.type = type;
+        if (optionalItem.hasValue) { optionalItem.item = copyItem(optionalItem.item); break; }
+        resetArena(&arena);
+    }
+    releaseArena(&arena); free(list->offsets);
+    return optionalItem;
+}
+
+OptionalItem IndexedItemIterator(ItemType type, const char *indexName, IndexKey key, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
+    OpenIndex *index = (indexedLookups) ? getIndex(findIndexDefinition(type, indexName)) : NULL;
+    if (index == NULL) { return ItemIterator(type, aimFunction, aimItem); }
+    OffsetList list = { NULL, 0, 0 };
+    forEachOffsetOfKey(index, key, offsetCollector, &list);
+    if (list.count > 1) { qsort(list.offsets, list.count, sizeof(long), compareOffsets); }
+    return visitItemsAtOffsets(type, &list, aimFunction, aimItem);
+}
+
+OptionalItem RegistrationsOfCourseOrStudentIterator(Item courseOrStudent, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
+    // Visits the active registrations of a course or a student, with the secondary indexes of registrations, or with their columns if indexes are disabled.
+    if (!indexedLookups && columnarRegistrations) { return RegistrationColumnsOfCourseOrStudentIterator(courseOrStudent, aimFunction, aimItem); }
+    if (courseOrStudent.type == CourseType) {
+        synchronizeCourseDictionary();
+        return IndexedItemIterator(RegistrationType, "course", makeCourseCodeKey(courseOrStudent.value.course.code), aimFunction, aimItem);
+    }
+    return IndexedItemIterator(RegistrationType, "student", makeNumberKey(courseOrStudent.value.student.studentNumber), aimFunction, aimItem);
+}
+
+// MARK: Lookups with predicates
+
+/* 'PredicateScanner' visits the records that match a predicate like 'FilteredRecordScanner' does, but if the
+ predicate requires the key field of an index to be equal to a constant, only the records of that key are read with the
+ index, and the predicate is checked on each of them. An index that has only some of the records, i.e. only active
+ registrations, is used only if the predicate also requires its 'filterField' to be equal to 1. Records are visited in
+ the order of the file either way, and offsets are collected before they are visited, so the visitor can change the database. */
+
+const Predicate *findEqualityInConjunction(const Predicate *predicate, const char *field) {
+    // Returns a comparison of 'field' for equality, that should hold for 'predicate' to hold, or NULL if there is none.
+    if (predicate == NULL || predicate->kind == OrPredicate) { return NULL; }
+    if (predicate->kind == AndPredicate) {
+        const Predicate *equality = findEqualityInConjunction(predicate->left, field);
+        return (equality != NULL) ? equality : findEqualityInConjunction(predicate->right, field);
+    }
+    return (predicate->comparator == IsEqualTo && strcmp(predicate->field, field) == 0) ? predicate : NULL;
+}
+
+bool findIndexOfPredicate(ItemType type, const Predicate *predicate, int *definitionIndex, IndexKey *key) {
+    for (int i = 0; i < INDEX_COUNT; i++) {
+        const IndexDefinition *definition = &indexDefinitions[i];
+        const Predicate *equality = (definition->type == type) ? findEqualityInConjunction(predicate, definition->keyField) : NULL;
+        if (equality == NULL) { continue; }
+        if (definition->filterField != NULL) {
+            const Predicate *filter = findEqualityInConjunction(predicate, definition->filterField);
+            if (filter == NULL || filter->text != NULL || filter->number != 1) { continue; }
+        }
+        if (equality->text == NULL) { *key = makeNumberKey(equality->number); }
+        else if (type == RegistrationType) { synchronizeCourseDictionary(); *key = makeCourseCodeKey(equality->text); }
+        else { *key = makeTextKey(equality->text); }
+        *definitionIndex = i; return true;
+    }
+    return false;
+}
+
+void PredicateScanner(ItemType type, const Predicate *predicate, bool(*visitor)(Item, long, void*), void *context) {
+    int definitionIndex = -1; IndexKey key;
+    OpenIndex *index = (indexedLookups && findIndexOfPredicate(type, predicate, &definitionIndex, &key)) ? getIndex(definitionIndex) : NULL;
+    if (index == NULL) { FilteredRecordScanner(type, predicate, visitor, context); return; }
+    OffsetList list = { NULL, 0, 0 }; Arena arena = EMPTY_ARENA;
+    forEachOffsetOfKey(index, key, offsetCollector, &list);
+    if (list.count > 1) { qsort(list.offsets, list.count, sizeof(long), compareOffsets); }
+    for (int i = 0; i < list.count; i++) {
+        Item item; bool shouldStop = false;
+        if (readItemAtOffsetInArena(&arena, type, list.offsets[i], &item) && itemMatches(predicate, item)) { shouldStop = visitor(item, list.offsets[i], context); }
+        resetArena(&arena);
+        if (shouldStop) { break; }
+    }
+    releaseArena(&arena); free(list.offsets);
+}
+
+OptionalItem FilteredItemIterator(ItemType type, const Predicate *predicate, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
+    // Works like 'ItemIterator', but 'aimFunction' is called only with the records that match 'predicate'.
+    ItemIteratorContext context;
+    context.aimFunction = aimFunction; context.aimItem = aimItem; context.optionalItem.hasValue = false;
+    PredicateScanner(type, predicate, itemIteratorVisitor, &context);
+    return context.optionalItem;
+}
+
+// MARK: Iterating over a range of keys
+
+/* 'RangeItemIterator' visits the records whose keys are from 'lowestKey' to 'highestKey' in the ordered index with
+ 'indexName', in ascending order of their keys. Offsets are collected before the records are visited, so 'aimFunction'
+ can change the database. If indexes are disabled, the records file is scanned and records in the range are sorted. */
+
+OptionalItem RangeItemIterator(ItemType type, const char *indexName, IndexKey lowestKey, IndexKey highestKey, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
+    int definitionIndex = findIndexDefinition(type, indexName);
+    OpenIndex *index = (indexedLookups) ? getIndex(definitionIndex) : NULL;
+    OffsetList list = { NULL, 0, 0 };
+    if (index != NULL) {
+        forEachOffsetInKeyRange(index, lowestKey, highestKey, offsetCollector, &list);
+    } else {
+        TreeEntryCollector collector; memset(&collector, 0, sizeof(collector));
+        collector.definition = &indexDefinitions[definitionIndex]; collector.filtersKeys = true;
+        collector.lowestKey = lowestKey; collector.highestKey = highestKey;
+        RecordScanner(type, treeEntryCollectorVisitor, &collector);
+        if (collector.count > 1) { qsort(collector.entries, collector.count, sizeof(TreeEntry), compareTreeEntries); }
+        for (uint32_t i = 0; i < collector.count; i++) { offsetCollector((long)collector.entries[i].offset, &list); }
+        free(collector.entries);
+    }
+    return visitItemsAtOffsets(type, &list, aimFunction, aimItem);
+}
+
+OptionalItem StudentsInRangeIterator(int lowestStudentNumber, int highestStudentNumber, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
+    // Visits the students with student numbers from 'lowestStudentNumber' to 'highestStudentNumber', in ascending order.
+    return RangeItemIterator(StudentType, "primary", makeNumberKey(lowestStudentNumber), makeNumberKey(highestStudentNumber), aimFunction, aimItem);
+}
+
+// MARK: - COURSE CODE DICTIONARY
+
+/* In binary format, every course has an ID besides its course code, and a registration refers to its course with
+ that ID. Courses file is the dictionary of course codes, it is kept in memory as a 'CodeDictionary' from IDs to
+ codes, and an active registration is decoded with the current code of its course ID. So when the code of a course
+ is changed, updated course keeps its ID, and registrations of the course are not rewritten, see
+ 'updateRegistrationsAfterCourseOrStudentsUniqueKeyHasChanged'. Course index of registrations is keyed by course
+ IDs in binary format, so it doesn't change either. IDs of courses are given from the 'nextID' of the courses file.
+ 
+ A registration also keeps the code of its course, which is written again when the registration is invalidated, so an
+ invalidated registration keeps the code it had, even if its course is removed or its code is changed later. Text
+ files stay in their original format, registrations of a text file have only the codes of their courses.
+ 
+ Dictionary is built with one scan of the courses file when it is first used, by 'courseIDOfCode' or 'codeOfCourseID'
+ themselves, so a registration that is written before any scan, i.e. by a fresh process, gets the ID of its course.
+ It is kept synchronized with the file by the same hooks as indexes, and it is synchronized before the registrations
+ file is changed, since registrations are encoded and keyed with it. Code of a removed course is kept until the code is given to another course,
+ since registrations of the course are invalidated after the course is removed. */
+
+typedef struct {
+    char **codes; // Code of every ID, NULL if the ID has no code.
+    int count; // One more than the largest ID.
+    int capacity;
+    int32_t *slots; // Open addressing hash table of the IDs of codes, -1 is an empty slot.
+    int slotCount;
+} CodeDictionary;
+
+typedef struct {
+    bool isLoaded;
+    TableStamp tableStamp;
+    CodeDictionary codes;
+} CourseDictionary;
+
+CourseDictionary courseDictionary;
+
+// MARK: Dictionary of codes
+
+uint32_t hashOfCode(const char *code) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (; *code != '\0'; code++) { hash = (hash ^ (unsigned char)*code) * 16777619u; }
+    return hash;
+}
+
+int32_t *slotOfCode(const CodeDictionary *dictionary, const char *code) {
+    // Returns the slot of 'code', or the empty slot it would be put in.
+    uint32_t mask = (uint32_t)dictionary->slotCount - 1;
+    for (uint32_t i = hashOfCode(code) & mask;; i = (i + 1) & mask) {
+        int32_t *slot = &dictionary->slots[i];
+        if (*slot < 0 || strcmp(dictionary->codes[*slot], code) == 0) { return slot; }
+    }
+}
+
+int32_t findCodeID(const CodeDictionary *dictionary, const char *code) {
+    // Returns the ID of 'code', or -1 if it is not in 'dictionary'.
+    if (dictionary->slotCount == 0) { return -1; }
+    return *slotOfCode(dictionary, code);
+}
+
+void rebuildCodeSlots(CodeDictionary *dictionary, int slotCount) {
+    int32_t *slots = malloc(slotCount*sizeof(int32_t));
+    if (slots == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'rebuildCodeSlots' function.\n"); exit(1); }
+    free(dictionary->slots);
+    dictionary->slots = slots; dictionary->slotCount = slotCount;
+    for (int i = 0; i < slotCount; i++) { slots[i] = -1; }
+    for (int32_t ID = 0; ID < dictionary->count; ID++) {
+        if (dictionary->codes[ID] != NULL) { *slotOfCode(dictionary, dictionary->codes[ID]) = ID; }
+    }
+}
+
+void setCodeOfID(CodeDictionary *dictionary, int32_t ID, const char *code) {
+    /* Gives 'code' to 'ID'. A code belongs to one ID, so it is taken from the ID it belonged to. Slots are rebuilt
+     when a code is taken from an ID, and they are doubled when they become half full. */
+    if (ID < 0 || (ID < dictionary->count && dictionary->codes[ID] != NULL && strcmp(dictionary->codes[ID], code) == 0)) { return; }
+    if (ID >= dictionary->capacity) {
+        int capacity = (dictionary->capacity == 0) ? 64 : dictionary->capacity;
+        while (capacity <= ID) { capacity *= 2; }
+        char **codes = realloc(dictionary->codes, capacity*sizeof(char*));
+        if (codes == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'setCodeOfID' function.\n"); exit(1); }
+        memset(codes + dictionary->capacity, 0, (capacity - dictionary->capacity)*sizeof(char*));
+        dictionary->codes = codes; dictionary->capacity = capacity;
+    }
+    bool codeIsTaken = false;
+    int32_t previousID = findCodeID(dictionary, code);
+    if (previousID >= 0) { free(dictionary->codes[previousID]); dictionary->codes[previousID] = NULL; codeIsTaken = true; }
+    if (ID < dictionary->count && dictionary->codes[ID] != NULL) { free(dictionary->codes[ID]); codeIsTaken = true; }
+    if (ID >= dictionary->count) { dictionary->count = ID + 1; }
+    dictionary->codes[ID] = copyString(code);
+    if (codeIsTaken || 2*dictionary->count > dictionary->slotCount) {
+        int slotCount = (dictionary->slotCount == 0) ? 64 : dictionary->slotCount;
+        while (2*dictionary->count > slotCount) { slotCount *= 2; }
+        rebuildCodeSlots(dictionary, slotCount);
+    } else {
+        *slotOfCode(dictionary, code) = ID;
+    }
+}
+
+int32_t internCode(CodeDictionary *dictionary, const char *code) {
+    // Returns the ID of 'code', gives it the next ID if it is not in 'dictionary'.
+    int32_t ID = findCodeID(dictionary, code);
+    if (ID < 0) { ID = dictionary->count; setCodeOfID(dictionary, ID, code); }
+    return ID;
+}
+
+void freeCodeDictionary(CodeDictionary *dictionary) {
+    for (int i = 0; i < dictionary->count; i++) { free(dictionary->codes[i]); }
+    free(dictionary->codes); free(dictionary->slots);
+    memset(dictionary, 0, sizeof(CodeDictionary));
+}
+
+// MARK: Codes of courses
+
+const char *codeOfCourseID(int32_t ID) {
+    // Returns the current code of the course with 'ID', or NULL if there is no such course.
+    if (!courseDictionary.isLoaded) { synchronizeCourseDictionary(); }
+    const CodeDictionary *dictionary = &courseDictionary.codes;
+    return (ID >= 0 && ID < dictionary->count) ? dictionary->codes[ID] : NULL;
+}
+
+int32_t courseIDOfCode(const char *code) {
+    // Returns the ID of the course with 'code', or -1 if there is no such course.
+    if (!courseDictionary.isLoaded) { synchronizeCourseDictionary(); }
+    return (code != NULL) ? findCodeID(&courseDictionary.codes, code) : -1;
+}
+
+void dropCourseDictionary() {
+    freeCodeDictionary(&courseDictionary.codes); courseDictionary.isLoaded = false;
+}
+
+bool courseDictionaryBuilderVisitor(Item item, long offset, void *context) {
+    setCodeOfID(context, item.value.course.ID, item.value.course.code);
+    return false;
+}
+
+void synchronizeCourseDictionary() {
+    // Builds the dictionary if it is not loaded, or if the courses file has changed since it was stamped.
+    if (databaseFormat != BinaryFormat) { return; }
+    TableStamp current;
+    getTableStamp(CourseType, &current);
+    if (courseDictionary.isLoaded && tableStampsAreEqual(current, courseDictionary.tableStamp)) { return; }
+    dropCourseDictionary();
+    RecordScanner(CourseType, courseDictionaryBuilderVisitor, &courseDictionary.codes);
+    courseDictionary.isLoaded = true; courseDictionary.tableStamp = current;
+}
+
+void stampCourseDictionary() {
+    if (courseDictionary.isLoaded) { getTableStamp(CourseType, &courseDictionary.tableStamp); }
+}
+
+void courseDictionaryItemWritten(Item item) {
+    // Called after a course is written, a removed course isn't passed, see above.
+    if (item.type != CourseType || !courseDictionary.isLoaded) { return; }
+    setCodeOfID(&courseDictionary.codes, item.value.course.ID, item.value.course.code);
+}
+
+// MARK: - COLUMNAR REGISTRATIONS
+
+/* Registrations are filtered only by their student number, course code and whether they are still registered, but
+ a scan decodes every field of every record. So registrations are also kept in memory column by column: IDs, student
+ numbers and course IDs are packed 32 bit integers, 'stillRegistered' is a bitmap, and dates are in a column of their
+ own. Course codes are replaced by IDs given by a 'CodeDictionary', so a course code is compared once per filter, not
+ once per record. A filter compares a whole column with SSE2 or AVX2 instructions, 4 or 8 rows at once, and ANDs
+ the result into a bitmap of matching rows, so only the matching rows are turned into items.
+ 
+ Columns are not a file, they are built with one scan of the records file when they are first used, and they are kept
+ synchronized with the file by the same hooks as indexes, see 'Keeping indexes synchronized with records files'.
+ They are stamped with the state of the records file like an index, and dropped if the file is changed by someone
+ else, or rewritten, i.e. by compaction. Rows are in the order of their records in the file. Columns are used by
+ 'RegistrationsOfCourseOrStudentIterator' and for finding registrations when indexes are disabled, '--no-columns'
+ disables them. */
+
+#define COLUMN_ROW_ALIGNMENT 64 // Rows of a bitmap word, columns are allocated in multiples of it, so kernels need no tail loop.
+
+bool columnarRegistrations = true;
+
+typedef struct {
+    bool isLoaded;
+    StorageFormat format;
+    TableStamp tableStamp;
+    int count;
+    int capacity;
+    int64_t *offsets;
+    int32_t *IDs;
+    int32_t *studentNumbers;
+    int32_t *courseIDs;
+    uint64_t *liveRows; // Bitmap of the rows whose records are not removed.
+    uint64_t *stillRegistered;
+    char (*dates)[DATE_LENGTH];
+    CodeDictionary courseCodes;
+} RegistrationColumns;
+
+typedef struct {
+    int32_t ID; // Negative values match any ID.
+    int32_t studentNumber; // Negative values match any student number.
+    const char *courseCode; // NULL matches any course code.
+    bool onlyActive;
+} RegistrationFilter;
+
+RegistrationColumns registrationColumns;
+
+// MARK: Rows
+
+void freeRegistrationColumns(RegistrationColumns *columns) {
+    free(columns->offsets); free(columns->IDs); free(columns->studentNumbers); free(columns->courseIDs);
+    free(columns->liveRows); free(columns->stillRegistered); free(columns->dates);
+    freeCodeDictionary(&columns->courseCodes);
+    memset(columns, 0, sizeof(RegistrationColumns));
+}
+
+void dropRegistrationColumns() { freeRegistrationColumns(&registrationColumns); }
+
+void *growColumn(void *column, int capacity, size_t width) {
+    void *grownColumn = realloc(column, capacity*width);
+    if (grownColumn == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'growColumn' function.\n"); exit(1); }
+    return grownColumn;
+}
+
+void setRowBit(uint64_t *bitmap, int row, bool value) {
+    if (value) { bitmap[row/64] |= (uint64_t)1 << (row % 64); } else { bitmap[row/64] &= ~((uint64_t)1 << (row % 64)); }
+}
+
+void setRegistrationRow(RegistrationColumns *columns, int row, Registration registration) {
+    columns->IDs[row] = registration.ID;
+    columns->studentNumbers[row] = registration.studentNumber;
+    columns->courseIDs[row] = internCode(&columns->courseCodes, registration.courseCode);
+    setRowBit(columns->stillRegistered, row, registration.stillRegistered);
+    strncpy(columns->dates[row], registration.date, DATE_LENGTH - 1); columns->dates[row][DATE_LENGTH-1] = '\0';
+}
+
+void appendRegistrationRow(RegistrationColumns *columns, Registration registration, long offset) {
+    if (columns->count == columns->capacity) {
+        int capacity = (columns->capacity == 0) ? 16*COLUMN_ROW_ALIGNMENT : 2*columns->capacity;
+        columns->offsets = growColumn(columns->offsets, capacity, sizeof(int64_t));
+        columns->IDs = growColumn(columns->IDs, capacity, sizeof(int32_t));
+        columns->studentNumbers = growColumn(columns->studentNumbers, capacity, sizeof(int32_t));
+        columns->courseIDs = growColumn(columns->courseIDs, capacity, sizeof(int32_t));
+        columns->liveRows = growColumn(columns->liveRows, capacity/64, sizeof(uint64_t));
+        columns->stillRegistered = growColumn(columns->stillRegistered, capacity/64, sizeof(uint64_t));
+        columns->dates = growColumn(columns->dates, capacity, DATE_LENGTH);
+        // Rows after 'count' are compared by the kernels, they are zeroed so they are defined, their bits are always zero.
+        int added = capacity - columns->capacity;
+        memset(columns->IDs + columns->capacity, 0, added*sizeof(int32_t));
+        memset(columns->studentNumbers + columns->capacity, 0, added*sizeof(int32_t));
+        memset(columns->courseIDs + columns->capacity, 0, added*sizeof(int32_t));
+        memset(columns->liveRows + columns->capacity/64, 0, added/64*sizeof(uint64_t));
+        memset(columns->stillRegistered + columns->capacity/64, 0, added/64*sizeof(uint64_t));
+        columns->capacity = capacity;
+    }
+    int row = columns->count++;
+    columns->offsets[row] = offset;
+    setRowBit(columns->liveRows, row, true);
+    setRegistrationRow(columns, row, registration);
+}
+
+int rowOfOffset(const RegistrationColumns *columns, long offset) {
+    // Rows are in the order of their offsets, so the row is found with binary search, returns -1 if there is no such row.
+    int low = 0, high = columns->count - 1;
+    while (low <= high) {
+        int middle = low + (high - low)/2;
+        if (columns->offsets[middle] == offset) { return middle; }
+        if (columns->offsets[middle] < offset) { low = middle + 1; } else { high = middle - 1; }
+    }
+    return -1;
+}
+
+Registration registrationOfRow(const RegistrationColumns *columns, int row) {
+    // Strings of the registration are views into the columns, so it is valid until the columns change.
+    Registration registration = { columns->IDs[row], columns->studentNumbers[row], columns->courseCodes.codes[columns->courseIDs[row]],
+        (columns->stillRegistered[row/64] >> (row % 64)) & 1, (char*)columns->dates[row] };
+    return registration;
+}
+
+// MARK: Keeping columns synchronized with the records file
+
+bool registrationColumnsBuilderVisitor(Item item, long offset, void *context) {
+    appendRegistrationRow(context, item.value.registration, offset);
+    return false;
+}
+
+bool loadRegistrationColumns() {
+    // Builds the columns if they are not loaded, or if they are stale. Returns false if columns are disabled.
+    if (!columnarRegistrations) { return false; }
+    RegistrationColumns *columns = &registrationColumns;
+    TableStamp current;
+    getTableStamp(RegistrationType, &current);
+    if (columns->isLoaded && columns->format == databaseFormat && tableStampsAreEqual(current, columns->tableStamp)) { return true; }
+    dropRegistrationColumns();
+    RecordScanner(RegistrationType, registrationColumnsBuilderVisitor, columns);
+    columns->isLoaded = true; columns->format = databaseFormat; columns->tableStamp = current;
+    return true;
+}
+
+void synchronizeRegistrationColumns() {
+    // Called before the records file is changed, stale columns are dropped, so the change isn't applied to them.
+    RegistrationColumns *columns = &registrationColumns;
+    if (!columns->isLoaded) { return; }
+    TableStamp current;
+    getTableStamp(RegistrationType, &current);
+    if (columns->format != databaseFormat || !tableStampsAreEqual(current, columns->tableStamp)) { dropRegistrationColumns(); }
+}
+
+void stampRegistrationColumns() {
+    RegistrationColumns *columns = &registrationColumns;
+    if (columns->isLoaded && columns->format == databaseFormat) { getTableStamp(RegistrationType, &columns->tableStamp); }
+}
+
+bool registrationColumnsAreUsable(ItemType type) {
+    return type == RegistrationType && registrationColumns.isLoaded && registrationColumns.format == databaseFormat;
+}
+
+void registrationColumnsItemAdded(Item item, long offset) {
+    RegistrationColumns *columns = &registrationColumns;
+    if (!registrationColumnsAreUsable(item.type)) { return; }
+    // Records are appended, so a row that isn't after the last row means the columns are out of order.
+    if (columns->count > 0 && offset <= columns->offsets[columns->count-1]) { dropRegistrationColumns(); return; }
+    appendRegistrationRow(columns, item.value.registration, offset);
+}
+
+void registrationColumnsItemChanged(Item newVersion, long offset) {
+    if (!registrationColumnsAreUsable(newVersion.type)) { return; }
+    int row = rowOfOffset(&registrationColumns, offset);
+    if (row < 0) { dropRegistrationColumns(); return; }
+    setRegistrationRow(&registrationColumns, row, newVersion.value.registration);
+}
+
+void registrationColumnsItemRemoved(Item item, long offset) {
+    if (!registrationColumnsAreUsable(item.type)) { return; }
+    int row = rowOfOffset(&registrationColumns, offset);
+    if (row < 0) { dropRegistrationColumns(); return; }
+    setRowBit(registrationColumns.liveRows, row, false); setRowBit(registrationColumns.stillRegistered, row, false);
+}
+
+void shiftRegistrationColumns(const OffsetShift *shift) {
+    // Rows stay in the order of their records, only their offsets move, see 'Shifting offsets of resized records'.
+    RegistrationColumns *columns = &registrationColumns;
+    if (!registrationColumnsAreUsable(RegistrationType)) { return; }
+    for (int row = 0; row < columns->count; row++) { columns->offsets[row] = shiftedOffset(shift, (long)columns->offsets[row]); }
+}
+
+void renameCourseInRegistrationColumns(const char *oldCode, const char *newCode) {
+    /* Called after the code of a course is changed in binary format, since its registrations are not rewritten, see
+     'COURSE CODE DICTIONARY'. Active registrations of the course are moved to the new code, invalidated ones keep the old code. */
+    RegistrationColumns *columns = &registrationColumns;
+    if (!registrationColumnsAreUsable(RegistrationType)) { return; }
+    int32_t oldID = findCodeID(&columns->courseCodes, oldCode);
+    if (oldID < 0) { return; }
+    int32_t newID = internCode(&columns->courseCodes, newCode);
+    for (int row = 0; row < columns->count; row++) {
+        bool isActive = (columns->liveRows[row/64] & columns->stillRegistered[row/64]) >> (row % 64) & 1;
+        if (isActive && columns->courseIDs[row] == oldID) { columns->courseIDs[row] = newID; }
+    }
+}
+
+// MARK: Filtering columns
+
+void filterInt32ColumnScalar(const int32_t *column, int wordCount, int32_t value, uint64_t *matches) {
+    for (int word = 0; word < wordCount; word++) {
+        if (matches[word] == 0) { continue; }
+        uint64_t mask = 0;
+        for (int i = 0; i < 64; i++) { mask |= (uint64_t)(column[64*word + i] == value) << i; }
+        matches[word] &= mask;
+    }
+}
+
+#ifdef VECTOR_KERNELS
+
+void filterInt32ColumnSSE2(const int32_t *column, int wordCount, int32_t value, uint64_t *matches) {
+    const __m128i values = _mm_set1_epi32(value);
+    for (int word = 0; word < wordCount; word++) {
+        if (matches[word] == 0) { continue; }
+        uint64_t mask = 0; const int32_t *rows = column + 64*word;
+        for (int i = 0; i < 64; i += 4) {
+            __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(rows + i)), values);
+            mask |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(equal)) << i;
+        }
+        matches[word] &= mask;
+    }
+}
+
+__attribute__((target("avx2"))) void filterInt32ColumnAVX2(const int32_t *column, int wordCount, int32_t value, uint64_t *matches) {
+    const __m256i values = _mm256_set1_epi32(value);
+    for (int word = 0; word < wordCount; word++) {
+        if (matches[word] == 0) { continue; }
+        uint64_t mask = 0; const int32_t *rows = column + 64*word;
+        for (int i = 0; i < 64; i += 8) {
+            __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(rows + i)), values);
+            mask |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(equal)) << i;
+        }
+        matches[word] &= mask;
+    }
+}
+
+#endif
+
+void filterInt32Column(VectorKernel kernel, const int32_t *column, int wordCount, int32_t value, uint64_t *matches) {
+    // Clears the bits of 'matches' whose rows in 'column' are not equal to 'value', words that are already zero are skipped.
+    switch (kernel) {
+#ifdef VECTOR_KERNELS
+        case AVX2Kernel: filterInt32ColumnAVX2(column, wordCount, value, matches); return;
+        case SSE2Kernel: filterInt32ColumnSSE2(column, wordCount, value, matches); return;
+#endif
+        default: filterInt32ColumnScalar(column, wordCount, value, matches); return;
+    }
+}
+
+uint64_t *filterRegistrationColumns(const RegistrationColumns *columns, RegistrationFilter filter, VectorKernel kernel) {
+    /* Returns a bitmap of the rows that match 'filter', it should be freed by the caller. Bitmap starts as the live or
+     the active rows, and every condition of 'filter' narrows it with one pass over its column. */
+    int wordCount = (columns->count + COLUMN_ROW_ALIGNMENT - 1)/COLUMN_ROW_ALIGNMENT;
+    uint64_t *matches = malloc((wordCount + 1)*sizeof(uint64_t));
+    if (matches == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'filterRegistrationColumns' function.\n"); exit(1); }
+    if (wordCount > 0) { memcpy(matches, filter.onlyActive ? columns->stillRegistered : columns->liveRows, wordCount*sizeof(uint64_t)); }
+    if (filter.courseCode != NULL) {
+        int32_t courseID = findCodeID(&columns->courseCodes, filter.courseCode);
+        if (courseID < 0) { memset(matches, 0, wordCount*sizeof(uint64_t)); return matches; }
+        filterInt32Column(kernel, columns->courseIDs, wordCount, courseID, matches);
+    }
+    if (filter.studentNumber >= 0) { filterInt32Column(kernel, columns->studentNumbers, wordCount, filter.studentNumber, matches); }
+    if (filter.ID >= 0) { filterInt32Column(kernel, columns->IDs, wordCount, filter.ID, matches); }
+    return matches;
+}
+
+// MARK: Iterating over filtered registrations
+
+typedef struct {
+    Item *items;
+    long *offsets;
+    int count;
+} RegistrationMatches;
+
+RegistrationMatches collectRegistrationMatches(RegistrationFilter filter, int limit, Arena *arena) {
+    /* Copies at most 'limit' registrations that match 'filter' to 'arena', in the order of their records. Matches are
+     copied before they are visited, so they stay valid if the visitor changes the registrations. */
+    RegistrationColumns *columns = &registrationColumns;
+    RegistrationMatches matches = { NULL, NULL, 0 };
+    uint64_t *bitmap = filterRegistrationColumns(columns, filter, selectVectorKernel());
+    int wordCount = (columns->count + COLUMN_ROW_ALIGNMENT - 1)/COLUMN_ROW_ALIGNMENT, matchCount = 0;
+    for (int word = 0; word < wordCount; word++) { matchCount += __builtin_popcountll(bitmap[word]); }
+    matchCount = (matchCount < limit) ? matchCount : limit;
+    matches.items = allocateFromArena(arena, (matchCount + 1)*sizeof(Item));
+    matches.offsets = allocateFromArena(arena, (matchCount + 1)*sizeof(long));
+    for (int word = 0; word < wordCount && matches.count < matchCount; word++) {
+        for (uint64_t bits = bitmap[word]; bits != 0 && matches.count < matchCount; bits &= bits - 1) {
+            int row = 64*word + __builtin_ctzll(bits);
+            Registration registration = registrationOfRow(columns, row);
+            registration.courseCode = strcpy(allocateFromArena(arena, strlen(registration.courseCode) + 1), registration.courseCode);
+            registration.date = strcpy(allocateFromArena(arena, DATE_LENGTH), registration.date);
+            matches.items[matches.count] = wrapRegistration(registration); matches.offsets[matches.count++] = (long)columns->offsets[row];
         }
-        while (fgets(buffer, 255, file)) {
-            if (strcmp(buffer, checkString) != 0) { fprintf(tmp, "%s", buffer); }
-            else { for (int i = 0; i <= count; i++) { fgets(buffer, 255, file); } }
+    }
+    free(bitmap);
+    return matches;
+}
+
+OptionalItem RegistrationColumnIterator(RegistrationFilter filter, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
+    // Visits the registrations that match 'filter' like 'ItemIterator', items passed to 'aimFunction' are borrowed.
+    OptionalItem optionalItem; optionalItem.hasValue = false;
+    if (!loadRegistrationColumns()) { return ItemIterator(RegistrationType, aimFunction, aimItem); }
+    Arena arena = EMPTY_ARENA;
+    RegistrationMatches matches = collectRegistrationMatches(filter, INT32_MAX, &arena);
+    for (int i = 0; i < matches.count; i++) {
+        optionalItem = aimFunction(matches.items[i], aimItem);
+        optionalItem.item.type = RegistrationType;
+        if (optionalItem.hasValue) { optionalItem.item = copyItem(optionalItem.item); break; }
+    }
+    releaseArena(&arena);
+    return optionalItem;
+}
+
+OptionalItem RegistrationColumnsOfCourseOrStudentIterator(Item courseOrStudent, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
+    RegistrationFilter filter = { -1, -1, NULL, true };
+    if (courseOrStudent.type == CourseType) { filter.courseCode = courseOrStudent.value.course.code; }
+    else { filter.studentNumber = courseOrStudent.value.student.studentNumber; }
+    return RegistrationColumnIterator(filter, aimFunction, aimItem);
+}
+
+bool findRegistrationWithColumns(Item item, OptionalItem *optionalItem, long *offset) {
+    /* Finds the registration that 'conditionForQuery' would find, an active registration with the ID of 'item', or
+     with its student number and course code. Returns false if columns are disabled. */
+    if (item.type != RegistrationType || !loadRegistrationColumns()) { return false; }
+    Registration registration = item.value.registration; Arena arena = EMPTY_ARENA;
+    RegistrationFilter byID = { registration.ID, -1, NULL, true };
+    RegistrationMatches matches = { NULL, NULL, 0 };
+    if (registration.ID >= 0) { matches = collectRegistrationMatches(byID, 1, &arena); }
+    if (matches.count == 0 && registration.courseCode != NULL) {
+        RegistrationFilter byCourseAndStudent = { -1, registration.studentNumber, registration.courseCode, true };
+        matches = collectRegistrationMatches(byCourseAndStudent, 1, &arena);
+    }
+    optionalItem->hasValue = matches.count > 0; *offset = -1;
+    if (optionalItem->hasValue) { optionalItem->item = copyItem(matches.items[0]); *offset = matches.offsets[0]; }
+    releaseArena(&arena);
+    return true;
+}
+
+// MARK: - TABLE HEADERS
+
+/* Number of the records of a file, number of its removed records, and the next ID to be given to a record of it,
+ are kept in the header of the file. In binary format, header is the first block of the file, and counts are
+ written to it in the same logged operation as the change of the file. Text files stay in their original format, so
+ their header is a small file next to them, i.e. 'Students.txt.header', which is stamped with the state of the text
+ file like an index, and written after every change of the text file. If a file is changed by someone else, or its
+ header doesn't have the counts, records are counted once with a pass over the file. Counts of the files are also
+ kept in memory, so getting them doesn't read a file. IDs are given from 'nextID', which never decreases, so they
+ stay unique after records are removed or compacted. */
+
+#define TEXT_HEADER_MAGIC "FBTH"
+#define TEXT_HEADER_VERSION 1
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    TableStamp tableStamp;
+    TableCounts counts;
+} TextTableHeader;
+
+typedef struct {
+    bool isLoaded;
+    TableStamp tableStamp;
+    TableCounts counts;
+} TableHeader;
+
+TableHeader tableHeaders[2][4];
+
+// MARK: Counting records
+
+long countTombstonesOfAFile(ItemType type) {
+    // Counts the removed records of the file of 'type' with one pass over the file.
+    long count = 0;
+    FILE *file = openTableStream(type);
+    if (file == NULL) { return 0; }
+    if (databaseFormat == BinaryFormat) {
+        unsigned char record[MAX_RECORD_SIZE]; int recordSize = getRecordSizeForType(type);
+        if (readBinaryHeader(type, file)) {
+            while (fread(record, recordSize, 1, file) == 1) { if (!binaryRecordIsLive(record)) { count++; } }
         }
-        fclose(file); remove(fileName); rename("tmp.txt", fileName); fclose(tmp);
-    }
-    free(buffer); free(fileName); free(checkString); free(error);
-    
-    if (!forUpdate) {
-        // Make necessary changes in database after removal, if item is not removed as a part of an update process.
-        printf("%s", success);
-        Course course;
-        switch (item.type) {
-            case InstructorType:
-                /* If removed item is of type InstructorType, then remove all the courses associated with the
-                 deleted instructor's instructorID, this also going to trigger all registrations that associated
-                 with courses given by this instructor, to get cancelled. */
-                removeCoursesGivenByInstructor(item); break;
-            case RegistrationType:
-                /* If removed item is of type RegistrationType, then student's credit value
-                 and course's quota value should get updated according to the registration. */
-                course = getItem(wrapCourseWithCode(item.value.registration.courseCode)).value.course;
-                updateStudentsCreditStatus(item.value.registration.studentNumber, false, course.credit, true);
-                updateCourseQuota(course.code, false); freeItem(wrapCourse(course)); break;
-            default:
-                /* This will invalidate all registrations associated with 'item'. If 'item' is of type CourseType,
-                 then all registrations with the same course code as 'item' will be removed, if 'item' is of type StudentType,
-                 then all registrations made with the same studentNumber will be removed from the database. */
-                invalidateRegistrationsAfterCourseOrStudentRemoval(item, credit); break;
+    } else {
+        // Only the first line of a removed record starts with '#', file is read in chunks and lines are found with 'findNewline'.
+        char chunk[TEXT_CHUNK_SIZE]; size_t length; bool isAtLineStart = true;
+        while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            for (const char *cursor = chunk, *end = chunk + length; cursor < end;) {
+                if (isAtLineStart && *cursor == TEXT_TOMBSTONE) { count++; }
+                const char *newline = findNewline(cursor, end);
+                isAtLineStart = newline < end;
+                cursor = isAtLineStart ? newline + 1 : end;
+            }
         }
     }
-    free(success); freeItem(item);
+    fclose(file);
+    return count;
 }
 
-/* If 'removeItemBase' function should print success message, then its 'forUpdate' parameter
- should be false, otherwise it should be true. Functions below are just convenience functions for calling
- 'removeItemBase' function. */
+bool nextIDVisitor(Item item, long offset, void *context) {
+    // Finds the ID after the largest ID of the registrations, or of the courses.
+    int64_t *nextID = context;
+    int ID = (item.type == CourseType) ? item.value.course.ID : item.value.registration.ID;
+    if (ID >= *nextID) { *nextID = (int64_t)ID + 1; }
+    return false;
+}
 
-void removeItem(Item item) { removeItemBase(item, false); }
-void removeItemAsAPartOfUpdateProcess(Item item) { removeItemBase(item, true); }
+TableCounts countRecordsOfAFile(ItemType type) {
+    // Counts the records of the file of 'type' with a pass over the file, used when its header is missing or stale.
+    TableCounts counts; memset(&counts, 0, sizeof(counts));
+    counts.isCounted = 1;
+    counts.tombstoneCount = countTombstonesOfAFile(type);
+    counts.liveCount = countRecordSlotsOfAFile(type) - counts.tombstoneCount;
+    if (type == RegistrationType || (type == CourseType && databaseFormat == BinaryFormat)) { RecordScanner(type, nextIDVisitor, &counts.nextID); }
+    return counts;
+}
 
-// MARK: - UPDATING 'Item'
+// MARK: Reading and writing headers
+
+bool readTableHeader(ItemType type, TableStamp current, TableCounts *counts) {
+    // Reads the counts in the header of the file of 'type', returns false if header doesn't have them or they are stale.
+    char fileName[255]; bool isValid = false;
+    if (databaseFormat == BinaryFormat) {
+        BinaryTableHeader header;
+        if (!synchronizeBufferPool(type)) { return false; }
+        isValid = readFromBufferPool(type, 0, &header, sizeof(header)) == sizeof(header) && checkBinaryHeader(type, (const unsigned char *)&header);
+        *counts = header.counts;
+        return isValid && counts->isCounted;
+    }
+    TextTableHeader header;
+    getTableHeaderFileName(type, databaseFormat, fileName);
+    int descriptor = open(fileName, O_RDONLY);
+    if (descriptor < 0) { return false; }
+    isValid = pread(descriptor, &header, sizeof(header), 0) == sizeof(header);
+    close(descriptor);
+    if (!isValid || memcmp(header.magic, TEXT_HEADER_MAGIC, 4) != 0 || header.version != TEXT_HEADER_VERSION
+        || !tableStampsAreEqual(header.tableStamp, current)) { return false; }
+    *counts = header.counts;
+    return true;
+}
 
-void prepareForUpdate(Item itemToBeUpdated, Item updatedVersion, bool *uniqueIdentifierHasChanged, char *error1, char *error2) {
-    /* Convenience function for updating an Item. This function assigns error messages, and whether item's unique identifier
-     has changed with update or not, to pointers passed as parameters, according to the type of the items. */
-    switch (itemToBeUpdated.type) {
-        case InstructorType:
-            *uniqueIdentifierHasChanged = itemToBeUpdated.value.instructor.ID != updatedVersion.value.instructor.ID;
-            sprintf(error2, "Update failed. There is already an instructor with the ID: %d.\n", updatedVersion.value.instructor.ID);
-            sprintf(error1, "ERROR: Update failed. Couldn't find the instructor to be updated.\n"); return;
-        case CourseType:
-            *uniqueIdentifierHasChanged = strcmp(itemToBeUpdated.value.course.code, updatedVersion.value.course.code) != 0;
-            sprintf(error2, "ERROR: Update failed. There is already a course with the same code: %s.\n", updatedVersion.value.course.code);
-            sprintf(error1, "ERROR: Update failed. Couldn't find the course to be updated.\n"); return;
-        case StudentType:
-            *uniqueIdentifierHasChanged = itemToBeUpdated.value.student.studentNumber != updatedVersion.value.student.studentNumber;
-            sprintf(error2, "ERROR: Update failed. There is already a student with student number: %d.\n", updatedVersion.value.student.studentNumber);
-            sprintf(error1, "ERROR: Update failed. Couldn't find the student to be updated %d.\n", itemToBeUpdated.value.student.studentNumber); return;
-        case RegistrationType: return;
+void writeTableHeader(ItemType type, TableHeader *tableHeader) {
+    // In binary format, counts are written with 'writeToTable', so they are a part of the logged operation that changes the file.
+    char fileName[255];
+    if (databaseFormat == BinaryFormat && getTableEndOffset(type) == 0) { writeBinaryHeaderToTable(type, &tableHeader->counts); return; }
+    if (databaseFormat == BinaryFormat) {
+        writeToTable(type, offsetof(BinaryTableHeader, counts), &tableHeader->counts, sizeof(TableCounts)); return;
     }
+    TextTableHeader header; memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TEXT_HEADER_MAGIC, 4); header.version = TEXT_HEADER_VERSION;
+    header.tableStamp = tableHeader->tableStamp; header.counts = tableHeader->counts;
+    getTableHeaderFileName(type, databaseFormat, fileName);
+    int descriptor = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descriptor < 0 || write(descriptor, &header, sizeof(header)) != sizeof(header)) { printf("ERROR: Couldn't write to '%s'.\n", fileName); }
+    if (descriptor >= 0) { close(descriptor); }
 }
 
-void updateItemBase(Item itemToBeUpdated, Item updatedVersion, bool printMessage) {
-    /* Changes the record of 'itemToBeUpdated' with 'updatedVersion'. If unique identifier
-     of the item has changed, i.e. course code of a course, than all records that uses that
-     information gets updated, i.e. invalidate all registrations that has old course code and
-     add new registrations with new course code, for every student registered for the course so far. */
-    char *error1 = malloc(sizeof(char)*511);
-    char *error2 = malloc(sizeof(char)*511);
-    if (error1 == NULL || error2 == NULL) { printf("Couldn't allocate memory in 'updateItemBase' function.\n"); exit(1); }
-    bool uniqueIdentifierHasChanged = false;
-    prepareForUpdate(itemToBeUpdated, updatedVersion, &uniqueIdentifierHasChanged, error1, error2);
-    
-    // If 'itemToBeUpdated' is not in database, throw error
-    if (!itemIsInDatabase(itemToBeUpdated)) { printf("%s", error1); }
-    // If 'updatedVersion's unique identifier is already used by a record in database, throw error
-    else if (uniqueIdentifierHasChanged && itemIsInDatabase(updatedVersion)) {
-        printf("%s", error2);
-    } else if (itemToBeUpdated.type == CourseType && !itemIsInDatabase(wrapInstructorWithID(updatedVersion.value.course.instructorID))) {
-        printf("ERROR: Update failed. There is no instructor with the ID: %d\n", updatedVersion.value.course.instructorID);
+// MARK: Keeping headers synchronized with files
+
+void synchronizeTableHeader(ItemType type) {
+    // Reads the counts of the file again if the file has changed since they were last read, records are counted if header doesn't have them.
+    TableHeader *tableHeader = &tableHeaders[databaseFormat][type];
+    TableStamp current;
+    getTableStamp(type, &current);
+    if (tableHeader->isLoaded && tableStampsAreEqual(current, tableHeader->tableStamp)) { return; }
+    tableFileChanged(databaseFormat, type); // File may be changed by another program.
+    tableHeader->isLoaded = true; tableHeader->tableStamp = current;
+    if (readTableHeader(type, current, &tableHeader->counts)) { return; }
+    tableHeader->counts = countRecordsOfAFile(type);
+    if (current.size > 0) { writeTableHeader(type, tableHeader); } // Header of a file is written with its first record.
+}
+
+void tableHeaderChanged(ItemType type, long liveDifference, long tombstoneDifference) {
+    /* Called in the logged operation that adds or removes records of the file of 'type', after 'prepareTableForChange'.
+     Header of a text file is written after the operation is applied, by 'stampTableHeader'. */
+    TableHeader *tableHeader = &tableHeaders[databaseFormat][type];
+    tableHeader->counts.liveCount += liveDifference;
+    tableHeader->counts.tombstoneCount += tombstoneDifference;
+    if (databaseFormat == BinaryFormat) { writeTableHeader(type, tableHeader); }
+}
+
+void stampTableHeader(ItemType type) {
+    // Called after logged writes are applied to the file of 'type'.
+    TableHeader *tableHeader = &tableHeaders[databaseFormat][type];
+    if (!tableHeader->isLoaded) { return; }
+    getTableStamp(type, &tableHeader->tableStamp);
+    if (databaseFormat == TextFormat) { writeTableHeader(type, tableHeader); }
+}
+
+TableCounts getTableCounts(ItemType type) {
+    synchronizeTableHeader(type);
+    return tableHeaders[databaseFormat][type].counts;
+}
+
+long getTombstoneCountOfAFile(ItemType type) { return (long)getTableCounts(type).tombstoneCount; }
+
+long allocateTableID(ItemType type) {
+    // Returns the next ID of the file of 'type', it should be called in the logged operation that adds the record with the ID.
+    prepareTableForChange(type);
+    TableHeader *tableHeader = &tableHeaders[databaseFormat][type];
+    long ID = (long)tableHeader->counts.nextID++;
+    tableHeaderChanged(type, 0, 0);
+    return ID;
+}
+
+// MARK: - COMPACTION
+
+/* Removed instructors, courses and students stay in their files as tombstones, so removing a record writes only one
+ byte. When tombstones make up 'compactionGarbageRatio' of a file, the file is compacted: records that are not
+ removed are copied to a new file as they are, in the same order, and the new file replaces the old one. Number of
+ tombstones of a file is kept in its header. Registrations are never removed from their file, so they are never
+ compacted. */
+
+double compactionGarbageRatio = 0.5;
+
+long compactTable(ItemType type) {
+    // Copies the records that are not removed to a new file, and replaces the file with it. Returns the number of records reclaimed.
+    char fileName[255]; char temporaryFileName[255];
+    getFileNameForType(type, fileName);
+    sprintf(temporaryFileName, "tmp.%s", (databaseFormat == BinaryFormat) ? "dat" : "txt");
+    checkpointLog(); // Offsets in the log would be wrong for the compacted file.
+    TableCounts counts = getTableCounts(type); counts.liveCount = 0;
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) { return 0; }
+    FILE *tmp = fopen(temporaryFileName, "wb");
+    if (tmp == NULL) { printf("ERROR: Couldn't open '%s' at 'compactTable' function.\n", temporaryFileName); fclose(file); return 0; }
+    long reclaimed = 0;
+    if (databaseFormat == BinaryFormat) {
+        unsigned char record[MAX_RECORD_SIZE]; int recordSize = getRecordSizeForType(type);
+        if (!readBinaryHeader(type, file)) { fclose(file); fclose(tmp); remove(temporaryFileName); return 0; }
+        writeBinaryHeader(type, NULL, tmp);
+        while (fread(record, recordSize, 1, file) == 1) {
+            if (binaryRecordIsLive(record)) { fwrite(record, recordSize, 1, tmp); counts.liveCount++; } else { reclaimed++; }
+        }
+        // Header is written again with the counts of the compacted file, 'nextID' doesn't change.
+        counts.tombstoneCount = 0; rewind(tmp); writeBinaryHeader(type, &counts, tmp);
     } else {
-        int difference = 0;
-        if (printMessage) {
-            if (itemToBeUpdated.type == CourseType) {
-                Item item = getItem(itemToBeUpdated);
-                difference = updatedVersion.value.course.credit - item.value.course.credit;
-                updatedVersion.value.course.quota.registered = item.value.course.quota.registered; freeItem(item);
-            } else if (itemToBeUpdated.type == StudentType) {
-                Item item = getItem(itemToBeUpdated);
-                updatedVersion.value.student.numberOfCoursesRegistered = item.value.student.numberOfCoursesRegistered;
-                updatedVersion.value.student.numberOfCreditsTaken = item.value.student.numberOfCreditsTaken; freeItem(item);
+        // Records are copied line by line, every instructor record has 5 lines and other records have 6 lines.
+        int recordLength = (type == InstructorType) ? 5 : 6;
+        char *line = NULL; size_t capacity = 0; bool isRemoved = false;
+        for (long lineNumber = 0; getline(&line, &capacity, file) != -1; lineNumber++) {
+            if (lineNumber % recordLength == 0) {
+                isRemoved = line[0] == TEXT_TOMBSTONE;
+                if (isRemoved) { reclaimed++; } else { counts.liveCount++; }
             }
+            if (!isRemoved) { fputs(line, tmp); }
         }
-        // Remove old item from database, add new item to the database
-        removeItemAsAPartOfUpdateProcess(itemToBeUpdated); addItemAsAPartOfUpdateProcess(updatedVersion);
-        if (printMessage) { printf("Updated succesfully!\n"); }
-        
-        // If unique identifier has changed for an item...
-        if (uniqueIdentifierHasChanged) {
-            switch (updatedVersion.type) {
-                case InstructorType:
-                    // If instructor's ID has changed, then reflect that change to course records.
-                    updateCoursesAfterInstructorIDChange(itemToBeUpdated, updatedVersion); break;
-                case CourseType:
-                    // If course's course code has changed, then reflect that change to registration records.
-                    updateRegistrationsAfterCourseOrStudentsUniqueKeyHasChanged(itemToBeUpdated, updatedVersion); break;
-                case StudentType:
-                    // If student's student number has changed, then reflect that change to registration records.
-                    updateRegistrationsAfterCourseOrStudentsUniqueKeyHasChanged(itemToBeUpdated, updatedVersion); break;
-                case RegistrationType: break; // There is nothing to update about registration records.
-            }
+        free(line);
+    }
+    fclose(file); fclose(tmp); rename(temporaryFileName, fileName);
+    tableFileChanged(databaseFormat, type);
+    // Offsets of the records change after compaction, so indexes are rebuilt.
+    rebuildIndexesOfType(type);
+    TableHeader *tableHeader = &tableHeaders[databaseFormat][type];
+    counts.tombstoneCount = 0; tableHeader->counts = counts; tableHeader->isLoaded = true;
+    stampTableHeader(type);
+    return reclaimed;
+}
+
+void compactTableIfNeeded(ItemType type) {
+    // Compacts the file of 'type', if tombstones make up at least 'compactionGarbageRatio' of its records.
+    if (type == RegistrationType || loggedOperationDepth > 0) { return; } // Not in the middle of a logged operation.
+    long tombstoneCount = getTombstoneCountOfAFile(type);
+    if (tombstoneCount > 0 && tombstoneCount >= compactionGarbageRatio * getRecordSlotCountOfAFile(type)) { compactTable(type); }
+}
+
+void compactDatabase() {
+    // Compacts every file on demand, regardless of the number of its tombstones.
+    recoverFromLog();
+    ItemType types[] = { InstructorType, CourseType, StudentType };
+    for (int i = 0; i < 3; i++) {
+        char fileName[255];
+        getFileNameForType(types[i], fileName);
+        printf("Compacted '%s', reclaimed %ld removed records.\n", fileName, compactTable(types[i]));
+    }
+}
+
+// MARK: - REGISTERING IN BATCHES
+
+/* 'registerStudentsForCourses' registers students for courses like 'registerStudentForCourse' does, but for a batch
+ of requests at once, i.e. when registrations open. Students and courses of the batch are read once before any request
+ is checked, and the active registrations of the students are read once to find duplicate registrations. Requests are
+ checked in memory, in the order of the batch and with the checks of 'registerStudentForCourseBase', and a request
+ sees the registrations accepted before it, so every request gets the result it would get if requests were
+ registered one by one. Then accepted registrations are appended to the registrations file with one write, and the
+ counters of every student and course are written once with their final values, all in one logged operation.
+ In a transaction, requests are buffered one by one like 'registerStudentForCourse', so their results are not known.
+ Batches can be entered from the 'Add' menu, and 'registrationResultNames' is used to print their results. */
+
+typedef enum {
+    RegistrationIsAccepted, RegistrationIsBuffered, NoSuchCourse, NoSuchStudent, TooManyCourses, TooManyCredits, QuotaIsFull, AlreadyRegistered
+} RegistrationResult;
+
+const char *registrationResultNames[] = {
+    "RegistrationIsAccepted", "RegistrationIsBuffered", "NoSuchCourse", "NoSuchStudent", "TooManyCourses", "TooManyCredits", "QuotaIsFull", "AlreadyRegistered"
+};
+
+typedef struct {
+    char *courseCode;
+    int studentNumber;
+    RegistrationResult result;
+} RegistrationRequest;
+
+typedef struct {
+    RegistrationRequest *requests;
+    int count;
+} RegistrationBatch;
+
+typedef struct {
+    ItemType type;
+    Item *items; // Students or courses of the batch in the order they are first requested, artificial items if they are not in database.
+    Item *updatedVersions;
+    long *offsets; // -1 if the item is not in database.
+    int count;
+    int capacity;
+    int foundCount;
+    KeyTable studentPositions;
+    CodeDictionary coursePositions;
+} BatchRecords;
+
+void initializeBatchRecords(BatchRecords *records, ItemType type) {
+    memset(records, 0, sizeof(BatchRecords)); records->type = type;
+}
+
+void freeBatchRecords(BatchRecords *records) {
+    for (int i = 0; i < records->count; i++) {
+        if (records->offsets[i] >= 0) { freeItem(records->items[i]); }
+    }
+    free(records->items); free(records->updatedVersions); free(records->offsets);
+    freeKeyTable(&records->studentPositions); freeCodeDictionary(&records->coursePositions);
+}
+
+int32_t positionInBatchRecords(const BatchRecords *records, Item item) {
+    if (records->type == StudentType) { return findKey(&records->studentPositions, item.value.student.studentNumber); }
+    return findCodeID(&records->coursePositions, item.value.course.code);
+}
+
+int32_t addToBatchRecords(BatchRecords *records, Item item) {
+    // Adds the artificial 'item' if it is not in the batch yet, returns its position in the batch.
+    int32_t position = positionInBatchRecords(records, item);
+    if (position >= 0) { return position; }
+    if (records->count == records->capacity) {
+        records->capacity = (records->capacity == 0) ? 16 : 2*records->capacity;
+        records->items = realloc(records->items, records->capacity*sizeof(Item));
+        records->updatedVersions = realloc(records->updatedVersions, records->capacity*sizeof(Item));
+        records->offsets = realloc(records->offsets, records->capacity*sizeof(long));
+        if (records->items == NULL || records->updatedVersions == NULL || records->offsets == NULL) {
+            printf("EXCEPTION: Couldn't allocate memory in 'addToBatchRecords' function.\n"); exit(1);
         }
-        // If updated item is a Course item, and this course's credit has changed, then reflect that change to student records.
-        if (itemToBeUpdated.type == CourseType && (itemToBeUpdated.value.course.credit != updatedVersion.value.course.credit)) {
-            updateStudentsCreditIfCoursesCreditHasChanged(difference, updatedVersion);
+    }
+    if (records->type == StudentType) { insertKey(&records->studentPositions, item.value.student.studentNumber, records->count); }
+    else { setCodeOfID(&records->coursePositions, records->count, item.value.course.code); }
+    records->items[records->count] = item; records->updatedVersions[records->count] = item; records->offsets[records->count] = -1;
+    return records->count++;
+}
+
+void addFoundItemToBatchRecords(BatchRecords *records, Item item, long offset) {
+    // Adds a copy of 'item' whose record is at 'offset'.
+    int32_t position = addToBatchRecords(records, item);
+    if (records->offsets[position] >= 0) { return; }
+    records->items[position] = copyItem(item); records->updatedVersions[position] = records->items[position];
+    records->offsets[position] = offset; records->foundCount++;
+}
+
+bool foundItemCollectorVisitor(Item item, long offset, void *context) {
+    // Adds every visited item to the batch.
+    addFoundItemToBatchRecords(context, item, offset);
+    return false;
+}
+
+bool batchRecordsCollectorVisitor(Item item, long offset, void *context) {
+    BatchRecords *records = context;
+    if (positionInBatchRecords(records, item) >= 0) { addFoundItemToBatchRecords(records, item, offset); }
+    return records->foundCount == records->count;
+}
+
+void readBatchRecords(BatchRecords *records) {
+    // Looks every item up with the primary index, or scans the file once for all of them if indexes are disabled.
+    bool isLookedUp = indexedLookups;
+    for (int i = 0; i < records->count && isLookedUp; i++) {
+        OptionalItem optionalItem; long offset = -1;
+        if (records->offsets[i] >= 0) { continue; }
+        isLookedUp = findItemWithIndex(records->items[i], &optionalItem, &offset);
+        if (isLookedUp && optionalItem.hasValue) { records->items[i] = optionalItem.item; records->offsets[i] = offset; records->foundCount++; }
+    }
+    if (!isLookedUp && records->foundCount < records->count) { RecordScanner(records->type, batchRecordsCollectorVisitor, records); }
+    for (int i = 0; i < records->count; i++) { records->updatedVersions[i] = records->items[i]; }
+}
+
+typedef struct {
+    BatchRecords *records;
+    bool(*visitor)(Item, long, void*);
+    void *context;
+} BatchRegistrationsContext;
+
+bool batchRegistrationsVisitor(Item item, long offset, void *context) {
+    // Passes the active registrations of the students or the courses of the batch to the visitor.
+    BatchRegistrationsContext *registrationsContext = context;
+    Registration registration = item.value.registration;
+    BatchRecords *records = registrationsContext->records;
+    bool isInBatch = (records->type == StudentType) ? findKey(&records->studentPositions, registration.studentNumber) >= 0
+    : findCodeID(&records->coursePositions, registration.courseCode) >= 0;
+    if (!registration.stillRegistered || !isInBatch) { return false; }
+    return registrationsContext->visitor(item, offset, registrationsContext->context);
+}
+
+void visitRegistrationsOfBatchRecords(BatchRecords *records, bool(*visitor)(Item, long, void*), void *context) {
+    /* Visits the active registrations of the students or the courses of 'records' in the order of their records. They are
+     read with the student or course index of registrations, or with one pass over the columns of registrations, or with
+     one scan of the file if both of them are disabled. */
+    BatchRegistrationsContext registrationsContext = { records, visitor, context };
+    synchronizeCourseDictionary(); // Course codes of binary registrations are decoded with it, and course index is keyed with it.
+    OpenIndex *index = (indexedLookups) ? getIndex(findIndexDefinition(RegistrationType, (records->type == StudentType) ? "student" : "course")) : NULL;
+    if (index != NULL) {
+        OffsetList list = { NULL, 0, 0 }; Arena arena = EMPTY_ARENA;
+        for (int i = 0; i < records->count; i++) {
+            IndexKey key = (records->type == StudentType) ? makeNumberKey(records->items[i].value.student.studentNumber)
+            : makeCourseCodeKey(records->items[i].value.course.code);
+            forEachOffsetOfKey(index, key, offsetCollector, &list);
+        }
+        if (list.count > 1) { qsort(list.offsets, list.count, sizeof(long), compareOffsets); }
+        for (int i = 0; i < list.count; i++) {
+            Item item; bool shouldStop = false;
+            if (readItemAtOffsetInArena(&arena, RegistrationType, list.offsets[i], &item)) { shouldStop = batchRegistrationsVisitor(item, list.offsets[i], &registrationsContext); }
+            resetArena(&arena);
+            if (shouldStop) { break; }
         }
+        releaseArena(&arena); free(list.offsets);
+    } else if (!indexedLookups && loadRegistrationColumns()) {
+        RegistrationColumns *columns = &registrationColumns;
+        for (int row = 0; row < columns->count; row++) {
+            if (((columns->liveRows[row/64] & columns->stillRegistered[row/64]) >> (row % 64) & 1) == 0) { continue; }
+            Registration registration = registrationOfRow(columns, row);
+            if (batchRegistrationsVisitor(wrapRegistration(registration), (long)columns->offsets[row], &registrationsContext)) { break; }
+        }
+    } else {
+        RecordScanner(RegistrationType, batchRegistrationsVisitor, &registrationsContext);
     }
 }
 
-/* If 'updateItemBase' function should print success message, then its 'printMessage' parameter
- should be false, otherwise it should be true. Functions below are just convenience functions for calling
- 'updateItemBase' function. */
+typedef struct {
+    BatchRecords *courses;
+    KeyTable *registeredPairs;
+} RegisteredPairsContext;
 
-void updateItem(Item itemToBeUpdated, Item updatedVersion) {
-    updateItemBase(itemToBeUpdated, updatedVersion, true);
+int64_t makeRegisteredPair(int32_t studentNumber, int32_t coursePosition) {
+    // Student numbers can be negative in requests, so they are shifted as unsigned values.
+    return (int64_t)(((uint64_t)(uint32_t)studentNumber << 32) | (uint32_t)coursePosition);
 }
 
-void updateItemSilently(Item itemToBeUpdated, Item updatedVersion) {
-    updateItemBase(itemToBeUpdated, updatedVersion, false);
+bool registeredPairsCollectorVisitor(Item item, long offset, void *context) {
+    // Adds the registrations of the students of the batch, that are for the courses of the batch.
+    RegisteredPairsContext *pairsContext = context;
+    Registration registration = item.value.registration;
+    int32_t coursePosition = findCodeID(&pairsContext->courses->coursePositions, registration.courseCode);
+    if (coursePosition >= 0) { insertKey(pairsContext->registeredPairs, makeRegisteredPair(registration.studentNumber, coursePosition), 1); }
+    return false;
 }
 
-// MARK: - GENERIC ITERATOR FUNCTION
+bool countersOfItemsAreEqual(Item item1, Item item2) {
+    if (item1.type == CourseType) { return item1.value.course.quota.registered == item2.value.course.quota.registered; }
+    return item1.value.student.numberOfCoursesRegistered == item2.value.student.numberOfCoursesRegistered
+    && item1.value.student.numberOfCreditsTaken == item2.value.student.numberOfCreditsTaken;
+}
 
-/*
- 'ItemIterator' function is at the heart of many functionality.
- Actually, all of the functionality below, is implemented using this function.
- 
- It takes three arguments:
- - type: This parameter indicates which database file should be iterated on, and the type of the return value if needed.
- - aimFunction: This is the function that is applied in every iteration.
- - aimItem: This is passed as second parameter for aimFunction.
- 
- Basic strategy works like this: Assume we want to print every student that registered
- for a course. Then we should call iterator with 'type' value of 'RegistarionType' because
- we keep record of students that registered for some course in Registrations file.
- On every iteration, we are going to have a decoded Registration item.
- 'aimItem' should be the course that we want to print every student that registered for it.
- And 'aimFunction' takes these two as its parameters, and does the following:
- - Look whether decoded Registration item's course code is same with the aimItem's course code.
- - If that's true, then print students information.
- - If not, do nothing.
- And 'aimFunction' returns 'OptionalItem'. But if we have an operation that doesn't need to return a value--like the one above,
- we don't need to return any value for printing student information--'aimFunction' should return an 'OptionalItem' value that has
- no value--its 'hasValue' bool should be false; otherwise, if 'aimFunction' returns an OptionalItem that has a value, then iteration stops.
- 
- With passing appropriate 'aimFunction' and appropriate 'aimItem' parameter values, we can make various types of operations
- with the same strategy, for example listing every course given by a specific instructor, listing every course that a specific student registered for.
- 
- This function also can be used to get an actual 'Item' value--and is actually used in 'getItem' and 'itemIsInDatabase' functions.
- If we need to return a value, then 'aimFunction' should set its 'hasValue' bool to true, this will cause 'ItemIterator' to return that 'OptionalItem'.
- */
+void writeCountersOfBatchRecords(BatchRecords *records) {
+    // Counters of a record are written once, however many requests of the batch changed them.
+    for (int i = 0; i < records->count; i++) {
+        if (records->offsets[i] < 0 || countersOfItemsAreEqual(records->items[i], records->updatedVersions[i])) { continue; }
+        if (!overwriteCountersOfRecord(records->items[i], records->updatedVersions[i], records->offsets[i])) {
+            relocateRecord(records->items[i], records->updatedVersions[i], records->offsets[i]);
+        }
+    }
+}
 
-void prepareForIteration(ItemType type, char *fileName, Item(**decodingFunction)(FILE*)) {
-    getFileNameForType(type, fileName);
-    switch (type) {
-        case InstructorType: *decodingFunction = readInstructorFromFile; return;
-        case CourseType: *decodingFunction = readCourseFromFile; return;
-        case StudentType: *decodingFunction = readStudentFromFile; return;
-        case RegistrationType: *decodingFunction = readRegistrationFromFile; return;
+void appendBatchRegistrations(Registration *registrations, int count) {
+    // Appends 'registrations' with one write, and gives them the next IDs of the file.
+    char *bytes = NULL; size_t length = 0;
+    long *recordOffsets = malloc((count + 1)*sizeof(long));
+    FILE *stream = open_memstream(&bytes, &length);
+    if (recordOffsets == NULL || stream == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'appendBatchRegistrations' function.\n"); exit(1); }
+    prepareTableForChange(RegistrationType);
+    TableHeader *tableHeader = &tableHeaders[databaseFormat][RegistrationType];
+    for (int i = 0; i < count; i++) {
+        registrations[i].ID = (int)tableHeader->counts.nextID++;
+        recordOffsets[i] = ftell(stream);
+        if (databaseFormat == BinaryFormat) {
+            unsigned char record[MAX_RECORD_SIZE];
+            encodeItemToRecord(wrapRegistration(registrations[i]), record);
+            fwrite(record, getRecordSizeForType(RegistrationType), 1, stream);
+        } else {
+            encodeItemAsText(wrapRegistration(registrations[i]), stream);
+        }
     }
+    fclose(stream);
+    long offset = appendToTable(RegistrationType, bytes, length);
+    tableHeaderChanged(RegistrationType, count, 0);
+    for (int i = 0; i < count; i++) { indexItemAdded(wrapRegistration(registrations[i]), offset + recordOffsets[i]); }
+    free(bytes); free(recordOffsets);
 }
 
-OptionalItem ItemIterator(ItemType type, OptionalItem(*aimFunction)(Item, Item), Item aimItem) {
-    char *fileName = malloc(sizeof(char)*255);
-    if (fileName == NULL) { printf("Couldn't allocate memory in 'ItemIterator' function.\n"); exit(1); }
-    Item(*decodingFunction)(FILE*) = readInstructorFromFile;
-    prepareForIteration(type, fileName, &decodingFunction);
-    OptionalItem optionalItem; optionalItem.hasValue = false;
-    FILE *file = fopen(fileName, "r");
-    if (file == NULL) { return optionalItem; }
-    while (getc(file) != EOF) {
-        fseek(file, ftell(file)-1, SEEK_SET);
-        Item item = decodingFunction(file);
-        optionalItem = aimFunction(item, aimItem);
-        optionalItem.item.type = type;
-        if (optionalItem.hasValue) {
-            free(fileName); fclose(file); return optionalItem;
+int registerStudentsForCourses(RegistrationBatch batch, int MAX_COUNT, int MAX_CREDIT) {
+    // Assigns the result of every request of 'batch', see above. Returns the number of accepted requests.
+    if (transaction.isOpen && !transaction.isApplying) {
+        for (int i = 0; i < batch.count; i++) {
+            registerStudentForCourse(batch.requests[i].courseCode, batch.requests[i].studentNumber, MAX_COUNT, MAX_CREDIT);
+            batch.requests[i].result = RegistrationIsBuffered;
         }
-        freeItem(item);
+        return 0;
     }
-    free(fileName); fclose(file);
-    return optionalItem;
+    BatchRecords students, courses;
+    initializeBatchRecords(&students, StudentType); initializeBatchRecords(&courses, CourseType);
+    Registration *registrations = malloc((batch.count + 1)*sizeof(Registration));
+    if (registrations == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'registerStudentsForCourses' function.\n"); exit(1); }
+    for (int i = 0; i < batch.count; i++) {
+        addToBatchRecords(&students, wrapStudentWithStudentNumber(batch.requests[i].studentNumber));
+        addToBatchRecords(&courses, wrapCourseWithCode(batch.requests[i].courseCode));
+    }
+    readBatchRecords(&students); readBatchRecords(&courses);
+    KeyTable registeredPairs = { NULL, NULL, 0, 0 };
+    RegisteredPairsContext pairsContext = { &courses, &registeredPairs };
+    visitRegistrationsOfBatchRecords(&students, registeredPairsCollectorVisitor, &pairsContext);
+    char date[DATE_LENGTH]; getDateForRegistration(date);
+    int acceptedCount = 0;
+    for (int i = 0; i < batch.count; i++) {
+        RegistrationRequest *request = &batch.requests[i];
+        int32_t studentPosition = findKey(&students.studentPositions, request->studentNumber);
+        int32_t coursePosition = findCodeID(&courses.coursePositions, request->courseCode);
+        Student *student = &students.updatedVersions[studentPosition].value.student;
+        Course *course = &courses.updatedVersions[coursePosition].value.course;
+        int64_t pair = makeRegisteredPair(request->studentNumber, coursePosition);
+        if (courses.offsets[coursePosition] < 0) { request->result = NoSuchCourse; }
+        else if (students.offsets[studentPosition] < 0) { request->result = NoSuchStudent; }
+        else if (student->numberOfCoursesRegistered >= MAX_COUNT) { request->result = TooManyCourses; }
+        else if (student->numberOfCreditsTaken + course->credit > MAX_CREDIT) { request->result = TooManyCredits; }
+        else if (course->quota.total - course->quota.registered == 0) { request->result = QuotaIsFull; }
+        else if (findKey(&registeredPairs, pair) >= 0) { request->result = AlreadyRegistered; }
+        else {
+            request->result = RegistrationIsAccepted; insertKey(&registeredPairs, pair, 1);
+            student->numberOfCoursesRegistered++; student->numberOfCreditsTaken += course->credit; course->quota.registered++;
+            Registration registration = { -1, student->studentNumber, course->code, true, date };
+            registrations[acceptedCount++] = registration;
+        }
+    }
+    if (acceptedCount > 0) {
+        beginLoggedOperation();
+        appendBatchRegistrations(registrations, acceptedCount);
+        writeCountersOfBatchRecords(&students); writeCountersOfBatchRecords(&courses);
+        commitLoggedOperation();
+        compactTableIfNeeded(StudentType); compactTableIfNeeded(CourseType);
+    }
+    printf("Registered %d of %d requests of the batch.\n", acceptedCount, batch.count);
+    freeBatchRecords(&students); freeBatchRecords(&courses); freeKeyTable(&registeredPairs);
+    free(registrations);
+    return acceptedCount;
+}
+
+// MARK: - INTEGRITY CHECK
+
+/* Counters of students and courses are written after their registrations, so a crash between the writes of a
+ registration or of a cascade, i.e. with '--no-wal', leaves them different from the registrations. 'checkDatabase'
+ reads instructors, courses and students once into hash tables, and joins the registrations with them in one scan of
+ their file with 'ParallelRecordScanner'. Every thread adds the registrations it reads to the shared counters
+ atomically, so registrations are not sorted or grouped, and the counters are compared when all threads are done.
+ Courses without an instructor, active registrations without a course or a student, and counters that are different
+ from the registrations are reported. With 'shouldRepair', counters are rewritten with the values counted from the
+ registrations in one logged operation, orphans are only reported. */
+
+#define MAX_CHECK_THREAD_COUNT 16
+
+typedef struct {
+    BatchRecords courses;
+    BatchRecords students;
+    int32_t *registeredCounts; // Counted registrations of every course, by its position in 'courses'.
+    int32_t *courseCounts; // Counted courses and credits of every student, by its position in 'students'.
+    int64_t *creditCounts;
+} IntegrityCheck;
+
+typedef struct {
+    IntegrityCheck *check;
+    long registrationCount;
+    OffsetList orphanOffsets;
+} CheckPartition;
+
+bool integrityCheckJoinVisitor(Item item, long offset, void *context) {
+    // Adds an active registration to the counters of its course and student, or keeps its offset if one of them is missing.
+    CheckPartition *partition = context; IntegrityCheck *check = partition->check;
+    Registration registration = item.value.registration;
+    partition->registrationCount++;
+    if (!registration.stillRegistered) { return false; }
+    int32_t coursePosition = findCodeID(&check->courses.coursePositions, registration.courseCode);
+    int32_t studentPosition = findKey(&check->students.studentPositions, registration.studentNumber);
+    if (coursePosition < 0 || studentPosition < 0) { offsetCollector(offset, &partition->orphanOffsets); return false; }
+    __atomic_fetch_add(&check->registeredCounts[coursePosition], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&check->courseCounts[studentPosition], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&check->creditCounts[studentPosition], check->courses.items[coursePosition].value.course.credit, __ATOMIC_RELAXED);
+    return false;
+}
+
+bool instructorIDCollectorVisitor(Item item, long offset, void *context) {
+    insertKey(context, item.value.instructor.ID, 1);
+    return false;
+}
+
+void *allocateCheckCounters(int count, size_t width) {
+    void *counters = calloc(count + 1, width);
+    if (counters == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'allocateCheckCounters' function.\n"); exit(1); }
+    return counters;
+}
+
+void checkDatabase(bool shouldRepair) {
+    // Reports orphans and counters that are different from the registrations, and rewrites the counters if 'shouldRepair'.
+    recoverFromLog();
+    IntegrityCheck check; KeyTable instructorIDs = { NULL, NULL, 0, 0 };
+    initializeBatchRecords(&check.courses, CourseType); initializeBatchRecords(&check.students, StudentType);
+    RecordScanner(InstructorType, instructorIDCollectorVisitor, &instructorIDs);
+    RecordScanner(CourseType, foundItemCollectorVisitor, &check.courses);
+    RecordScanner(StudentType, foundItemCollectorVisitor, &check.students);
+    check.registeredCounts = allocateCheckCounters(check.courses.count, sizeof(int32_t));
+    check.courseCounts = allocateCheckCounters(check.students.count, sizeof(int32_t));
+    check.creditCounts = allocateCheckCounters(check.students.count, sizeof(int64_t));
+    long orphanCourseCount = 0, orphanRegistrationCount = 0, registrationCount = 0, mismatchCount = 0;
+    for (int i = 0; i < check.courses.count; i++) {
+        Course course = check.courses.items[i].value.course;
+        if (findKey(&instructorIDs, course.instructorID) < 0) {
+            printf("Course '%s' has no instructor with the ID: %d.\n", course.code, course.instructorID); orphanCourseCount++;
+        }
+    }
+    CheckPartition partitions[MAX_CHECK_THREAD_COUNT]; void *contexts[MAX_CHECK_THREAD_COUNT];
+    for (int i = 0; i < MAX_CHECK_THREAD_COUNT; i++) {
+        CheckPartition partition = { &check, 0, { NULL, 0, 0 } }; partitions[i] = partition; contexts[i] = &partitions[i];
+    }
+    int partitionCount = ParallelRecordScanner(RegistrationType, integrityCheckJoinVisitor, contexts, MAX_CHECK_THREAD_COUNT);
+    // Partitions are in the order of their records, so orphans are reported in the order of their records.
+    for (int i = 0; i < partitionCount; i++) {
+        for (int j = 0; j < partitions[i].orphanOffsets.count; j++) {
+            Item item;
+            if (!readItemAtOffset(RegistrationType, partitions[i].orphanOffsets.offsets[j], &item)) { continue; }
+            Registration registration = item.value.registration;
+            const char *missing = (findCodeID(&check.courses.coursePositions, registration.courseCode) < 0) ? "course" : "student";
+            printf("Registration with ID %d of student %d for course '%s' has no %s.\n", registration.ID, registration.studentNumber, registration.courseCode, missing);
+            freeItem(item);
+        }
+        registrationCount += partitions[i].registrationCount; orphanRegistrationCount += partitions[i].orphanOffsets.count;
+        free(partitions[i].orphanOffsets.offsets);
+    }
+    for (int i = 0; i < check.courses.count; i++) {
+        Course *course = &check.courses.updatedVersions[i].value.course;
+        if (course->quota.registered == check.registeredCounts[i]) { continue; }
+        printf("Course '%s' has %d registered students, its registrations have %d.\n", course->code, course->quota.registered, check.registeredCounts[i]);
+        course->quota.registered = check.registeredCounts[i]; mismatchCount++;
+    }
+    for (int i = 0; i < check.students.count; i++) {
+        Student *student = &check.students.updatedVersions[i].value.student;
+        if (student->numberOfCoursesRegistered == check.courseCounts[i] && student->numberOfCreditsTaken == check.creditCounts[i]) { continue; }
+        printf("Student %d has %d courses and %d credits, its registrations have %d courses and %lld credits.\n", student->studentNumber,
+               student->numberOfCoursesRegistered, student->numberOfCreditsTaken, check.courseCounts[i], (long long)check.creditCounts[i]);
+        student->numberOfCoursesRegistered = check.courseCounts[i]; student->numberOfCreditsTaken = (int)check.creditCounts[i]; mismatchCount++;
+    }
+    printf("Checked %d instructors, %d courses, %d students and %ld registrations: %ld courses without instructor, %ld registrations without course or student, %ld different counters.\n",
+           instructorIDs.count, check.courses.count, check.students.count, registrationCount, orphanCourseCount, orphanRegistrationCount, mismatchCount);
+    if (shouldRepair && mismatchCount > 0) {
+        beginLoggedOperation();
+        writeCountersOfBatchRecords(&check.courses); writeCountersOfBatchRecords(&check.students);
+        commitLoggedOperation();
+        compactTableIfNeeded(CourseType); compactTableIfNeeded(StudentType);
+        printf("Rewrote %ld counters.\n", mismatchCount);
+    }
+    free(check.registeredCounts); free(check.courseCounts); free(check.creditCounts);
+    freeBatchRecords(&check.courses); freeBatchRecords(&check.students); freeKeyTable(&instructorIDs);
 }
 
 // MARK: - ITEM QUERY && GETTING ITEM FROM DATABASE && ITERATIVE REMOVALS && ITERATIVE UPDATES
 
+OptionalItem findItemInDatabase(Item item) {
+    // Uses the primary index if it can be used for 'item', or the columns of registrations, otherwise scans the file with 'ItemIterator'.
+    OptionalItem optionalItem; long offset = -1;
+    if (findItemWithIndex(item, &optionalItem, &offset)) { return optionalItem; }
+    if (findRegistrationWithColumns(item, &optionalItem, &offset)) { return optionalItem; }
+    return ItemIterator(item.type, query, item);
+}
+
+typedef struct {
+    Item queriedItem;
+    long offset;
+} OffsetSearchContext;
+
+bool offsetSearchVisitor(Item item, long offset, void *context) {
+    OffsetSearchContext *searchContext = context;
+    bool found = conditionForQuery(item, searchContext->queriedItem);
+    if (found) { searchContext->offset = offset; }
+    return found;
+}
+
+bool findOffsetOfItemInDatabase(Item item, long *offset) {
+    // Assigns the offset of the record of 'item' to 'offset', uses the index if it can, otherwise scans the file.
+    if (findOffsetOfItem(item, offset)) { return true; }
+    OptionalItem optionalItem;
+    if (findRegistrationWithColumns(item, &optionalItem, offset)) {
+        if (optionalItem.hasValue) { freeItem(optionalItem.item); }
+        return optionalItem.hasValue;
+    }
+    OffsetSearchContext context; context.queriedItem = item; context.offset = -1;
+    RecordScanner(item.type, offsetSearchVisitor, &context);
+    *offset = context.offset;
+    return context.offset >= 0;
+}
+
 bool itemIsInDatabase(Item item) {
     /* Returns whether an 'item' is in database or not. If ItemIterator returns an 'OptionalItem'
      that has its 'hasValue' bool set to true, then item is in database, otherwise it's not. */
-    OptionalItem optionalItem = ItemIterator(item.type, query, item);
+    OptionalItem optionalItem = findItemInDatabase(item);
     if (optionalItem.hasValue) { freeItem(optionalItem.item); }
     return optionalItem.hasValue;
 }
@@ -827,7 +5308,7 @@ Item getItem(Item item) {
      value but no other values, and returns the real instance, i.e. the instance that has all values,
      not only unique key value, if it is in database. If instance with unique key is not in database,
      then artificial instance itself will be returned. */
-    OptionalItem optionalItem = ItemIterator(item.type, query, item);
+    OptionalItem optionalItem = findItemInDatabase(item);
     if (!optionalItem.hasValue) { return item; }
     return optionalItem.item;
 }
@@ -866,136 +5347,335 @@ OptionalItem query(Item decodedItem, Item queriedItem) {
 
 // MARK: Remove registrations after student or course removal
 
-bool conditionForRemoval(Item registration, Item courseOrStudent) {
-    // Helper function for indicating whether registration record's course code or student number matched with the value contained in 'courseOrStudent' parameter
-    if (courseOrStudent.type == CourseType) { return strcmp(registration.value.registration.courseCode, courseOrStudent.value.course.code) == 0; }
-    else { return registration.value.registration.studentNumber == courseOrStudent.value.student.studentNumber; }
-}
+/* Registrations of removed students or courses are collected with one pass over the active registrations, see
+ 'visitRegistrationsOfBatchRecords', and they are invalidated in one logged operation. Counters of the courses or
+ students of the registrations are summed in memory first, so every counter record is written once, however many
+ registrations of it are invalidated. */
 
-OptionalItem registrationCourseOrStudentRemoval(Item registration, Item courseOrStudent) {
-    // If conditionForRemoval is met, and registration is an active registration, then return that registration item in OptionalItem.
-    // This will be the 'aimFunction' for 'ItemIterator' function, for invalidating all registrations associated with 'courseOrStudent'.
-    OptionalItem optionalItem; optionalItem.hasValue = false;
-    if (conditionForRemoval(registration, courseOrStudent)) {
-        if (registration.value.registration.stillRegistered) {
-            optionalItem.hasValue = true; optionalItem.item = registration;
-        }
+typedef struct {
+    Item *items;
+    long *offsets;
+    int count;
+    int capacity;
+    Arena arena; // Strings of the collected registrations.
+} CollectedRegistrations;
+
+bool registrationCollectorVisitor(Item item, long offset, void *context) {
+    CollectedRegistrations *collected = context;
+    if (collected->count == collected->capacity) {
+        collected->capacity = (collected->capacity == 0) ? 16 : 2*collected->capacity;
+        collected->items = realloc(collected->items, collected->capacity*sizeof(Item));
+        collected->offsets = realloc(collected->offsets, collected->capacity*sizeof(long));
+        if (collected->items == NULL || collected->offsets == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'registrationCollectorVisitor' function.\n"); exit(1); }
     }
-    return optionalItem;
+    Registration registration = item.value.registration;
+    registration.courseCode = strcpy(allocateFromArena(&collected->arena, strlen(registration.courseCode) + 1), registration.courseCode);
+    registration.date = strcpy(allocateFromArena(&collected->arena, strlen(registration.date) + 1), registration.date);
+    collected->items[collected->count] = wrapRegistration(registration); collected->offsets[collected->count++] = offset;
+    return false;
 }
 
-void invalidateRegistrationsAfterCourseOrStudentRemoval(Item courseOrStudent, int credit) {
-    // Iterate over the Registrations file, if matching record found, then remove record.
-    int count = getRecordCountOfAFile(RegistrationType);
-    for (int i = 0; i < count; i++) {
-        OptionalItem opt = ItemIterator(RegistrationType, registrationCourseOrStudentRemoval, courseOrStudent);
-        if (opt.hasValue) {
-            Item course = getItem(wrapCourseWithCode(opt.item.value.registration.courseCode));
-            credit = (credit < 0) ? course.value.course.credit : credit;
-            removeItemAsAPartOfUpdateProcess(wrapRegistrationsWithID(opt.item.value.registration.ID));
-            if (courseOrStudent.type == CourseType) {
-                updateStudentsCreditStatus(opt.item.value.registration.studentNumber, false, credit, true);
-            } else {
-                updateCourseQuota(opt.item.value.registration.courseCode, false); freeItem(course);
-            }
-            freeItem(opt.item);
+void invalidateRegistrationsOfRemovedRecords(BatchRecords *removed) {
+    /* Invalidates the active registrations of the removed students or courses in 'removed', and takes them out of the
+     counters of their courses or students. Credits of a course are taken from its item in 'removed'. */
+    CollectedRegistrations collected = { NULL, NULL, 0, 0, EMPTY_ARENA };
+    visitRegistrationsOfBatchRecords(removed, registrationCollectorVisitor, &collected);
+    BatchRecords affected;
+    initializeBatchRecords(&affected, (removed->type == CourseType) ? StudentType : CourseType);
+    for (int i = 0; i < collected.count; i++) {
+        Registration registration = collected.items[i].value.registration;
+        addToBatchRecords(&affected, (affected.type == StudentType) ? wrapStudentWithStudentNumber(registration.studentNumber) : wrapCourseWithCode(registration.courseCode));
+    }
+    readBatchRecords(&affected);
+    for (int i = 0; i < collected.count; i++) {
+        Registration registration = collected.items[i].value.registration;
+        if (affected.type == StudentType) {
+            Student *student = &affected.updatedVersions[findKey(&affected.studentPositions, registration.studentNumber)].value.student;
+            student->numberOfCoursesRegistered--;
+            student->numberOfCreditsTaken -= removed->items[findCodeID(&removed->coursePositions, registration.courseCode)].value.course.credit;
+        } else {
+            affected.updatedVersions[findCodeID(&affected.coursePositions, registration.courseCode)].value.course.quota.registered--;
         }
     }
+    beginLoggedOperation();
+    for (int i = 0; i < collected.count; i++) { invalidateRegistrationAtOffset(collected.items[i], collected.offsets[i]); }
+    writeCountersOfBatchRecords(&affected);
+    commitLoggedOperation();
+    compactTableIfNeeded(affected.type);
+    freeBatchRecords(&affected);
+    free(collected.items); free(collected.offsets); releaseArena(&collected.arena);
+}
+
+void invalidateRegistrationsAfterCourseOrStudentRemoval(Item courseOrStudent) {
+    // Invalidates the active registrations of the removed 'courseOrStudent', which should have all of its values.
+    BatchRecords removed;
+    initializeBatchRecords(&removed, courseOrStudent.type);
+    addToBatchRecords(&removed, courseOrStudent); // Item isn't copied, since it isn't marked as found.
+    invalidateRegistrationsOfRemovedRecords(&removed);
+    freeBatchRecords(&removed);
 }
 
 // MARK: Remove courses given by instructor with ID
 
-OptionalItem courseInstructorRemoval(Item courseItem, Item instructor) {
-    // If instructorID's matched, then return that course item in an OptionalItem.
-    // This will be the 'aimFunction' for 'ItemIterator' function, for removaing all courses given by 'instructor'.
-    OptionalItem optionalItem; optionalItem.hasValue = false;
-    if (courseItem.value.course.instructorID == instructor.value.instructor.ID) {
-        optionalItem.hasValue = true; optionalItem.item = courseItem;
-    }
-    return optionalItem;
+void collectCoursesGivenByInstructor(Item instructor, BatchRecords *courses) {
+    // Courses are found with the instructor index of courses, or with one scan of the file if indexes are disabled, see 'PredicateScanner'.
+    Predicate isGivenByInstructor = fieldComparedToNumber("instructorID", IsEqualTo, instructor.value.instructor.ID);
+    initializeBatchRecords(courses, CourseType);
+    PredicateScanner(CourseType, &isGivenByInstructor, foundItemCollectorVisitor, courses);
 }
 
 void removeCoursesGivenByInstructor(Item instructorItem) {
-    // Iterate over the Courses file, if record's instructor ID is matched with instructor's ID, then first invalidate registrations associated with that course, and finally remove course from database.
-    int count = getRecordCountOfAFile(InstructorType);
-    for (int i = 0; i < count; i++) {
-        OptionalItem opt = ItemIterator(CourseType, courseInstructorRemoval, instructorItem);
-        if (opt.hasValue) {
-            invalidateRegistrationsAfterCourseOrStudentRemoval(opt.item, -1);
-            removeItemAsAPartOfUpdateProcess(opt.item);
-            freeItem(opt.item);
-        }
+    /* Collects the courses given by instructor. Then registrations of all of the courses are invalidated together, and
+     the courses are removed, in one logged operation. */
+    BatchRecords courses;
+    collectCoursesGivenByInstructor(instructorItem, &courses);
+    if (courses.count > 0) {
+        beginLoggedOperation();
+        invalidateRegistrationsOfRemovedRecords(&courses);
+        for (int i = 0; i < courses.count; i++) { removeRecordAtOffset(courses.items[i], courses.offsets[i]); }
+        commitLoggedOperation();
+        compactTableIfNeeded(CourseType); compactTableIfNeeded(StudentType);
     }
+    freeBatchRecords(&courses);
 }
 
 // MARK: Update registrations after student or course unique identifier change
 
+/* Active registrations of a course or a student whose key has changed are changed to the new key where they are, so
+ they keep their IDs and dates. They are found with one pass over the active registrations of the old key, see
+ 'visitRegistrationsOfBatchRecords'. In binary format a student number is a fixed width field, so it is overwritten in
+ place in one logged operation, and registrations refer to a course with its ID, which is kept by the updated course,
+ so when the code of a course changes only the columns of registrations are changed, see 'COURSE CODE DICTIONARY'.
+ In text format the new key line may be longer or shorter than the old one, so the registrations file is rewritten
+ in one pass like 'compactTable' does, with the key line of every found registration replaced. Records after a renamed
+ one only move, so offsets in the indexes are shifted, see 'Shifting offsets of resized records', and only the entries
+ of the renamed registrations are moved to the new key. Rewritten file and indexes replace the old ones in the same
+ logged operation as the renamed course or student, see 'updateItemBase'. */
+
+#define REGISTRATION_RECORD_LINE_COUNT 6
+
+bool rewriteKeyLinesOfTextRegistrations(long *offsets, int count, int keyLine, const char *newKeyLine) {
+    /* Copies the registrations file to a new file, replaces line 'keyLine' of the records at 'offsets' with 'newKeyLine',
+     and shifts the offsets in the indexes of the new file. 'offsets' are changed to the offsets of the records in the new
+     file. Returns false if the file couldn't be rewritten.
+     The new file and its indexes are written as the copies of a transaction, and their replacement is a write of the open
+     logged operation, so they replace the files together with the other writes of the operation, i.e. the renamed course.
+     If program stops before the operation is logged, copies are removed by 'recoverFromLog', and if it stops after, they
+     are renamed again, so indexes never point into records of the other file. While a transaction is applied, the file
+     is already a copy, so it is rewritten where it is and replaced when the transaction is committed. */
+    char fileName[255], rewrittenFileName[255]; char indexNames[INDEX_COUNT_LIMIT][255], indexCopyNames[INDEX_COUNT_LIMIT][255];
+    prepareTableForChange(RegistrationType); // Offsets of stale indexes can't be shifted.
+    checkpointLog(); // Offsets in the log would be wrong for the rewritten file.
+    bool isReplacedOnCommit = !tableIsCopiedForTransaction[databaseFormat][RegistrationType];
+    TableCounts counts = getTableCounts(RegistrationType);
+    getFileNameForType(RegistrationType, fileName);
+    int indexCount = getIndexFileNamesOfType(RegistrationType, databaseFormat, indexNames);
+    if (isReplacedOnCommit) {
+        closeIndexesOfType(RegistrationType);
+        tableIsCopiedForTransaction[databaseFormat][RegistrationType] = true;
+        getFileNameForType(RegistrationType, rewrittenFileName);
+        getIndexFileNamesOfType(RegistrationType, databaseFormat, indexCopyNames);
+    } else {
+        strcpy(rewrittenFileName, "tmp.txt");
+    }
+    FILE *file = fopen(fileName, "rb");
+    FILE *tmp = (file != NULL) ? fopen(rewrittenFileName, "wb") : NULL;
+    if (tmp == NULL) {
+        if (file != NULL) { printf("ERROR: Couldn't open '%s' at 'rewriteKeyLinesOfTextRegistrations' function.\n", rewrittenFileName); fclose(file); }
+        if (isReplacedOnCommit) { tableIsCopiedForTransaction[databaseFormat][RegistrationType] = false; }
+        return false;
+    }
+    long *shifts = malloc(sizeof(long)*count);
+    if (shifts == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'rewriteKeyLinesOfTextRegistrations' function.\n"); exit(1); }
+    char *line = NULL; size_t capacity = 0; ssize_t length; long offset = 0, shift = 0; int next = 0; bool isRenamed = false;
+    for (long lineNumber = 0; (length = getline(&line, &capacity, file)) != -1; lineNumber++) {
+        if (lineNumber % REGISTRATION_RECORD_LINE_COUNT == 0) {
+            isRenamed = next < count && offsets[next] == offset;
+            if (isRenamed) { shifts[next++] = shift; }
+        }
+        if (isRenamed && lineNumber % REGISTRATION_RECORD_LINE_COUNT == keyLine) {
+            fputs(newKeyLine, tmp);
+            shift += (long)strlen(newKeyLine) - length; shifts[next-1] = shift;
+        } else {
+            fputs(line, tmp);
+        }
+        offset += length;
+    }
+    free(line);
+    fclose(file); fclose(tmp);
+    if (isReplacedOnCommit) {
+        for (int i = 0; i < indexCount && indexedLookups; i++) { copyFile(indexNames[i], indexCopyNames[i]); }
+        adoptIndexesOfType(RegistrationType);
+    } else {
+        rename(rewrittenFileName, fileName);
+    }
+    tableFileChanged(databaseFormat, RegistrationType);
+    TableHeader *tableHeader = &tableHeaders[databaseFormat][RegistrationType];
+    tableHeader->counts = counts; tableHeader->isLoaded = true;
+    stampTableHeader(RegistrationType);
+    OffsetShift offsetShift = { offsets, shifts, next };
+    shiftIndexesOfType(RegistrationType, &offsetShift);
+    for (int i = next - 1; i > 0; i--) { offsets[i] += shifts[i-1]; } // A renamed record is moved by the ones before it.
+    free(shifts);
+    if (isReplacedOnCommit) {
+        beginLoggedOperation();
+        addLoggedWrite(&currentOperation, databaseFormat, RegistrationType, -1, NULL, 0); // Applied by 'replaceTableWithTransactionCopy'.
+        commitLoggedOperation();
+    }
+    return true;
+}
+
 void updateRegistrationsAfterCourseOrStudentsUniqueKeyHasChanged(Item courseOrStudentToRemove, Item updatedVersion) {
-    // Iterate over the Registrations file, if it is a matching record then update record.
-    int count = getRecordCountOfAFile(RegistrationType);
-    for (int i = 0; i < count; i++) {
-        OptionalItem opt = ItemIterator(RegistrationType, registrationCourseOrStudentRemoval, courseOrStudentToRemove);
-        if (opt.hasValue) {
-            removeItemAsAPartOfUpdateProcess(wrapRegistrationsWithID(opt.item.value.registration.ID));
-            /* Since we already removed registration (temporarily), and know that no credit information changed,
-             we can register student without caring about the actual number of courses limit or credit limit.
-             That's why 'registerStudentForCourse' function called with value 1000, it's a lot bigger than any realizable limit,
-             and won't prevent the registration of student for course. */
-            if (courseOrStudentToRemove.type == CourseType) {
-                registerStudentForCourseAsAPartOfUpdateProcess(updatedVersion.value.course.code, opt.item.value.registration.studentNumber, 1000, 1000);
-            } else {
-                registerStudentForCourseAsAPartOfUpdateProcess(opt.item.value.registration.courseCode, updatedVersion.value.student.studentNumber, 1000, 1000);
+    // Changes the key of the active registrations of 'courseOrStudentToRemove' to the key of 'updatedVersion', see above.
+    if (courseOrStudentToRemove.type == CourseType && databaseFormat == BinaryFormat) {
+        renameCourseInRegistrationColumns(courseOrStudentToRemove.value.course.code, updatedVersion.value.course.code); return;
+    }
+    BatchRecords renamed;
+    initializeBatchRecords(&renamed, courseOrStudentToRemove.type);
+    addToBatchRecords(&renamed, courseOrStudentToRemove);
+    CollectedRegistrations collected = { NULL, NULL, 0, 0, EMPTY_ARENA };
+    visitRegistrationsOfBatchRecords(&renamed, registrationCollectorVisitor, &collected);
+    if (collected.count > 0 && databaseFormat == BinaryFormat) {
+        int32_t studentNumber = updatedVersion.value.student.studentNumber;
+        int fieldOffset = getBinaryFieldOffset(RegistrationType, "studentNumber");
+        beginLoggedOperation();
+        prepareTableForChange(RegistrationType);
+        for (int i = 0; i < collected.count; i++) {
+            Item renamedRegistration = collected.items[i];
+            renamedRegistration.value.registration.studentNumber = studentNumber;
+            writeToTable(RegistrationType, collected.offsets[i] + fieldOffset, &studentNumber, sizeof(int32_t));
+            indexItemChanged(collected.items[i], renamedRegistration, collected.offsets[i]);
+        }
+        commitLoggedOperation();
+    } else if (collected.count > 0) {
+        char newKeyLine[255]; bool isCourse = courseOrStudentToRemove.type == CourseType;
+        if (isCourse) { sprintf(newKeyLine, "Course code: %s\n", updatedVersion.value.course.code); }
+        else { sprintf(newKeyLine, "Student number: %d\n", updatedVersion.value.student.studentNumber); }
+        beginLoggedOperation(); // Entries are moved on the copies of the indexes, before they replace the files.
+        if (rewriteKeyLinesOfTextRegistrations(collected.offsets, collected.count, (isCourse) ? 1 : 2, newKeyLine)) {
+            for (int i = 0; i < collected.count; i++) {
+                Item renamedRegistration = collected.items[i];
+                if (isCourse) { renamedRegistration.value.registration.courseCode = updatedVersion.value.course.code; }
+                else { renamedRegistration.value.registration.studentNumber = updatedVersion.value.student.studentNumber; }
+                indexItemChanged(collected.items[i], renamedRegistration, collected.offsets[i]);
             }
-            freeItem(opt.item);
         }
+        commitLoggedOperation();
     }
+    freeBatchRecords(&renamed);
+    free(collected.items); free(collected.offsets); releaseArena(&collected.arena);
 }
 
 // MARK: Update courses given by specific instructor after instructor's ID has changed
 
 void updateCoursesAfterInstructorIDChange(Item instructorItem, Item updatedInstructor) {
-    // Iterate over the Courses file, if record's 'instructorID' is matched with instructor's 'ID', then update course item.
-    int count = getRecordCountOfAFile(InstructorType);
-    for (int i = 0; i < count; i++) {
-        OptionalItem opt = ItemIterator(CourseType, courseInstructorRemoval, instructorItem);
-        if (opt.hasValue) {
-            Item updatedCourse = opt.item;
-            updatedCourse.value.course.instructorID = updatedInstructor.value.instructor.ID;
-            updateItemSilently(opt.item, updatedCourse);
-            freeItem(opt.item);
-        }
+    // Collect the courses given by instructor, and update 'instructorID' of each course item.
+    BatchRecords courses;
+    collectCoursesGivenByInstructor(instructorItem, &courses);
+    for (int i = 0; i < courses.count; i++) {
+        Item updatedCourse = courses.items[i];
+        updatedCourse.value.course.instructorID = updatedInstructor.value.instructor.ID;
+        updateItemSilently(courses.items[i], updatedCourse);
     }
+    freeBatchRecords(&courses);
 }
 
 // MARK: Update student's credit status if course's credit has changed
 
-OptionalItem updateStudentCredit(Item registration, Item course) {
-    // This will be the 'aimFunction' for 'ItemIterator' function, updating every student's credit info, that is registered for the 'course'.
-    OptionalItem optionalItem; optionalItem.hasValue = false;
-    if (registration.value.registration.stillRegistered &&
-        strcmp(registration.value.registration.courseCode, course.value.course.code) == 0) {
-        int creditDifference = course.value.course.credit;
-        bool creditIncremented = creditDifference > 0;
-        updateStudentsCreditStatus(registration.value.registration.studentNumber, creditIncremented, abs(creditDifference), false);
-    }
-    return optionalItem;
+/* Students of the active registrations of the course are collected with one pass over its registrations, see
+ 'visitRegistrationsOfBatchRecords', then they are read together and the credit difference is written to each of them
+ once, in one logged operation. '--no-batching' makes program update students one registration at a time instead,
+ with 'studentCreditUpdaterVisitor' and 'PredicateScanner'. */
+
+bool batchedCreditPropagation = true;
+
+bool studentCreditUpdaterVisitor(Item registration, long offset, void *context) {
+    // Updates the credits of the student of every registration of the course, with the credit difference in 'context'.
+    int creditDifference = *(int*)context;
+    updateStudentsCreditStatus(registration.value.registration.studentNumber, creditDifference > 0, abs(creditDifference), false);
+    return false;
+}
+
+bool creditDifferenceCollectorVisitor(Item item, long offset, void *context) {
+    // Adds the student of the registration, and counts its registration in 'numberOfCoursesRegistered' of the artificial student.
+    BatchRecords *students = context;
+    int32_t position = addToBatchRecords(students, wrapStudentWithStudentNumber(item.value.registration.studentNumber));
+    students->items[position].value.student.numberOfCoursesRegistered++;
+    return false;
 }
 
 void updateStudentsCreditIfCoursesCreditHasChanged(int creditDifference, Item course) {
-    // Iterate over the Courses file, if record's 'instructorID' is matched with instructor's 'ID', then update course item.
-    Course trickyCourse = { course.value.course.code, "", creditDifference };
-    ItemIterator(RegistrationType, updateStudentCredit, wrapCourse(trickyCourse));
+    // Adds 'creditDifference' to the credits of every student, that is registered for the 'course'.
+    if (creditDifference == 0) { return; }
+    if (!batchedCreditPropagation) {
+        Predicate isOfCourse = fieldComparedToText("courseCode", IsEqualTo, course.value.course.code);
+        Predicate isActive = fieldComparedToNumber("stillRegistered", IsEqualTo, 1);
+        Predicate isActiveRegistrationOfCourse = bothOfPredicates(&isOfCourse, &isActive);
+        PredicateScanner(RegistrationType, &isActiveRegistrationOfCourse, studentCreditUpdaterVisitor, &creditDifference);
+        return;
+    }
+    BatchRecords courses, students;
+    initializeBatchRecords(&courses, CourseType); initializeBatchRecords(&students, StudentType);
+    addToBatchRecords(&courses, course);
+    visitRegistrationsOfBatchRecords(&courses, creditDifferenceCollectorVisitor, &students);
+    int *registrationCounts = malloc((students.count + 1)*sizeof(int));
+    if (registrationCounts == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'updateStudentsCreditIfCoursesCreditHasChanged' function.\n"); exit(1); }
+    for (int i = 0; i < students.count; i++) { registrationCounts[i] = students.items[i].value.student.numberOfCoursesRegistered; }
+    readBatchRecords(&students);
+    for (int i = 0; i < students.count; i++) { students.updatedVersions[i].value.student.numberOfCreditsTaken += registrationCounts[i]*creditDifference; }
+    beginLoggedOperation();
+    writeCountersOfBatchRecords(&students);
+    commitLoggedOperation();
+    compactTableIfNeeded(StudentType);
+    free(registrationCounts); freeBatchRecords(&students);
+    freeBatchRecords(&courses);
 }
 
 // MARK: - LISTING FUNCTIONS
 
+// MARK: Joining registrations with their courses or students
+
+/* Listing the registrations of a course or a student with their students or courses used to call 'getItem' for every
+ registration, which scans the whole file of the other side when indexes are disabled. 'RegistrationJoinIterator'
+ is a hash join instead: active registrations are collected once, then the side with fewer rows is put into a hash
+ table, see 'BatchRecords', and the other side is streamed once and probed against it. If the registrations are
+ fewer than the records of the other file, their student numbers or course codes are the table, and the file is
+ scanned until all of them are found, see 'readBatchRecords'. Otherwise every record of the file is put into the table,
+ and the registrations are probed against it. With indexes, student numbers or course codes are looked up instead.
+ Pairs are visited in the order of the registrations, a registration whose student or course is missing is skipped. */
+
+void RegistrationJoinIterator(Item courseOrStudent, void(*visitor)(Registration, Item, void*), void *context) {
+    // Visits every active registration of 'courseOrStudent' with its student if it is a course, or with its course if it is a student.
+    BatchRecords outer, joined; CollectedRegistrations collected = { NULL, NULL, 0, 0, EMPTY_ARENA };
+    initializeBatchRecords(&outer, courseOrStudent.type);
+    initializeBatchRecords(&joined, (courseOrStudent.type == CourseType) ? StudentType : CourseType);
+    addToBatchRecords(&outer, courseOrStudent); // Item isn't copied, since it isn't marked as found.
+    visitRegistrationsOfBatchRecords(&outer, registrationCollectorVisitor, &collected);
+    Item *keys = malloc((collected.count + 1)*sizeof(Item));
+    if (keys == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'RegistrationJoinIterator' function.\n"); exit(1); }
+    for (int i = 0; i < collected.count; i++) {
+        Registration registration = collected.items[i].value.registration;
+        keys[i] = (joined.type == StudentType) ? wrapStudentWithStudentNumber(registration.studentNumber) : wrapCourseWithCode(registration.courseCode);
+    }
+    if (!indexedLookups && collected.count > getRecordCountOfAFile(joined.type)) {
+        RecordScanner(joined.type, foundItemCollectorVisitor, &joined);
+    } else {
+        for (int i = 0; i < collected.count; i++) { addToBatchRecords(&joined, keys[i]); }
+        readBatchRecords(&joined);
+    }
+    for (int i = 0; i < collected.count; i++) {
+        int32_t position = positionInBatchRecords(&joined, keys[i]);
+        if (position >= 0 && joined.offsets[position] >= 0) { visitor(collected.items[i].value.registration, joined.items[position], context); }
+    }
+    free(keys); freeBatchRecords(&outer); freeBatchRecords(&joined);
+    free(collected.items); free(collected.offsets); releaseArena(&collected.arena);
+}
+
 // MARK: List courses given by instructor with ID
 
-OptionalItem courseInstructor(Item course, Item instructor) {
-    // This will be the 'aimFunction' for 'ItemIterator' function, for listing all courses given by 'instructor'.
-    OptionalItem optionalItem; optionalItem.hasValue = false;
-    if (course.value.course.instructorID == instructor.value.instructor.ID) { printItem(course); }
-    return optionalItem;
+bool itemPrinterVisitor(Item item, long offset, void *context) {
+    printItem(item);
+    return false;
 }
 
 void listCoursesGivenByInstructor(Item instructor) {
@@ -1003,20 +5683,15 @@ void listCoursesGivenByInstructor(Item instructor) {
     Instructor instructorRecord = getItem(instructor).value.instructor;
     printf("\nHere is all the courses given by instructor %s %s %s:\n\n", instructorRecord.title, instructorRecord.name, instructorRecord.surname);
     freeItem(wrapInstructor(instructorRecord));
-    ItemIterator(CourseType, courseInstructor, instructor);
+    Predicate isGivenByInstructor = fieldComparedToNumber("instructorID", IsEqualTo, instructor.value.instructor.ID);
+    PredicateScanner(CourseType, &isGivenByInstructor, itemPrinterVisitor, NULL);
 }
 
 // MARK: List courses registered by student
 
-OptionalItem registrationStudent(Item registration, Item student) {
-    // This will be the 'aimFunction' for 'ItemIterator' function, for listing every course that 'student' is registered for.
-    OptionalItem optionalItem; optionalItem.hasValue = false;
-    if (registration.value.registration.stillRegistered &&
-        registration.value.registration.studentNumber == student.value.student.studentNumber) {
-        Item course = getItem(wrapCourseWithCode(registration.value.registration.courseCode));
-        printItem(course); freeItem(course);
-    }
-    return optionalItem;
+void registrationStudent(Registration registration, Item course, void *context) {
+    // This will be the 'visitor' for 'RegistrationJoinIterator' function, for listing every course that a student is registered for.
+    printItem(course);
 }
 
 void listCoursesRegisteredByStudent(Item student) {
@@ -1024,20 +5699,14 @@ void listCoursesRegisteredByStudent(Item student) {
     Student studentRecord = getItem(student).value.student;
     printf("\nHere is the list of all of the courses that '%s %s' is registered for: \n\n", studentRecord.name, studentRecord.surname);
     freeItem(wrapStudent(studentRecord));
-    ItemIterator(RegistrationType, registrationStudent, student);
+    RegistrationJoinIterator(student, registrationStudent, NULL);
 }
 
 // MARK: List students registered for course
 
-OptionalItem registrationCourse(Item registration, Item course) {
-    // This will be the 'aimFunction' for 'ItemIterator' function, for listing every student that is registered for 'course'.
-    OptionalItem optionalItem; optionalItem.hasValue = false;
-    if (registration.value.registration.stillRegistered &&
-        strcmp(registration.value.registration.courseCode, course.value.course.code) == 0) {
-        Item student = getItem(wrapStudentWithStudentNumber((registration.value.registration.studentNumber)));
-        printItem(student); freeItem(student);
-    }
-    return optionalItem;
+void registrationCourse(Registration registration, Item student, void *context) {
+    // This will be the 'visitor' for 'RegistrationJoinIterator' function, for listing every student that is registered for a course.
+    printItem(student);
 }
 
 void listStudentsRegisteredForCourse(Item course) {
@@ -1045,25 +5714,28 @@ void listStudentsRegisteredForCourse(Item course) {
     Course courseRecord = getItem(course).value.course;
     printf("\nHere is the list of all the students that is registered for the course %s %s: \n\n", courseRecord.code, courseRecord.name);
     freeItem(wrapCourse(courseRecord));
-    ItemIterator(RegistrationType, registrationCourse, course);
+    RegistrationJoinIterator(course, registrationCourse, NULL);
 }
 
-// MARK: Print course's students list to a file.
+// MARK: List students in a range of student numbers
 
-OptionalItem registrationCourseEncode(Item registration, Item courseItem) {
-    // This will be the 'aimFunction' for 'ItemIterator' function, for printing student list of a given class.
+OptionalItem studentInRange(Item student, Item lowestStudent) {
+    // This will be the 'aimFunction' for 'StudentsInRangeIterator' function, for listing every student in a range of student numbers.
     OptionalItem optionalItem; optionalItem.hasValue = false;
-    char *fileName = malloc(sizeof(char)*255);
-    if (fileName == NULL) { printf("Couldn't allocate memory in 'registrationCourseEncode' function.\n"); exit(1); }
-    sprintf(fileName, "%s_STUDENTSLIST.txt", courseItem.value.course.code);
-    FILE *studentList = fopen(fileName, "a");
-    if (studentList == NULL) { free(fileName); return optionalItem; }
-    if (registration.value.registration.stillRegistered &&
-        strcmp(registration.value.registration.courseCode, courseItem.value.course.code) == 0) {
-        Student student = getItem(wrapStudentWithStudentNumber((registration.value.registration.studentNumber))).value.student;
-        fprintf(studentList, "- %s %s\n", student.name, student.surname); freeItem(wrapStudent(student));
-    }
-    fclose(studentList); free(fileName); return optionalItem;
+    printItem(student);
+    return optionalItem;
+}
+
+void listStudentsInStudentNumberRange(int lowestStudentNumber, int highestStudentNumber) {
+    printf("\nHere is the list of all the students with student numbers from %d to %d: \n\n", lowestStudentNumber, highestStudentNumber);
+    StudentsInRangeIterator(lowestStudentNumber, highestStudentNumber, studentInRange, wrapStudentWithStudentNumber(lowestStudentNumber));
+}
+
+// MARK: Print course's students list to a file.
+
+void registrationCourseEncode(Registration registration, Item student, void *studentList) {
+    // This will be the 'visitor' for 'RegistrationJoinIterator' function, for printing student list of a given class.
+    fprintf(studentList, "- %s %s\n", student.value.student.name, student.value.student.surname);
 }
 
 void printStudentListOfACourseToAFile(Item courseItem) {
@@ -1071,23 +5743,691 @@ void printStudentListOfACourseToAFile(Item courseItem) {
     char *fileName = malloc(sizeof(char)*255);
     if (fileName == NULL) { printf("Couldn't allocate memory in 'printStudentListOfACourseToAFile' function.\n"); exit(1); }
     sprintf(fileName, "%s_STUDENTSLIST.txt", course.code);
-    remove(fileName);
     FILE *studentList = fopen(fileName, "w");
-    if (studentList == NULL) { free(fileName); return; }
-    fprintf(studentList, "%s %s Course Students List\n\n", course.code, course.name); fclose(studentList);
-    ItemIterator(RegistrationType, registrationCourseEncode, courseItem);
+    if (studentList == NULL) { free(fileName); freeItem(wrapCourse(course)); return; }
+    fprintf(studentList, "%s %s Course Students List\n\n", course.code, course.name);
+    RegistrationJoinIterator(courseItem, registrationCourseEncode, studentList);
+    fclose(studentList);
     printf("\nSuccessfully printed the students list to file %s_STUDENTLIST.txt\n", course.code);
     free(fileName); freeItem(wrapCourse(course));
 }
 
+// MARK: - FORMAT CONVERSION
+
+/* One-shot conversion between text and binary files. Records are read with the decoding functions of the
+ 'source' format and written with the encoding functions of the 'destination' format, in the same order.
+ Converting from text to binary is used for moving an existing database to binary format, converting from
+ binary to text is used for exporting a binary database to human readable files. */
+
+int convertTable(ItemType type, StorageFormat source, StorageFormat destination) {
+    char sourceName[255]; char destinationName[255];
+    unsigned char record[MAX_RECORD_SIZE];
+    int recordSize = getRecordSizeForType(type); int count = 0; Arena arena = EMPTY_ARENA;
+    Item(*decodingFunction)(FILE*) = readInstructorFromFile;
+    Item(*recordDecodingFunction)(const unsigned char*) = decodeInstructorRecord;
+    getFileNameForTypeInFormat(type, source, sourceName);
+    prepareForIteration(type, destinationName, &decodingFunction);
+    getFileNameForTypeInFormat(type, destination, destinationName); // 'prepareForIteration' assigns the file name of the current format.
+    prepareForBinaryIteration(type, &recordDecodingFunction);
+    FILE *sourceFile = fopen(sourceName, "rb");
+    if (sourceFile == NULL) { printf("Skipped '%s', there is no such file.\n", sourceName); return 0; }
+    if (source == BinaryFormat && !readBinaryHeader(type, sourceFile)) { fclose(sourceFile); return 0; }
+    FILE *destinationFile = fopen(destinationName, "wb");
+    if (destinationFile == NULL) { printf("ERROR: Couldn't open '%s'.\n", destinationName); fclose(sourceFile); return 0; }
+    if (destination == BinaryFormat) { writeBinaryHeader(type, NULL, destinationFile); }
+    if (type == CourseType) { dropCourseDictionary(); } // Filled with the converted courses, so registrations are converted with it.
+    while (true) {
+        Item item; bool isRemoved = false;
+        if (source == BinaryFormat) {
+            if (fread(record, recordSize, 1, sourceFile) != 1) { break; }
+            isRemoved = !binaryRecordIsLive(record);
+            item = decodeRecordInArena(&arena, recordDecodingFunction, record);
+        } else {
+            int firstCharacter = getc(sourceFile);
+            if (firstCharacter == EOF) { break; }
+            isRemoved = firstCharacter == TEXT_TOMBSTONE;
+            fseek(sourceFile, ftell(sourceFile)-1, SEEK_SET);
+            item = decodeTextRecordInArena(&arena, decodingFunction, sourceFile);
+        }
+        if (!isRemoved) { // Removed records are not converted.
+            if (type == CourseType) {
+                if (source == TextFormat) { item.value.course.ID = count; } // Courses are given IDs in the order of the text file.
+                setCodeOfID(&courseDictionary.codes, item.value.course.ID, item.value.course.code);
+            }
+            if (destination == BinaryFormat) {
+                encodeItemToRecord(item, record); fwrite(record, recordSize, 1, destinationFile);
+            } else {
+                encodeItemAsText(item, destinationFile);
+            }
+            count++;
+        }
+        resetArena(&arena);
+    }
+    fclose(sourceFile); fclose(destinationFile); releaseArena(&arena);
+    tableFileChanged(destination, type);
+    if (type == CourseType) { courseDictionary.isLoaded = true; } // So it isn't loaded again from a file while registrations are converted, its stamp is left stale.
+    printf("Converted %d records from '%s' to '%s'.\n", count, sourceName, destinationName);
+    return count;
+}
+
+void convertDatabase(StorageFormat source, StorageFormat destination) {
+    // Log is emptied first, since converted files are written from scratch.
+    recoverFromLog();
+    convertTable(InstructorType, source, destination);
+    convertTable(CourseType, source, destination);
+    convertTable(StudentType, source, destination);
+    convertTable(RegistrationType, source, destination);
+}
+
+// MARK: - BULK LOADING
+
+/* '--load <file> [maxCount maxCredit]' populates an empty database from a file of CSV or NDJSON rows. Adding records
+ one by one with 'addItem' and 'registerStudentForCourse' looks up the database for every record, and writes the
+ counters of a student and a course for every registration. Instead, rows are read into memory first, and checked
+ in memory in the order of instructors, courses, students and registrations, so a row can refer to a record on a
+ later row. Counters of students and courses are calculated from the registrations that are accepted, counters are
+ not read from the file. At the end every file is written once from start to end, and its indexes are built from it.
+ A row that 'addItem' or 'registerStudentForCourse' wouldn't add, i.e. a course of an instructor that doesn't exist,
+ or a registration for a course whose quota is full, is reported with its line number and skipped.
+ 
+ Every row is a record, of any type. A CSV row starts with the type of the record, and fields of the record follow
+ in the order of 'loadedFieldNames', a field that has a comma or a quote is quoted, i.e.
+ 'course,CS50,"Computer Science, Introduction",4,100,1'. An NDJSON row is an object of string and number fields, i.e.
+ '{"type": "registration", "studentNumber": 1, "courseCode": "CS50"}'. Quota of a course is its total quota, and
+ a registration without a date gets the date of the load. Empty lines and lines starting with '#' are skipped.
+ A string should fit in its field of a binary record, and should be read back the same from a text record, so a
+ row is skipped if a string has a new line or another control character, if a field that is read as a word from a
+ text record, i.e. a course code, has whitespace, or if a string is longer than its field. */
+
+#define MAX_LOADED_FIELDS 5
+
+const char *loadedTypeNames[] = { "instructor", "course", "student", "registration" };
+
+// Fields of every type in the order of CSV columns, fields after the required ones can be left out.
+const char *loadedFieldNames[4][MAX_LOADED_FIELDS] = {
+    { "ID", "name", "surname", "title" },
+    { "code", "name", "credit", "quota", "instructorID" },
+    { "studentNumber", "name", "surname" },
+    { "studentNumber", "courseCode", "date" }
+};
+const int requiredLoadedFieldCounts[4] = { 4, 5, 3, 2 };
+
+typedef struct {
+    const char *names[MAX_LOADED_FIELDS];
+    const char *values[MAX_LOADED_FIELDS];
+    int count;
+} LoadedRow;
+
+typedef struct {
+    Item *items;
+    long *lineNumbers;
+    int count;
+    int capacity;
+} LoadedTable;
+
+// MARK: Parsing rows
+
+bool splitCSVRow(char *line, char **fields, int *fieldCount) {
+    // Splits 'line' into at most 'MAX_LOADED_FIELDS'+1 fields in place, quotes of quoted fields are removed. Returns false if the row is invalid.
+    char *cursor = line; *fieldCount = 0;
+    while (*fieldCount <= MAX_LOADED_FIELDS) {
+        char *field = cursor, *out = cursor;
+        if (*cursor == '"') {
+            for (cursor++; *cursor != '"' || cursor[1] == '"'; cursor++) {
+                if (*cursor == '\0') { return false; }
+                if (*cursor == '"') { cursor++; } // Doubled quote is a quote in a quoted field.
+                *out++ = *cursor;
+            }
+            cursor++;
+        }
+        while (*cursor != ',' && *cursor != '\0') { *out++ = *cursor++; }
+        bool isLastField = *cursor == '\0';
+        *out = '\0'; fields[(*fieldCount)++] = field;
+        if (isLastField) { return true; }
+        cursor++;
+    }
+    return false;
+}
+
+char *skipJSONSpaces(char *cursor) {
+    while (isspace((unsigned char)*cursor)) { cursor++; }
+    return cursor;
+}
+
+char *parseJSONString(char *cursor, char **string) {
+    // 'cursor' is at the opening quote, string is unescaped in place. Returns the position after the closing quote, or NULL if string is invalid.
+    char *out = ++cursor; *string = out;
+    for (; *cursor != '"'; cursor++) {
+        if (*cursor == '\0') { return NULL; }
+        if (*cursor != '\\') { *out++ = *cursor; continue; }
+        switch (*++cursor) {
+            case 'n': *out++ = '\n'; break;
+            case 't': *out++ = '\t'; break;
+            case 'r': *out++ = '\r'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'u': {
+                // Written as UTF-8, surrogate pairs are not combined.
+                unsigned int code = 0;
+                for (int i = 1; i <= 4; i++) {
+                    if (!isxdigit((unsigned char)cursor[i])) { return NULL; }
+                    code = code*16 + (isdigit((unsigned char)cursor[i]) ? cursor[i] - '0' : tolower((unsigned char)cursor[i]) - 'a' + 10);
+                }
+                cursor += 4;
+                if (code < 0x80) { *out++ = (char)code; }
+                else if (code < 0x800) { *out++ = (char)(0xC0 | code >> 6); *out++ = (char)(0x80 | (code & 0x3F)); }
+                else { *out++ = (char)(0xE0 | code >> 12); *out++ = (char)(0x80 | (code >> 6 & 0x3F)); *out++ = (char)(0x80 | (code & 0x3F)); }
+                break;
+            }
+            case '\0': return NULL;
+            default: *out++ = *cursor; // '"', '\\' and '/'.
+        }
+    }
+    *out = '\0';
+    return cursor + 1;
+}
+
+bool parseJSONObject(char *line, LoadedRow *row, char **typeName) {
+    /* Parses an object of string, number, boolean and null fields in place, 'type' field is assigned to 'typeName'
+     and other fields are added to 'row'. Null fields are left out. Returns false if the object is invalid. */
+    char *cursor = skipJSONSpaces(line);
+    row->count = 0; *typeName = NULL;
+    if (*cursor != '{') { return false; }
+    cursor = skipJSONSpaces(cursor + 1);
+    if (*cursor == '}') { return *skipJSONSpaces(cursor + 1) == '\0'; }
+    while (true) {
+        char *name, *value;
+        if (*cursor != '"' || (cursor = parseJSONString(cursor, &name)) == NULL) { return false; }
+        cursor = skipJSONSpaces(cursor);
+        if (*cursor != ':') { return false; }
+        cursor = skipJSONSpaces(cursor + 1);
+        bool isQuoted = *cursor == '"';
+        if (isQuoted) {
+            if ((cursor = parseJSONString(cursor, &value)) == NULL) { return false; }
+        } else {
+            for (value = cursor; *cursor != '\0' && *cursor != ',' && *cursor != '}' && !isspace((unsigned char)*cursor); cursor++) {}
+            if (cursor == value) { return false; }
+        }
+        char *valueEnd = cursor;
+        cursor = skipJSONSpaces(cursor);
+        char separator = *cursor;
+        *valueEnd = '\0'; // Separator is read first, since the value may end at the separator.
+        if (strcmp(name, "type") == 0) { *typeName = value; }
+        else if ((isQuoted || strcmp(value, "null") != 0) && row->count < MAX_LOADED_FIELDS) {
+            row->names[row->count] = name; row->values[row->count++] = value;
+        }
+        if (separator == '}') { return *skipJSONSpaces(cursor + 1) == '\0'; }
+        if (separator != ',') { return false; }
+        cursor = skipJSONSpaces(cursor + 1);
+    }
+}
+
+int loadedTypeOfName(const char *typeName) {
+    // Returns the 'ItemType' of 'typeName', or -1 if it isn't the name of a type.
+    for (int type = 0; type < 4 && typeName != NULL; type++) {
+        if (strcmp(typeName, loadedTypeNames[type]) == 0) { return type; }
+    }
+    return -1;
+}
+
+const char *loadedField(const LoadedRow *row, const char *name) {
+    // Returns the value of the field with 'name', or NULL if row doesn't have it.
+    for (int i = 0; i < row->count; i++) {
+        if (strcmp(row->names[i], name) == 0) { return row->values[i]; }
+    }
+    return NULL;
+}
+
+bool parseLoadedInteger(const LoadedRow *row, const char *name, int *number) {
+    const char *value = loadedField(row, name); char *end;
+    if (value == NULL) { return false; }
+    long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || parsed < INT32_MIN || parsed > INT32_MAX) { return false; }
+    *number = (int)parsed;
+    return true;
+}
+
+char *copyLoadedString(Arena *arena, const LoadedRow *row, const char *name) {
+    // Strings of loaded items are in the arena of the load, since the line they are read from is reused.
+    const char *value = loadedField(row, name);
+    char *string = allocateFromArena(arena, strlen(value) + 1);
+    strcpy(string, value);
+    return string;
+}
+
+bool itemOfLoadedRow(ItemType type, const LoadedRow *row, Arena *arena, const char *date, Item *item) {
+    // Assigns the item of 'row', counters are zero. Returns false if a required field is missing or a number is invalid.
+    for (int i = 0; i < requiredLoadedFieldCounts[type]; i++) {
+        if (loadedField(row, loadedFieldNames[type][i]) == NULL) { return false; }
+    }
+    Instructor instructor; Course course; Student student; Registration registration;
+    switch (type) {
+        case InstructorType:
+            if (!parseLoadedInteger(row, "ID", &instructor.ID)) { return false; }
+            instructor.name = copyLoadedString(arena, row, "name");
+            instructor.surname = copyLoadedString(arena, row, "surname");
+            instructor.title = copyLoadedString(arena, row, "title");
+            *item = wrapInstructor(instructor); return true;
+        case CourseType:
+            if (!parseLoadedInteger(row, "credit", &course.credit) || !parseLoadedInteger(row, "quota", &course.quota.total)
+                || !parseLoadedInteger(row, "instructorID", &course.instructorID)) { return false; }
+            course.code = copyLoadedString(arena, row, "code");
+            course.name = copyLoadedString(arena, row, "name");
+            course.quota.registered = 0; course.ID = -1;
+            *item = wrapCourse(course); return true;
+        case StudentType:
+            if (!parseLoadedInteger(row, "studentNumber", &student.studentNumber)) { return false; }
+            student.name = copyLoadedString(arena, row, "name");
+            student.surname = copyLoadedString(arena, row, "surname");
+            student.numberOfCoursesRegistered = 0; student.numberOfCreditsTaken = 0;
+            *item = wrapStudent(student); return true;
+        case RegistrationType:
+            if (!parseLoadedInteger(row, "studentNumber", &registration.studentNumber)) { return false; }
+            registration.ID = -1; registration.stillRegistered = true;
+            registration.courseCode = copyLoadedString(arena, row, "courseCode");
+            const char *loadedDate = loadedField(row, "date");
+            registration.date = allocateFromArena(arena, DATE_LENGTH);
+            strncpy(registration.date, (loadedDate != NULL && *loadedDate != '\0') ? loadedDate : date, DATE_LENGTH - 1);
+            registration.date[DATE_LENGTH-1] = '\0';
+            *item = wrapRegistration(registration); return true;
+    }
+    return false;
+}
+
+bool loadedStringsAreValid(ItemType type, const LoadedRow *row, long lineNumber) {
+    // Checks the string fields of 'row' like it is described above, and reports the first invalid one.
+    const BinaryField *schema = instructorSchema; int fieldCount = 0;
+    getSchemaForType(type, &schema, &fieldCount);
+    for (int i = 0; i < fieldCount; i++) {
+        const char *value = loadedField(row, schema[i].name);
+        if (schema[i].kind != StringField || value == NULL) { continue; }
+        bool isWord = findPredicateField(type, schema[i].name)->isWord;
+        for (const unsigned char *c = (const unsigned char *)value; *c != '\0'; c++) {
+            if (*c < 0x20 || *c == 0x7F) {
+                printf("ERROR: Line %ld is skipped. '%s' has a new line or a control character.\n", lineNumber, schema[i].name); return false;
+            }
+            if (isWord && *c == ' ') {
+                printf("ERROR: Line %ld is skipped. '%s' can't have spaces: %s.\n", lineNumber, schema[i].name, value); return false;
+            }
+        }
+        if (strlen(value) > schema[i].width - 1) {
+            printf("ERROR: Line %ld is skipped. '%s' is longer than %u bytes.\n", lineNumber, schema[i].name, schema[i].width - 1); return false;
+        }
+    }
+    return true;
+}
+
+// MARK: Reading rows
+
+void appendLoadedItem(LoadedTable *table, Item item, long lineNumber) {
+    if (table->count == table->capacity) {
+        table->capacity = (table->capacity == 0) ? 256 : 2*table->capacity;
+        table->items = realloc(table->items, table->capacity*sizeof(Item));
+        table->lineNumbers = realloc(table->lineNumbers, table->capacity*sizeof(long));
+        if (table->items == NULL || table->lineNumbers == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'appendLoadedItem' function.\n"); exit(1); }
+    }
+    table->lineNumbers[table->count] = lineNumber;
+    table->items[table->count++] = item;
+}
+
+bool readLoadedRows(const char *fileName, LoadedTable *tables, Arena *arena, const char *date, long *skippedCount) {
+    // Reads the rows of 'fileName' into the table of their types. Rows are CSV, unless they start with '{'.
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) { printf("ERROR: Couldn't open '%s'.\n", fileName); return false; }
+    char *line = NULL; size_t capacity = 0; long lineNumber = 0;
+    while (getline(&line, &capacity, file) != -1) {
+        lineNumber++;
+        line[strcspn(line, "\r\n")] = '\0';
+        char *start = skipJSONSpaces(line);
+        if (*start == '\0' || *start == '#') { continue; }
+        LoadedRow row; row.count = 0; char *typeName = NULL; int type = -1; Item item;
+        bool isValid;
+        if (*start == '{') {
+            isValid = parseJSONObject(start, &row, &typeName);
+            type = loadedTypeOfName(typeName);
+        } else {
+            char *fields[MAX_LOADED_FIELDS + 1]; int fieldCount = 0;
+            isValid = splitCSVRow(start, fields, &fieldCount);
+            type = (isValid) ? loadedTypeOfName(fields[0]) : -1;
+            for (int i = 1; i < fieldCount && type >= 0; i++) {
+                if (loadedFieldNames[type][i-1] == NULL) { isValid = false; break; } // Too many fields.
+                row.names[row.count] = loadedFieldNames[type][i-1]; row.values[row.count++] = fields[i];
+            }
+        }
+        if (!isValid || type < 0 || !itemOfLoadedRow(type, &row, arena, date, &item)) {
+            printf("ERROR: Line %ld of '%s' is skipped, it is not a valid row.\n", lineNumber, fileName); (*skippedCount)++;
+            continue;
+        }
+        if (!loadedStringsAreValid(type, &row, lineNumber)) { (*skippedCount)++; continue; }
+        appendLoadedItem(&tables[type], item, lineNumber);
+    }
+    free(line); fclose(file);
+    return true;
+}
+
+// MARK: Checking rows in memory
+
+void checkLoadedTables(LoadedTable *tables, int MAX_COUNT, int MAX_CREDIT, long *skippedCount) {
+    /* Keeps the rows that would be added to the database, in the order they are read, and calculates the counters of
+     students and courses. Registrations are checked like 'registerStudentForCourseBase' checks them, and they are
+     given IDs in order. */
+    KeyTable instructorIDs = { NULL, NULL, 0, 0 }, studentNumbers = { NULL, NULL, 0, 0 }, registeredPairs = { NULL, NULL, 0, 0 };
+    CodeDictionary courseCodes; memset(&courseCodes, 0, sizeof(courseCodes));
+    LoadedTable *instructors = &tables[InstructorType], *courses = &tables[CourseType];
+    LoadedTable *students = &tables[StudentType], *registrations = &tables[RegistrationType];
+    int kept = 0;
+    for (int i = 0; i < instructors->count; i++) {
+        Instructor instructor = instructors->items[i].value.instructor;
+        if (findKey(&instructorIDs, instructor.ID) >= 0) {
+            printf("ERROR: Line %ld is skipped. There is already an instructor with the same ID: %d.\n", instructors->lineNumbers[i], instructor.ID);
+            (*skippedCount)++; continue;
+        }
+        insertKey(&instructorIDs, instructor.ID, kept);
+        instructors->items[kept] = instructors->items[i]; instructors->lineNumbers[kept++] = instructors->lineNumbers[i];
+    }
+    instructors->count = kept; kept = 0;
+    for (int i = 0; i < courses->count; i++) {
+        Course course = courses->items[i].value.course;
+        if (findCodeID(&courseCodes, course.code) >= 0) {
+            printf("ERROR: Line %ld is skipped. There is already a course with the same course code: %s.\n", courses->lineNumbers[i], course.code);
+            (*skippedCount)++; continue;
+        }
+        if (findKey(&instructorIDs, course.instructorID) < 0) {
+            printf("ERROR: Line %ld is skipped. There is no instructor with the ID: %d.\n", courses->lineNumbers[i], course.instructorID);
+            (*skippedCount)++; continue;
+        }
+        setCodeOfID(&courseCodes, kept, course.code);
+        courses->items[kept] = courses->items[i]; courses->lineNumbers[kept++] = courses->lineNumbers[i];
+    }
+    courses->count = kept; kept = 0;
+    for (int i = 0; i < students->count; i++) {
+        Student student = students->items[i].value.student;
+        if (findKey(&studentNumbers, student.studentNumber) >= 0) {
+            printf("ERROR: Line %ld is skipped. There is already a student with the number: %d.\n", students->lineNumbers[i], student.studentNumber);
+            (*skippedCount)++; continue;
+        }
+        insertKey(&studentNumbers, student.studentNumber, kept);
+        students->items[kept] = students->items[i]; students->lineNumbers[kept++] = students->lineNumbers[i];
+    }
+    students->count = kept; kept = 0;
+    for (int i = 0; i < registrations->count; i++) {
+        Registration registration = registrations->items[i].value.registration; long lineNumber = registrations->lineNumbers[i];
+        int32_t coursePosition = findCodeID(&courseCodes, registration.courseCode);
+        int32_t studentPosition = findKey(&studentNumbers, registration.studentNumber);
+        int64_t pair = (int64_t)(((uint64_t)(uint32_t)studentPosition << 32) | (uint32_t)coursePosition);
+        if (coursePosition < 0) {
+            printf("ERROR: Line %ld is skipped. There is no course with code: %s.\n", lineNumber, registration.courseCode);
+            (*skippedCount)++; continue;
+        }
+        if (studentPosition < 0) {
+            printf("ERROR: Line %ld is skipped. There is no student with student number: %d.\n", lineNumber, registration.studentNumber);
+            (*skippedCount)++; continue;
+        }
+        Course *course = &courses->items[coursePosition].value.course;
+        Student *student = &students->items[studentPosition].value.student;
+        if (student->numberOfCoursesRegistered >= MAX_COUNT) {
+            printf("ERROR: Line %ld is skipped. '%s %s' is already registered in %d courses.\n", lineNumber, student->name, student->surname, student->numberOfCoursesRegistered);
+        } else if (student->numberOfCreditsTaken + course->credit > MAX_CREDIT) {
+            printf("ERROR: Line %ld is skipped. '%s %s' would take more than %d credits.\n", lineNumber, student->name, student->surname, MAX_CREDIT);
+        } else if (course->quota.registered >= course->quota.total) {
+            printf("ERROR: Line %ld is skipped. Quota of %s is exceeded.\n", lineNumber, course->code);
+        } else if (findKey(&registeredPairs, pair) >= 0) {
+            printf("ERROR: Line %ld is skipped. '%s %s' is already registered for %s.\n", lineNumber, student->name, student->surname, course->code);
+        } else {
+            student->numberOfCoursesRegistered++; student->numberOfCreditsTaken += course->credit; course->quota.registered++;
+            registration.ID = kept; registration.courseCode = course->code;
+            insertKey(&registeredPairs, pair, kept);
+            registrations->items[kept] = wrapRegistration(registration); registrations->lineNumbers[kept++] = lineNumber;
+            continue;
+        }
+        (*skippedCount)++;
+    }
+    registrations->count = kept;
+    freeKeyTable(&instructorIDs); freeKeyTable(&studentNumbers); freeKeyTable(&registeredPairs); freeCodeDictionary(&courseCodes);
+}
+
+// MARK: Writing files
+
+void writeLoadedTable(ItemType type, const LoadedTable *table) {
+    /* Writes every item of 'table' to a new file from start to end, replaces the file of 'type' with it, and builds
+     the indexes of the file, like 'compactTable' does. */
+    char fileName[255], temporaryFileName[255];
+    getFileNameForType(type, fileName);
+    sprintf(temporaryFileName, "tmp.%s", (databaseFormat == BinaryFormat) ? "dat" : "txt");
+    FILE *file = fopen(temporaryFileName, "wb");
+    if (file == NULL) { printf("ERROR: Couldn't open '%s' at 'writeLoadedTable' function.\n", temporaryFileName); return; }
+    TableCounts counts; memset(&counts, 0, sizeof(counts));
+    counts.isCounted = 1; counts.liveCount = table->count;
+    if (type == RegistrationType || (type == CourseType && databaseFormat == BinaryFormat)) { counts.nextID = table->count; }
+    bool fillsCourseDictionary = type == CourseType && databaseFormat == BinaryFormat;
+    if (fillsCourseDictionary) { dropCourseDictionary(); } // Filled with the loaded courses, so registrations are encoded with it.
+    if (databaseFormat == BinaryFormat) { writeBinaryHeader(type, &counts, file); }
+    for (int i = 0; i < table->count; i++) {
+        Item item = table->items[i];
+        if (fillsCourseDictionary) {
+            item.value.course.ID = i;
+            setCodeOfID(&courseDictionary.codes, i, item.value.course.code);
+        }
+        if (databaseFormat == BinaryFormat) {
+            unsigned char record[MAX_RECORD_SIZE];
+            encodeItemToRecord(item, record); fwrite(record, getRecordSizeForType(type), 1, file);
+        } else {
+            encodeItemAsText(item, file);
+        }
+    }
+    fclose(file); rename(temporaryFileName, fileName);
+    tableFileChanged(databaseFormat, type);
+    if (fillsCourseDictionary) { courseDictionary.isLoaded = true; }
+    rebuildIndexesOfType(type);
+    TableHeader *tableHeader = &tableHeaders[databaseFormat][type];
+    tableHeader->counts = counts; tableHeader->isLoaded = true;
+    stampTableHeader(type);
+}
+
+void loadDatabase(const char *fileName, int MAX_COUNT, int MAX_CREDIT) {
+    // Populates the empty database with the rows of 'fileName', see above.
+    recoverFromLog();
+    for (int type = 0; type < 4; type++) {
+        char tableFileName[255];
+        getFileNameForType(type, tableFileName);
+        if (getRecordSlotCountOfAFile(type) > 0) {
+            printf("ERROR: Couldn't load '%s'. Database should be empty, but '%s' has records.\n", fileName, tableFileName); return;
+        }
+    }
+    LoadedTable tables[4]; memset(tables, 0, sizeof(tables));
+    Arena arena = EMPTY_ARENA; long skippedCount = 0;
+    char date[DATE_LENGTH]; getDateForRegistration(date);
+    if (readLoadedRows(fileName, tables, &arena, date, &skippedCount)) {
+        checkLoadedTables(tables, MAX_COUNT, MAX_CREDIT, &skippedCount);
+        checkpointLog(); // Files are written from scratch.
+        for (int type = 0; type < 4; type++) { writeLoadedTable(type, &tables[type]); }
+        printf("Loaded %d instructors, %d courses, %d students and %d registrations from '%s', %ld rows are skipped.\n",
+               tables[InstructorType].count, tables[CourseType].count, tables[StudentType].count, tables[RegistrationType].count, fileName, skippedCount);
+    }
+    for (int type = 0; type < 4; type++) { free(tables[type].items); free(tables[type].lineNumbers); }
+    releaseArena(&arena);
+}
+
 void applyTests(void);
 Item createItemOfType(ItemType type, bool forUpdate);
 void deleteItemOfType(ItemType type);
 void updateItemOfType(ItemType type);
 void menu(void);
 
+// MARK: - BENCHMARK
+
+/* '--benchmark [records]' measures how many text records per second are decoded by the parser of 'DECODING FUNCTIONS'
+ and by 'fgets' and 'sscanf' as the decoders did before it, how fast every kernel counts new lines, and how fast
+ every kernel filters the columns of registrations. Registrations are generated in memory with 'encodeItemAsText',
+ so the files of the database are not touched. */
+
+#define BENCHMARK_RECORD_COUNT 200000
+#define BENCHMARK_COUNTING_ROUNDS 20
+#define BENCHMARK_FILTERING_ROUNDS 50
+
+Item decodeRegistrationWithScanf(FILE *registrationsFile) {
+    // Registration decoder that was used before the parser, kept only to be compared with it.
+    Registration registration; char buffer[255]; char registrationStatus[6];
+    registration.courseCode = allocateDecodedString(255, "decodeRegistrationWithScanf");
+    registration.date = allocateDecodedString(20, "decodeRegistrationWithScanf");
+    fgets(buffer, 255, registrationsFile);
+    sscanf(buffer, "ID: %d\n", &registration.ID);
+    fgets(buffer, 255, registrationsFile);
+    sscanf(buffer, "Course code: %s\n", registration.courseCode);
+    fgets(buffer, 255, registrationsFile);
+    sscanf(buffer, "Student number: %d\n", &registration.studentNumber);
+    fgets(buffer, 255, registrationsFile);
+    sscanf(buffer, "Still registered: %5s\n", registrationStatus);
+    fgets(buffer, 255, registrationsFile);
+    sscanf(buffer, "Registration date: %19[^\n]\n", registration.date);
+    fgets(buffer, 255, registrationsFile);
+    registration.stillRegistered = (strcmp(registrationStatus, "False") == 0) ? false : true;
+    return wrapRegistration(registration);
+}
+
+double secondsSince(struct timespec start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start.tv_sec) + (double)(now.tv_nsec - start.tv_nsec)/1e9;
+}
+
+long benchmarkStreamDecoder(const char *text, size_t length, int recordCount, Item(*decodingFunction)(FILE*), double *seconds) {
+    // Decodes every record of 'text' through a stream, returns a checksum of the decoded records.
+    Arena arena = EMPTY_ARENA; long checksum = 0; struct timespec start;
+    FILE *file = fmemopen((void*)text, length, "r");
+    if (file == NULL) { printf("ERROR: Couldn't open a stream for the benchmark.\n"); exit(1); }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < recordCount; i++) {
+        Registration registration = decodeTextRecordInArena(&arena, decodingFunction, file).value.registration;
+        checksum += registration.ID + registration.studentNumber + registration.stillRegistered + registration.courseCode[0] + registration.date[0];
+        resetArena(&arena);
+    }
+    *seconds = secondsSince(start);
+    fclose(file); releaseArena(&arena);
+    return checksum;
+}
+
+long benchmarkParser(const char *text, size_t length, double *seconds) {
+    // Parses every record of 'text' in place, like 'scanTextRecords' does with a mapping.
+    Arena arena = EMPTY_ARENA; long checksum = 0; struct timespec start; TextLine lines[MAX_TEXT_RECORD_LINES];
+    int lineCount = getTextRecordLineCount(RegistrationType);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (const char *cursor = text, *end = text + length; cursor < end;) {
+        cursor = splitTextLines(cursor, end, lines, lineCount);
+        Registration registration = parseTextLinesInArena(&arena, parseRegistrationLines, lines).value.registration;
+        checksum += registration.ID + registration.studentNumber + registration.stillRegistered + registration.courseCode[0] + registration.date[0];
+        resetArena(&arena);
+    }
+    *seconds = secondsSince(start);
+    releaseArena(&arena);
+    return checksum;
+}
+
+void benchmarkRegistrationColumns(const char *text, size_t length, const char **kernelNames) {
+    // Builds the columns of the registrations in 'text', and filters the active registrations of a student with every kernel.
+    RegistrationColumns columns; memset(&columns, 0, sizeof(columns));
+    Arena arena = EMPTY_ARENA; TextLine lines[MAX_TEXT_RECORD_LINES];
+    for (const char *cursor = text, *end = text + length; cursor < end;) {
+        long offset = cursor - text;
+        cursor = splitTextLines(cursor, end, lines, getTextRecordLineCount(RegistrationType));
+        appendRegistrationRow(&columns, parseTextLinesInArena(&arena, parseRegistrationLines, lines).value.registration, offset);
+        resetArena(&arena);
+    }
+    releaseArena(&arena);
+    RegistrationFilter filter = { -1, 19000042, NULL, true };
+    int wordCount = (columns.count + COLUMN_ROW_ALIGNMENT - 1)/COLUMN_ROW_ALIGNMENT;
+    double bytes = (double)columns.count*sizeof(int32_t) + 2.0*wordCount*sizeof(uint64_t); // Column, and the bitmap read and written.
+    printf("Filtering the active registrations of a student in %d rows:\n", columns.count);
+    for (VectorKernel kernel = ScalarKernel; kernel <= AVX2Kernel; kernel++) {
+        if (!vectorKernelIsAvailable(kernel)) { printf("  %-25s not available\n", kernelNames[kernel]); continue; }
+        struct timespec start; long matchCount = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int round = 0; round < BENCHMARK_FILTERING_ROUNDS; round++) {
+            uint64_t *matches = filterRegistrationColumns(&columns, filter, kernel);
+            for (int word = 0; word < wordCount; word++) { matchCount += __builtin_popcountll(matches[word]); }
+            free(matches);
+        }
+        double seconds = secondsSince(start);
+        printf("  %-25s %12.0f rows/s, %.1f GB/s (%ld matches)\n", kernelNames[kernel], BENCHMARK_FILTERING_ROUNDS*columns.count/seconds,
+               BENCHMARK_FILTERING_ROUNDS*bytes/1e9/seconds, matchCount/BENCHMARK_FILTERING_ROUNDS);
+    }
+    freeRegistrationColumns(&columns);
+}
+
+void runBenchmark(int recordCount) {
+    char *text = NULL; size_t length = 0; double seconds;
+    FILE *stream = open_memstream(&text, &length);
+    if (stream == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'runBenchmark' function.\n"); exit(1); }
+    for (int i = 0; i < recordCount; i++) {
+        char courseCode[CODE_LENGTH], date[DATE_LENGTH];
+        sprintf(courseCode, "BLM%d", 1000 + i % 500);
+        sprintf(date, "2020-12-%02d 10:%02d:%02d", 1 + i % 28, i % 60, (i / 60) % 60);
+        Registration registration = { i + 1, 19000000 + i % 5000, courseCode, i % 7 != 0, date };
+        encodeItemAsText(wrapRegistration(registration), stream);
+    }
+    fclose(stream);
+    printf("Decoding %d registration records (%.1f MB):\n", recordCount, length/1e6);
+    long expectedChecksum = benchmarkStreamDecoder(text, length, recordCount, decodeRegistrationWithScanf, &seconds);
+    printf("  fgets + sscanf:           %12.0f records/s\n", recordCount/seconds);
+    long checksum = benchmarkStreamDecoder(text, length, recordCount, readRegistrationFromFile, &seconds);
+    printf("  fgets + parser:           %12.0f records/s%s\n", recordCount/seconds, (checksum == expectedChecksum) ? "" : "  (MISMATCH)");
+    checksum = benchmarkParser(text, length, &seconds);
+    printf("  parser on memory:         %12.0f records/s%s\n", recordCount/seconds, (checksum == expectedChecksum) ? "" : "  (MISMATCH)");
+    printf("Counting new lines:\n");
+    const char *kernelNames[] = { "scalar", "SSE2", "AVX2" };
+    for (VectorKernel kernel = ScalarKernel; kernel <= AVX2Kernel; kernel++) {
+        if (!vectorKernelIsAvailable(kernel)) { printf("  %-25s not available\n", kernelNames[kernel]); continue; }
+        struct timespec start; size_t count = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int round = 0; round < BENCHMARK_COUNTING_ROUNDS; round++) { count += countNewlinesWithKernel(kernel, text, text + length); }
+        seconds = secondsSince(start);
+        printf("  %-25s %12.0f MB/s (%zu lines)\n", kernelNames[kernel], BENCHMARK_COUNTING_ROUNDS*length/1e6/seconds, count/BENCHMARK_COUNTING_ROUNDS);
+    }
+    benchmarkRegistrationColumns(text, length, kernelNames);
+    free(text);
+}
+
 int main(int argc, const char * argv[]) {
 //    applyTests();
+    /* '--binary' makes program use binary files (*.dat) instead of text files (*.txt).
+     '--convert' converts text files to binary files, '--export' converts binary files to text files.
+     '--no-mmap' makes program read files through the buffer pool instead of mapping them to memory.
+     '--buffer-pool <pages>' sets the number of pages of 4096 bytes the buffer pool holds.
+     '--no-index' makes program find records by scanning files instead of using indexes.
+     '--compaction-ratio <ratio>' sets the ratio of removed records that triggers compaction of a file, a ratio
+     above 1 disables it. '--compact' compacts every file of the database.
+     '--no-wal' makes program change files without writing the changes to the write-ahead log first.
+     '--no-columns' makes program scan registrations instead of filtering their columns when indexes are disabled.
+     '--no-batching' makes program propagate a credit change of a course to its students one registration at a time.
+     '--check' reports orphan records and counters that are different from the registrations, see 'INTEGRITY CHECK',
+     '--repair' also rewrites the counters with the values counted from the registrations.
+     '--benchmark [records]' compares the text record parser with 'sscanf', see 'BENCHMARK'.
+     '--load <file> [maxCount maxCredit]' populates the empty database from a CSV or NDJSON file, see 'BULK LOADING',
+     registrations are limited by the maximum number of courses and credits of a student if they are given. */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) { databaseFormat = BinaryFormat; }
+        else if (strcmp(argv[i], "--no-mmap") == 0) { memoryMappedReads = false; }
+        else if (strcmp(argv[i], "--no-index") == 0) { indexedLookups = false; }
+        else if (strcmp(argv[i], "--no-wal") == 0) { writeAheadLogging = false; }
+        else if (strcmp(argv[i], "--no-columns") == 0) { columnarRegistrations = false; }
+        else if (strcmp(argv[i], "--no-batching") == 0) { batchedCreditPropagation = false; }
+        else if (strcmp(argv[i], "--buffer-pool") == 0 && i + 1 < argc) { bufferPoolPageCount = atoi(argv[++i]); }
+        else if (strcmp(argv[i], "--compaction-ratio") == 0 && i + 1 < argc) { compactionGarbageRatio = atof(argv[++i]); }
+        else if (strcmp(argv[i], "--compact") == 0) { compactDatabase(); return 0; }
+        else if (strcmp(argv[i], "--check") == 0) { checkDatabase(false); return 0; }
+        else if (strcmp(argv[i], "--repair") == 0) { checkDatabase(true); return 0; }
+        else if (strcmp(argv[i], "--convert") == 0) { convertDatabase(TextFormat, BinaryFormat); return 0; }
+        else if (strcmp(argv[i], "--export") == 0) { convertDatabase(BinaryFormat, TextFormat); return 0; }
+        else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            int MAX_COUNT = (i + 3 < argc) ? atoi(argv[i+2]) : INT32_MAX, MAX_CREDIT = (i + 3 < argc) ? atoi(argv[i+3]) : INT32_MAX;
+            loadDatabase(argv[i+1], MAX_COUNT, MAX_CREDIT); return 0;
+        }
+        else if (strcmp(argv[i], "--benchmark") == 0) {
+            int recordCount = (i + 1 < argc && atoi(argv[i+1]) > 0) ? atoi(argv[i+1]) : BENCHMARK_RECORD_COUNT;
+            runBenchmark(recordCount); return 0;
+        }
+    }
+    recoverFromLog();
     menu();
     return 0;
 }
@@ -1179,6 +6519,38 @@ void createRegistration(int *MAX_COUNT, int *MAX_CREDIT) {
     free(courseCode); free(buffer);
 }
 
+void createRegistrationBatch(int *MAX_COUNT, int *MAX_CREDIT) {
+    // Reads the requests of a batch, one student number and course code on every line, and prints the result of every request.
+    if (*MAX_COUNT < 0) {
+        printf("\nEnter the maximum number of courses that a student can register in a quarter: ");
+        scanf("%d", MAX_COUNT); getchar();
+        printf("Enter the maximum number of credits that a student can use in a quarter: ");
+        scanf("%d", MAX_CREDIT); getchar();
+    }
+    int count = 0;
+    printf("\nEnter the number of registrations in the batch: ");
+    scanf("%d", &count); getchar();
+    if (count <= 0) { printf("Invalid number of registrations.\n"); return; }
+    RegistrationRequest *requests = malloc(sizeof(RegistrationRequest)*count);
+    char *buffer = malloc(sizeof(char)*255);
+    if (requests == NULL || buffer == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'createRegistrationBatch' function.\n"); exit(1); }
+    printf("Enter the student number and the course code of every registration, separated by a space, one on every line:\n");
+    for (int i = 0; i < count; i++) {
+        requests[i].courseCode = malloc(sizeof(char)*255); requests[i].studentNumber = 0;
+        if (requests[i].courseCode == NULL) { printf("EXCEPTION: Couldn't allocate memory in 'createRegistrationBatch' function.\n"); exit(1); }
+        requests[i].courseCode[0] = '\0';
+        if (fgets(buffer, 255, stdin) != NULL) { sscanf(buffer, "%d %254s", &requests[i].studentNumber, requests[i].courseCode); }
+    }
+    printf("\n");
+    RegistrationBatch batch = { requests, count };
+    registerStudentsForCourses(batch, *MAX_COUNT, *MAX_CREDIT);
+    for (int i = 0; i < count; i++) {
+        printf("%d, %s: %s\n", requests[i].studentNumber, requests[i].courseCode, registrationResultNames[requests[i].result]);
+        free(requests[i].courseCode);
+    }
+    free(requests); free(buffer);
+}
+
 void deleteItemOfType(ItemType type) {
     char *buffer = malloc(sizeof(char)*255);
     char *courseCode = malloc(sizeof(char)*255);
@@ -1273,6 +6645,13 @@ void list(int mode) {
         fgets(buffer, 255, stdin);
         sscanf(buffer, "%s\n", courseCode); printf("\n");
         printStudentListOfACourseToAFile(wrapCourseWithCode(courseCode));
+    } else if (mode == 5) {
+        int lowestStudentNumber = 0; int highestStudentNumber = 0;
+        printf("Enter the lowest student number of the range: ");
+        scanf("%d", &lowestStudentNumber); getchar();
+        printf("Enter the highest student number of the range: ");
+        scanf("%d", &highestStudentNumber); getchar(); printf("\n");
+        listStudentsInStudentNumberRange(lowestStudentNumber, highestStudentNumber);
     } else {
         printf("Invalid selection.\n");
     }
@@ -1288,21 +6667,24 @@ void menu() {
     printf("Enter '3', for updating Instructor, Course, Student or Registration record from database.\n");
     printf("Enter '4', for listing operations.\n");
     printf("Enter '5', for terminating the program.\n");
+    printf("Enter '6', for beginning, committing or aborting a transaction.\n");
     while (true) {
-        printf("\n('1' -> Add, '2' -> Remove, '3' -> Update, '4' -> List, '5' -> Exit)\n");
+        printf("\n('1' -> Add, '2' -> Remove, '3' -> Update, '4' -> List, '5' -> Exit, '6' -> Transaction)\n");
         printf("Please enter a valid operation number: ");
         scanf("%d", &option); getchar();
         if (option == 1) {
             printf("\nEnter '1', for adding Instructor.\n");
             printf("Enter '2', for adding Course.\n");
             printf("Enter '3', for adding Student.\n");
-            printf("Enter '4', for adding Registration.\n\n");
+            printf("Enter '4', for adding Registration.\n");
+            printf("Enter '5', for adding Registrations of many students and courses in a batch.\n\n");
             printf("Enter value: ");
             scanf("%d", &option); getchar();
             if (option == 1) { createItemOfType(InstructorType, false); }
             else if (option == 2) { createItemOfType(CourseType, false); }
             else if (option == 3) { createItemOfType(StudentType, false); }
             else if (option == 4) { createRegistration(&MAX_COUNT, &MAX_CREDIT); }
+            else if (option == 5) { createRegistrationBatch(&MAX_COUNT, &MAX_CREDIT); }
             else { printf("Invalid operation number.\n"); }
         } else if (option == 2) {
             printf("\nEnter '1', for removing Instructor.\n");
@@ -1330,12 +6712,24 @@ void menu() {
             printf("\nEnter '1', for listing courses given by an specific instructor.\n");
             printf("Enter '2', for listing students that is registered for specific course.\n");
             printf("Enter '3', for listing all courses that specific student is registered for.\n");
-            printf("Enter '4', for printing student list of a course taught by specific instructor, to a file.\n\n");
+            printf("Enter '4', for printing student list of a course taught by specific instructor, to a file.\n");
+            printf("Enter '5', for listing students in a range of student numbers, i.e. students of a cohort.\n\n");
             printf("Enter value: ");
             scanf("%d", &option); getchar();
             list(option);
         } else if (option == 5) {
+            if (transaction.isOpen) { abortTransaction(); }
             printf("Program terminated.\n"); break;
+        } else if (option == 6) {
+            printf("\nEnter '1', for beginning a transaction, operations after it are applied together when it is committed.\n");
+            printf("Enter '2', for committing the transaction.\n");
+            printf("Enter '3', for aborting the transaction.\n\n");
+            printf("Enter value: ");
+            scanf("%d", &option); getchar();
+            if (option == 1) { if (beginTransaction()) { printf("Began a transaction.\n"); } }
+            else if (option == 2) { if (commitTransaction()) { printf("Committed the transaction.\n"); } }
+            else if (option == 3) { abortTransaction(); }
+            else { printf("Invalid operation number.\n"); }
         } else {
             printf("Invalid operation number.\n");
         }
@@ -1345,6 +6739,58 @@ void menu() {
 
 // MARK: Tests
 
+typedef struct {
+    int IDs[32];
+    int count;
+} RegistrationIDs;
+
+bool registrationIDCollectorVisitor(Item registration, long offset, void *context) {
+    RegistrationIDs *collected = context;
+    if (collected->count < 32) { collected->IDs[collected->count++] = registration.value.registration.ID; }
+    return false;
+}
+
+RegistrationIDs collectActiveRegistrationIDs(const Predicate *keyPredicate) {
+    // IDs of the active registrations that match 'keyPredicate', in the order of their records.
+    RegistrationIDs collected; collected.count = 0;
+    Predicate isActive = fieldComparedToNumber("stillRegistered", IsEqualTo, 1);
+    Predicate predicate = bothOfPredicates(keyPredicate, &isActive);
+    PredicateScanner(RegistrationType, &predicate, registrationIDCollectorVisitor, &collected);
+    return collected;
+}
+
+void printWhetherRegistrationIDsAreKept(RegistrationIDs before, RegistrationIDs after) {
+    bool areKept = before.count == after.count && memcmp(before.IDs, after.IDs, sizeof(int)*before.count) == 0;
+    printf("######### IDS OF THE REGISTRATIONS BEFORE THE UPDATE:");
+    for (int i = 0; i < before.count; i++) { printf(" %d", before.IDs[i]); }
+    printf("\n######### IDS OF THE REGISTRATIONS AFTER THE UPDATE:");
+    for (int i = 0; i < after.count; i++) { printf(" %d", after.IDs[i]); }
+    printf("\n######### REGISTRATIONS KEPT THEIR IDS: %s\n", (areKept) ? "YES" : "NO");
+}
+
+void moveCourseToInstructor(const char *code, int instructorID) {
+    // Updates the instructor of the course with 'code', the update is buffered if there is an open transaction.
+    Item course = getItem(wrapCourseWithCode((char*)code));
+    Item movedCourse = course; movedCourse.value.course.instructorID = instructorID;
+    updateItem(course, movedCourse);
+    freeItem(course);
+}
+
+void removeDatabaseFiles() {
+    // Removes the files of the database in 'databaseFormat' together with their headers and indexes, so the database is empty.
+    checkpointLog();
+    for (int type = 0; type < 4; type++) {
+        char fileName[255], headerName[255]; char indexNames[INDEX_COUNT_LIMIT][255];
+        closeIndexesOfType(type); dropBufferPagesOfTable(databaseFormat, type);
+        getFileNameForType(type, fileName);
+        getTableHeaderFileName(type, databaseFormat, headerName);
+        int indexCount = getIndexFileNamesOfType(type, databaseFormat, indexNames);
+        remove(fileName); remove(headerName);
+        for (int i = 0; i < indexCount; i++) { remove(indexNames[i]); }
+        tableHeaders[databaseFormat][type].isLoaded = false; tableFileChanged(databaseFormat, type);
+    }
+}
+
 void applyTests() {
     char c = 0;
     printf("!!!!!!!!!! ALL FILES WILL BE REMOVED TO APPLY TESTS !!!!!!!!!!\n");
@@ -1353,6 +6799,7 @@ void applyTests() {
     if (c != 'y') { printf("Cancelled the tests.\n"); exit(1); }
     
     remove("Instructors.txt"); remove("Courses.txt"); remove("Students.txt"); remove("Registrations.txt"); printf("\n");
+    for (int type = 0; type < 4; type++) { tableFileChanged(TextFormat, type); }
     
     printf("################################################################################## ADDING ITEMS TESTS #########################################################################################\n\n");
     
@@ -1615,10 +7062,14 @@ void applyTests() {
     Course newCode2400 = { "24.00x", "Introduction to Philosophy: God, Knowledge and Consciousness", 4, newQuota, 5 };
     printf("######### WE SHOULD BE ABLE TO CHANGE COURSE'S CODE UNLESS, NEW CODE IS ALREADY USED IN DATABASE BY OTHER COURSE.\n");
     printf("######### AFTER CHANGING THAT, ALL REGISTRATION MADE FOR THAT COURSE SHOULD ALSO GET UPDATED.\n");
-    printf("######### ALL REGISTRATIONS WITH OLD CODE; WILL GET INVALIDATED.\n");
-    printf("######### AND ALL STUDENTS REGISTERED FOR THE COURSE WILL HAVE NEW REGISTRATION RECORD WITH THE NEW COURSE CODE.\n");
+    printf("######### ACTIVE REGISTRATIONS WITH OLD CODE WILL BE CHANGED TO THE NEW CODE WHERE THEY ARE.\n");
+    printf("######### SO THEY WILL KEEP THEIR IDS AND REGISTRATION DATES, AND NO NEW REGISTRATION RECORD WILL BE ADDED.\n");
     printf("######### HERE IS THE RESULT OF OUR ATTEMPT TO UPDATE 'INTRODUCTION TO PHILISOPHY' COURSE'S CODE:\n");
+    Predicate isOfOldCode = fieldComparedToText("courseCode", IsEqualTo, "24.00");
+    Predicate isOfNewCode = fieldComparedToText("courseCode", IsEqualTo, "24.00x");
+    RegistrationIDs registrationsWithOldCode = collectActiveRegistrationIDs(&isOfOldCode);
     updateItem(wrapCourse(newCredit2400), wrapCourse(newCode2400));
+    printWhetherRegistrationIDsAreKept(registrationsWithOldCode, collectActiveRegistrationIDs(&isOfNewCode));
     printf("\n\n");
     
     printf("######################################## UPDATING STUDENT'S SURNAME (SHOULD SUCCEED) ########################################\n");
@@ -1639,10 +7090,14 @@ void applyTests() {
     Student aristotleNewNumber = { 384, "Aristoteles", "of Stagira", aristotleItem.value.student.numberOfCoursesRegistered, aristotleItem.value.student.numberOfCreditsTaken };
     printf("######### WE SHOULD BE ABLE TO CHANGE STUDENT'S STUDENT NUMBER.\n");
     printf("######### AFTER CHANGING THAT, ALL REGISTRATION MADE WITH THAT STUDENT NUMBER SHOULD ALSO GET UPDATED.\n");
-    printf("######### ALL REGISTRATIONS WITH OLD STUDENT NUMBER; WILL GET INVALIDATED.\n");
-    printf("######### AND ALL INVALIDATED REGISTRATIONS WILL BE RENEWED BY THE REGISTRATIONS WITH NEW STUDENT NUMBERS.\n");
+    printf("######### ACTIVE REGISTRATIONS WITH OLD STUDENT NUMBER WILL BE CHANGED TO THE NEW STUDENT NUMBER WHERE THEY ARE.\n");
+    printf("######### SO THEY WILL KEEP THEIR IDS AND REGISTRATION DATES, AND NO NEW REGISTRATION RECORD WILL BE ADDED.\n");
     printf("######### HERE IS THE RESULT OF OUR ATTEMPT TO UPDATE 'ARISTOTLE OF STAGIRA'S STUDENT NUMBER:\n");
+    Predicate isOfOldNumber = fieldComparedToNumber("studentNumber", IsEqualTo, 2);
+    Predicate isOfNewNumber = fieldComparedToNumber("studentNumber", IsEqualTo, 384);
+    RegistrationIDs registrationsWithOldNumber = collectActiveRegistrationIDs(&isOfOldNumber);
     updateItem(getItem(wrapStudent(aristotle)), wrapStudent(aristotleNewNumber));
+    printWhetherRegistrationIDsAreKept(registrationsWithOldNumber, collectActiveRegistrationIDs(&isOfNewNumber));
     printf("\n\n");
     
     printf("######################################### ATTEMPT TO UPDATE INSTRUCTOR'S ID WITH DUPLICATE VALUE (SHOULD FAIL) ################################################\n");
@@ -1680,4 +7135,195 @@ void applyTests() {
     printf("######################################## ALL TESTS ARE COMPLETED FOR UPDATING ITEMS ########################################\n");
     printf("######### YOU CAN CHECK WHETHER DATABASE FILES REFLECT THOSE CHANGES.\n");
     printf("\n\n");
+    
+    printf("################################################################################## TRANSACTION TESTS #########################################################################################\n\n");
+    
+    printf("######################################## COMMITTING A TRANSACTION THAT MOVES COURSES TO A NEW INSTRUCTOR (SHOULD SUCCEED) ########################################\n");
+    Instructor anantAgarwal = { 6, "Anant", "Agarwal", "Professor" };
+    printf("######### A NEW INSTRUCTOR IS ADDED, AND 3 COURSES ARE MOVED TO THEM IN ONE TRANSACTION.\n");
+    printf("######### OPERATIONS ARE BUFFERED UNTIL THE TRANSACTION IS COMMITTED, THEN ALL OF THEM ARE APPLIED TOGETHER.\n");
+    printf("######### HERE IS THE RESULT OF OUR ATTEMPT TO COMMIT THE TRANSACTION:\n");
+    beginTransaction();
+    addItem(wrapInstructor(anantAgarwal));
+    moveCourseToInstructor("CS193P", anantAgarwal.ID); moveCourseToInstructor("6.0001", anantAgarwal.ID); moveCourseToInstructor("24.00x", anantAgarwal.ID);
+    printf("######### TRANSACTION IS COMMITTED: %s\n", (commitTransaction()) ? "YES" : "NO");
+    listCoursesGivenByInstructor(wrapInstructorWithID(anantAgarwal.ID));
+    printf("\n\n");
+    
+    printf("######################################## ROLLING BACK A TRANSACTION WITH AN INVALID INSTRUCTOR ID (SHOULD FAIL) ########################################\n");
+    printf("######### '6.0001' IS MOVED BACK TO 'JOHN GUTTAG', AND 'CS193P' IS MOVED TO AN INSTRUCTOR THAT DOESN'T EXIST IN ONE TRANSACTION.\n");
+    printf("######### SECOND OPERATION SHOULD FAIL, SO NONE OF THE OPERATIONS SHOULD BE APPLIED, AND BOTH COURSES SHOULD STAY WITH 'ANANT AGARWAL'.\n");
+    printf("######### HERE IS THE RESULT OF OUR ATTEMPT TO COMMIT THE TRANSACTION:\n");
+    beginTransaction();
+    moveCourseToInstructor("6.0001", johnGuttag.ID); moveCourseToInstructor("CS193P", 1000);
+    printf("######### TRANSACTION IS COMMITTED: %s\n", (commitTransaction()) ? "YES" : "NO");
+    listCoursesGivenByInstructor(wrapInstructorWithID(anantAgarwal.ID));
+    printf("\n\n");
+    
+    printf("################################################################################## COURSE CODE DICTIONARY TESTS #########################################################################################\n\n");
+    
+    printf("######################################## REGISTERING FOR A COURSE BEFORE THE DICTIONARY OF COURSE CODES IS LOADED (SHOULD SUCCEED) ########################################\n");
+    Course cs50w = { "CS50W", "CS50's Web Programming with Python and JavaScript", 2, {0, 10}, 6 };
+    Student hypatia = { 415, "Hypatia", "of Alexandria", 0, 0 };
+    addItem(wrapCourse(cs50w)); addItem(wrapStudent(hypatia));
+    printf("######### IN BINARY FORMAT, A REGISTRATION KEEPS THE ID OF ITS COURSE, WHICH IS FOUND IN THE DICTIONARY OF COURSE CODES.\n");
+    printf("######### DICTIONARY IS DROPPED BEFORE EVERY STEP, LIKE IN A NEW PROCESS, SO IT IS LOADED BY THE STEP ITSELF.\n");
+    printf("######### 'HYPATIA' AND 'CS50W' HAVE NO REGISTRATIONS, SO NO REGISTRATION IS READ, WHICH WOULD LOAD THE DICTIONARY, BEFORE THE NEW ONE IS WRITTEN.\n");
+    printf("######### 'CS50W' SHOULD HAVE NO STUDENTS BEFORE THE REGISTRATION, LISTING THEM ALSO BRINGS INDEXES UP TO DATE WITH THE NEW COURSE:\n");
+    listStudentsRegisteredForCourse(wrapCourseWithCode(cs50w.code));
+    printf("######### 'HYPATIA' SHOULD BE REGISTERED, AND SHOULD BE LISTED AS THE ONLY STUDENT OF 'CS50W':\n");
+    dropCourseDictionary();
+    registerStudentForCourse(cs50w.code, hypatia.studentNumber, MAX_NUMBER_OF_COURSES, MAX_NUMBER_OF_CREDITS);
+    dropCourseDictionary();
+    listStudentsRegisteredForCourse(wrapCourseWithCode(cs50w.code));
+    printf("\n\n");
+    
+    printf("######################################## REMOVING THE COURSE BEFORE THE DICTIONARY OF COURSE CODES IS LOADED (SHOULD SUCCEED) ########################################\n");
+    printf("######### REGISTRATION OF 'HYPATIA' SHOULD BE INVALIDATED WITH THE COURSE, AND THE COUNTERS OF 'HYPATIA' SHOULD BE BACK TO 0.\n");
+    printf("######### THERE SHOULD BE NO ACTIVE REGISTRATIONS FOR 'CS50W', AND CHECK SHOULD FIND NO ORPHANS AND NO DIFFERENT COUNTERS:\n");
+    dropCourseDictionary();
+    removeItem(wrapCourse(cs50w));
+    Predicate isOfCS50W = fieldComparedToText("courseCode", IsEqualTo, cs50w.code);
+    printf("######### ACTIVE REGISTRATIONS FOR 'CS50W': %d\n", collectActiveRegistrationIDs(&isOfCS50W).count);
+    Item hypatiaItem = getItem(wrapStudentWithStudentNumber(hypatia.studentNumber));
+    printf("######### 'HYPATIA' IS REGISTERED IN %d COURSES, AND TAKES %d CREDITS.\n", hypatiaItem.value.student.numberOfCoursesRegistered, hypatiaItem.value.student.numberOfCreditsTaken);
+    freeItem(hypatiaItem);
+    checkDatabase(false);
+    printf("\n\n");
+    
+    printf("################################################################################## BATCH REGISTRATION TESTS #########################################################################################\n\n");
+    
+    printf("######################################## TEST FOR REGISTERING A BATCH OF REQUESTS (SOME SHOULD SUCCEED, SOME SHOULD FAIL) ########################################\n");
+    // Every student is registered in 3 courses and takes 10 credits, except 'Michelangelo Buonarroti' with 2 courses and 6 credits, and 'Hypatia'.
+    Course cs50ai = { "CS50AI", "CS50's Introduction to Artificial Intelligence with Python", 1, {0, 1}, 6 };
+    Course cs50p = { "CS50P", "CS50's Introduction to Programming with Python", 3, {0, 10}, 6 };
+    addItem(wrapCourse(cs50ai)); addItem(wrapCourse(cs50p));
+    printf("######### 8 REQUESTS ARE REGISTERED TOGETHER, A STUDENT CAN REGISTER IN 4 COURSES AND TAKE 12 CREDITS IN THIS BATCH.\n");
+    printf("######### EVERY REQUEST SHOULD SEE THE REQUESTS ACCEPTED BEFORE IT, AND GET THE RESULT IT WOULD GET IF IT WAS REGISTERED ALONE.\n");
+    printf("######### HERE IS THE RESULT OF EVERY REQUEST OF THE BATCH:\n");
+    RegistrationRequest requests[] = {
+        { cs50ai.code, denis.studentNumber, RegistrationIsAccepted }, // 4th course of 'Denis Diderot', with 11 credits.
+        { cs50p.code, denis.studentNumber, TooManyCourses }, // 'Denis Diderot' is registered in 4 courses after the first request.
+        { cs50ai.code, socrates.studentNumber, QuotaIsFull }, // Only seat of 'CS50AI' is taken by the first request.
+        { cs50p.code, socrates.studentNumber, TooManyCredits }, // 10 + 3 credits.
+        { cs50p.code, michelangelo.studentNumber, RegistrationIsAccepted }, // 6 + 3 credits.
+        { mit60001.code, plato.studentNumber, AlreadyRegistered },
+        { "INVALID", plato.studentNumber, NoSuchCourse },
+        { cs193p.code, -1000, NoSuchStudent }
+    };
+    int requestCount = sizeof(requests)/sizeof(RegistrationRequest);
+    RegistrationResult expectedResults[sizeof(requests)/sizeof(RegistrationRequest)];
+    for (int i = 0; i < requestCount; i++) { expectedResults[i] = requests[i].result; }
+    RegistrationBatch batch = { requests, requestCount };
+    registerStudentsForCourses(batch, 4, 12);
+    for (int i = 0; i < requestCount; i++) {
+        printf("######### %d, %s: %s (EXPECTED %s)\n", requests[i].studentNumber, requests[i].courseCode,
+               registrationResultNames[requests[i].result], registrationResultNames[expectedResults[i]]);
+    }
+    printf("######### 'DENIS DIDEROT' SHOULD BE REGISTERED IN 4 COURSES AND TAKE 11 CREDITS, 'MICHELANGELO BUONARROTI' IN 3 COURSES WITH 9 CREDITS.\n");
+    printf("######### 'CS50AI' AND 'CS50P' SHOULD BE USING 1 OF THEIR QUOTA, AND CHECK SHOULD FIND NO DIFFERENT COUNTERS:\n");
+    checkDatabase(false);
+    printf("\n\n");
+    
+    printf("################################################################################## RANGE QUERY TESTS #########################################################################################\n\n");
+    
+    printf("######################################## LISTING STUDENTS IN A RANGE OF STUDENT NUMBERS (SHOULD SUCCEED) ########################################\n");
+    printf("######### STUDENTS ARE VISITED IN THE ORDER OF THE ORDERED INDEX, NOT IN THE ORDER OF THE STUDENTS FILE, WHERE '384' IS AFTER '1713'.\n");
+    printf("######### STUDENTS '356', '384', '415', '1475' AND '1482' SHOULD BE LISTED IN THIS ORDER:\n");
+    listStudentsInStudentNumberRange(300, 1500);
+    printf("######### ONLY 'MICHELANGELO BUONARROTI' SHOULD BE LISTED, BOTH ENDS OF A RANGE ARE IN THE RANGE:\n");
+    listStudentsInStudentNumberRange(michelangelo.studentNumber, michelangelo.studentNumber);
+    printf("######### NO STUDENTS SHOULD BE LISTED, THERE ARE NO STUDENTS AFTER 'DENIS DIDEROT':\n");
+    listStudentsInStudentNumberRange(denis.studentNumber + 1, 10000);
+    printf("\n\n");
+    
+    printf("################################################################################## COMPACTION TESTS #########################################################################################\n\n");
+    
+    printf("######################################## COMPACTING FILES WHEN TOMBSTONES REACH THE GARBAGE RATIO (SHOULD SUCCEED) ########################################\n");
+    double garbageRatio = compactionGarbageRatio; compactionGarbageRatio = 0.25;
+    compactDatabase();
+    Student temporaryStudents[] = { { 2001, "Temporary", "Student", 0, 0 }, { 2002, "Temporary", "Student", 0, 0 }, { 2003, "Temporary", "Student", 0, 0 } };
+    for (int i = 0; i < 3; i++) { addItem(wrapStudent(temporaryStudents[i])); }
+    printf("######### AFTER 3 STUDENTS ARE ADDED TO 9 STUDENTS, THERE SHOULD BE 12 RECORDS AND 0 REMOVED RECORDS IN THE STUDENTS FILE: %d RECORDS, %ld REMOVED.\n",
+           getRecordSlotCountOfAFile(StudentType), getTombstoneCountOfAFile(StudentType));
+    removeItem(wrapStudent(temporaryStudents[0])); removeItem(wrapStudent(temporaryStudents[1]));
+    printf("######### AFTER 2 OF THEM ARE REMOVED, THEY SHOULD STAY AS 2 REMOVED RECORDS OF 12, BELOW THE RATIO OF 0.25: %d RECORDS, %ld REMOVED.\n",
+           getRecordSlotCountOfAFile(StudentType), getTombstoneCountOfAFile(StudentType));
+    removeItem(wrapStudent(temporaryStudents[2]));
+    printf("######### AFTER THE 3RD ONE IS REMOVED, FILE SHOULD BE COMPACTED TO 9 RECORDS AND 0 REMOVED: %d RECORDS, %ld REMOVED.\n",
+           getRecordSlotCountOfAFile(StudentType), getTombstoneCountOfAFile(StudentType));
+    compactionGarbageRatio = garbageRatio;
+    printf("######### OFFSETS OF THE RECORDS HAVE CHANGED, SO INDEXES ARE REBUILT. 'DENIS DIDEROT' SHOULD STILL BE FOUND, AND CHECK SHOULD FIND NOTHING WRONG:\n");
+    Item denisItem = getItem(wrapStudentWithStudentNumber(denis.studentNumber));
+    printItem(denisItem); freeItem(denisItem);
+    checkDatabase(false);
+    printf("\n\n");
+    
+    printf("################################################################################## BULK LOADING TESTS #########################################################################################\n\n");
+    
+    printf("######################################## LOADING ROWS INTO A DATABASE THAT HAS RECORDS (SHOULD FAIL) ########################################\n");
+    const char *loadedRows[] = {
+        "# Rows are read in the order of their types, so a course can refer to an instructor on a later row.", // Line 1
+        "course,CS50,\"CS50's Introduction to Computer Science, with C\",4,2,1",
+        "instructor,1,David,Malan,Professor",
+        "{\"type\": \"student\", \"studentNumber\": 0, \"name\": \"Socrates\", \"surname\": \"of Athens\"}",
+        "student,1,Platon,of Athens", // Line 5
+        "student,2,Aristoteles,of Athens",
+        "registration,0,CS50",
+        "registration,0,CS50",
+        "{\"type\": \"registration\", \"studentNumber\": 1, \"courseCode\": \"CS50\", \"date\": \"01/01/2021 10:00:00\"}",
+        "registration,2,CS50", // Line 10
+        "registration,3,CS50",
+        "registration,0,CS404",
+        "course,CS50,Duplicate Course,4,80,1",
+        "course,6.0001,Introduction to Computer Science and Programming in Python,2,250,7",
+        "course,CS 50,Course Code With Spaces,4,80,1", // Line 15
+        "student,1,Duplicate,Student",
+        "not,a,row"
+    };
+    FILE *loadedFile = fopen("LoadTest.csv", "w");
+    if (loadedFile == NULL) { printf("ERROR: Couldn't open 'LoadTest.csv'.\n"); return; }
+    for (int i = 0; i < (int)(sizeof(loadedRows)/sizeof(char*)); i++) { fprintf(loadedFile, "%s\n", loadedRows[i]); }
+    fclose(loadedFile);
+    printf("######### DATABASE SHOULD BE EMPTY TO BE LOADED:\n");
+    loadDatabase("LoadTest.csv", MAX_NUMBER_OF_COURSES, MAX_NUMBER_OF_CREDITS);
+    printf("\n\n");
+    
+    printf("######################################## LOADING ROWS INTO AN EMPTY DATABASE (SOME ROWS SHOULD BE SKIPPED) ########################################\n");
+    printf("######### FILES OF THE DATABASE ARE REMOVED, AND THE ROWS ARE LOADED AGAIN.\n");
+    printf("######### LINE 8 SHOULD BE SKIPPED AS A DUPLICATE REGISTRATION, 10 FOR THE QUOTA, 11 FOR THE STUDENT AND 12 FOR THE COURSE.\n");
+    printf("######### LINE 13 SHOULD BE SKIPPED AS A DUPLICATE COURSE, 14 FOR THE INSTRUCTOR, 15 FOR THE SPACES, 16 AS A DUPLICATE STUDENT AND 17 AS AN INVALID ROW.\n");
+    printf("######### 1 INSTRUCTOR, 1 COURSE, 3 STUDENTS AND 2 REGISTRATIONS SHOULD BE LOADED, AND 9 ROWS SHOULD BE SKIPPED:\n");
+    removeDatabaseFiles();
+    loadDatabase("LoadTest.csv", MAX_NUMBER_OF_COURSES, MAX_NUMBER_OF_CREDITS);
+    remove("LoadTest.csv");
+    printf("######### 'CS50' SHOULD BE USING 2 OF ITS QUOTA, AND 'SOCRATES' AND 'PLATON' SHOULD BE LISTED AS ITS STUDENTS:\n");
+    Item loadedCourse = getItem(wrapCourseWithCode("CS50"));
+    printItem(loadedCourse); freeItem(loadedCourse);
+    listStudentsRegisteredForCourse(wrapCourseWithCode("CS50"));
+    printf("######### COUNTERS ARE CALCULATED FROM THE LOADED REGISTRATIONS, SO CHECK SHOULD FIND NO DIFFERENT COUNTERS:\n");
+    checkDatabase(false);
+    printf("\n\n");
+    
+    printf("################################################################################## INTEGRITY CHECK TESTS #########################################################################################\n\n");
+    
+    printf("######################################## CHECKING COUNTERS THAT ARE DIFFERENT FROM THE REGISTRATIONS (SHOULD FIND THEM) ########################################\n");
+    printf("######### COUNTERS OF 'CS50' AND 'ARISTOTELES' ARE OVERWRITTEN WITHOUT THEIR REGISTRATIONS, LIKE A CRASH WITH '--no-wal' COULD LEAVE THEM.\n");
+    Item brokenCourse = getItem(wrapCourseWithCode("CS50")), brokenStudent = getItem(wrapStudentWithStudentNumber(2));
+    Item brokenCourseVersion = brokenCourse, brokenStudentVersion = brokenStudent;
+    brokenCourseVersion.value.course.quota.registered = 1;
+    brokenStudentVersion.value.student.numberOfCoursesRegistered = 1; brokenStudentVersion.value.student.numberOfCreditsTaken = 4;
+    updateCountersOfItem(brokenCourse, brokenCourseVersion); updateCountersOfItem(brokenStudent, brokenStudentVersion);
+    freeItem(brokenCourse); freeItem(brokenStudent);
+    printf("######### 'CS50' SHOULD HAVE 1 REGISTERED STUDENT INSTEAD OF 2, AND STUDENT 2 SHOULD HAVE 1 COURSE AND 4 CREDITS INSTEAD OF 0.\n");
+    printf("######### CHECK SHOULD FIND 2 DIFFERENT COUNTERS, AND SHOULD FIND THEM AGAIN SINCE IT DOESN'T REPAIR THEM:\n");
+    checkDatabase(false);
+    checkDatabase(false);
+    printf("\n\n");
+    
+    printf("######################################## REPAIRING COUNTERS THAT ARE DIFFERENT FROM THE REGISTRATIONS (SHOULD SUCCEED) ########################################\n");
+    printf("######### CHECK SHOULD FIND AND REWRITE 2 DIFFERENT COUNTERS, AND A CHECK AFTER IT SHOULD FIND NO DIFFERENT COUNTERS:\n");
+    checkDatabase(true);
+    checkDatabase(false);
+    printf("\n\n");
 }